@@ -4,14 +4,10 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 CONFIG += c++17
 
-SOURCES += \
-    main.cpp \
-    mainwindow.cpp \
-    game2048.cpp
+include(gui.pri)
 
-HEADERS += \
-    mainwindow.h \
-    game2048.h
+SOURCES += \
+    main.cpp
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
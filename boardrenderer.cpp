@@ -0,0 +1,143 @@
+#include "boardrenderer.h"
+#include "tilestyle.h"
+#include <QPainter>
+
+namespace {
+
+QRectF interpolateRect(const QRectF &from, const QRectF &to, qreal t)
+{
+    return QRectF(from.x() + (to.x() - from.x()) * t,
+                  from.y() + (to.y() - from.y()) * t,
+                  from.width() + (to.width() - from.width()) * t,
+                  from.height() + (to.height() - from.height()) * t);
+}
+
+}
+
+BoardRenderer::BoardRenderer(int imageSize)
+    : m_imageSize(imageSize)
+    , m_outQuad(QEasingCurve::OutQuad)
+    , m_inQuad(QEasingCurve::InQuad)
+{
+    // 四周的边和方块之间的间距相同，与方块边长保持 1:8
+    const int size = BoardState::Size;
+    const int baseImageSize = size * TileStyle::BaseTileSize + (size + 1) * TileStyle::BaseSpacing;
+    m_spacing = imageSize * TileStyle::BaseSpacing / baseImageSize;
+    m_tileSize = qMax(1, (imageSize - (size + 1) * m_spacing) / size);
+    m_origin = (imageSize - (size * m_tileSize + (size - 1) * m_spacing)) / 2.0;
+}
+
+QImage BoardRenderer::createImage() const
+{
+    return QImage(m_imageSize, m_imageSize, QImage::Format_RGB32);
+}
+
+QRectF BoardRenderer::cellRect(int cell) const
+{
+    const int pitch = m_tileSize + m_spacing;
+    return QRectF(m_origin + (cell % BoardState::Size) * pitch, m_origin + (cell / BoardState::Size) * pitch,
+                  m_tileSize, m_tileSize);
+}
+
+const QImage &BoardRenderer::tileImage(int exponent)
+{
+    QImage &image = m_tiles[exponent];
+    if (image.isNull()) {
+        image = QImage(m_tileSize, m_tileSize, QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        painter.setRenderHint(QPainter::Antialiasing);
+        painter.setRenderHint(QPainter::TextAntialiasing);
+        TileStyle::paintTile(&painter, QRectF(0, 0, m_tileSize, m_tileSize), exponent == 0 ? 0 : 1 << exponent);
+    }
+    return image;
+}
+
+void BoardRenderer::paintCells(QPainter *painter, const int *exponents)
+{
+    painter->fillRect(QRect(0, 0, m_imageSize, m_imageSize), TileStyle::boardColor());
+    for (int cell = 0; cell < BoardState::CellCount; ++cell) {
+        painter->drawImage(cellRect(cell).topLeft(), tileImage(exponents[cell]));
+    }
+}
+
+void BoardRenderer::render(BoardState board, QImage *image)
+{
+    if (image->size() != QSize(m_imageSize, m_imageSize)) {
+        *image = createImage();
+    }
+    int exponents[BoardState::CellCount];
+    for (int cell = 0; cell < BoardState::CellCount; ++cell) {
+        exponents[cell] = board.exponentAt(cell);
+    }
+    QPainter painter(image);
+    paintCells(&painter, exponents);
+}
+
+void BoardRenderer::renderMove(BoardState before, const MoveDelta &delta, BoardState after, qreal elapsedMs,
+                               QImage *image)
+{
+    Q_UNUSED(before);
+    if (elapsedMs >= TileStyle::MoveAnimationMs) {
+        render(after, image);
+        return;
+    }
+    if (image->size() != QSize(m_imageSize, m_imageSize)) {
+        *image = createImage();
+    }
+
+    // 格子上的静止方块：离开的位置空出来；滑入、合并和新生成的格子在各自的动画结束前由精灵画出
+    const bool slidesDone = elapsedMs >= TileStyle::SlideDurationMs;
+    const bool spawnDone = elapsedMs >= TileStyle::SpawnDurationMs;
+    int exponents[BoardState::CellCount];
+    for (int cell = 0; cell < BoardState::CellCount; ++cell) {
+        exponents[cell] = after.exponentAt(cell);
+    }
+    for (int i = 0; i < delta.slideCount; ++i) {
+        exponents[delta.slides[i].from] = 0;
+    }
+    for (int i = 0; i < delta.slideCount; ++i) {
+        const MoveDelta::Slide &slide = delta.slides[i];
+        if (!slide.merged) {
+            exponents[slide.to] = slidesDone ? after.exponentAt(slide.to) : 0;
+        }
+    }
+    for (int i = 0; i < delta.mergeCount; ++i) {
+        exponents[delta.merges[i]] = 0;
+    }
+    if (delta.spawnCell >= 0) {
+        exponents[delta.spawnCell] = spawnDone ? after.exponentAt(delta.spawnCell) : 0;
+    }
+
+    QPainter painter(image);
+    paintCells(&painter, exponents);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+
+    // 精灵的顺序与主窗口相同：合并的方块在最下面，上面是滑动的方块，最后是新方块
+    const qreal mergeProgress = elapsedMs / TileStyle::MergeDurationMs;
+    for (int i = 0; i < delta.mergeCount; ++i) {
+        const int cell = delta.merges[i];
+        const QRectF to = cellRect(cell);
+        const qreal grow = TileStyle::BaseMergeGrow * m_tileSize / TileStyle::BaseTileSize;
+        const QRectF from = to.adjusted(-grow, -grow, grow, grow);
+        const QRectF rect = mergeProgress < 0.5
+                          ? interpolateRect(to, from, m_outQuad.valueForProgress(mergeProgress * 2))
+                          : interpolateRect(from, to, m_inQuad.valueForProgress(mergeProgress * 2 - 1));
+        painter.drawImage(rect, tileImage(after.exponentAt(cell)));
+    }
+    if (!slidesDone) {
+        const qreal eased = m_outQuad.valueForProgress(elapsedMs / TileStyle::SlideDurationMs);
+        for (int i = 0; i < delta.slideCount; ++i) {
+            const MoveDelta::Slide &slide = delta.slides[i];
+            painter.drawImage(interpolateRect(cellRect(slide.from), cellRect(slide.to), eased),
+                              tileImage(slide.exponent));
+        }
+    }
+    if (delta.spawnCell >= 0 && !spawnDone) {
+        const qreal eased = m_outQuad.valueForProgress(elapsedMs / TileStyle::SpawnDurationMs);
+        const QRectF to = cellRect(delta.spawnCell);
+        painter.setOpacity(eased);
+        painter.drawImage(interpolateRect(QRectF(to.center(), QSizeF(0, 0)), to, eased),
+                          tileImage(after.exponentAt(delta.spawnCell)));
+    }
+}
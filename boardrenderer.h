@@ -0,0 +1,50 @@
+#ifndef BOARDRENDERER_H
+#define BOARDRENDERER_H
+
+#include <QEasingCurve>
+#include <QImage>
+#include <QRectF>
+#include "boardstate.h"
+#include "movedelta.h"
+
+class QPainter;
+
+// 不需要窗口和事件循环，把 4x4 棋盘画到 QImage 上，用于把对局导出成图像序列。
+// 方块的画法与 BoardWidget 相同（TileStyle），移动的过渡帧按主窗口动画的时长和缓动曲线计算：
+// 方块滑向目标格子，合并的方块先放大再恢复，新方块从格子中心放大并淡入。
+//
+// 每个实例按自己的图像尺寸缓存方块图像，不能同时在多个线程中使用；
+// 并行渲染时每个线程一个实例（QImage 和 QPainter 可以在非界面线程中使用）。
+class BoardRenderer
+{
+public:
+    // 输出 imageSize x imageSize 的图像，棋盘四周留一个间距宽的边
+    explicit BoardRenderer(int imageSize);
+
+    int imageSize() const { return m_imageSize; }
+    // 与 render() 输出格式相同的空图像
+    QImage createImage() const;
+
+    // 静止的局面
+    void render(BoardState board, QImage *image);
+    // 一步移动开始 elapsedMs 毫秒后的画面。delta 为 before 上这一步的记录（包括新方块），
+    // after 为移动并生成新方块后的局面；elapsedMs 不小于 TileStyle::MoveAnimationMs 时与 render(after) 相同
+    void renderMove(BoardState before, const MoveDelta &delta, BoardState after, qreal elapsedMs, QImage *image);
+
+private:
+    QRectF cellRect(int cell) const;
+    const QImage &tileImage(int exponent);
+    // 画出底色和所有格子，exponents 按格子序号给出方块指数
+    void paintCells(QPainter *painter, const int *exponents);
+
+    int m_imageSize;
+    int m_tileSize;
+    int m_spacing;
+    qreal m_origin;
+    // 按指数缓存的方块图像，0 为空格
+    QImage m_tiles[BoardState::MaxExponent + 1];
+    QEasingCurve m_outQuad;
+    QEasingCurve m_inQuad;
+};
+
+#endif // BOARDRENDERER_H
@@ -0,0 +1,206 @@
+#include "boardwidget.h"
+#include "tilestyle.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QtAlgorithms>
+
+namespace {
+
+constexpr int kBaseBoardSize = 4 * TileStyle::BaseTileSize + 3 * TileStyle::BaseSpacing;
+
+}
+
+BoardWidget::BoardWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_boardSize(BoardState::Size)
+    , m_values(BoardState::CellCount, 0)
+    , m_tileSize(TileStyle::BaseTileSize)
+    , m_spacing(TileStyle::BaseSpacing)
+    , m_frameMonitor(nullptr)
+{
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    updateGeometryCache();
+}
+
+void BoardWidget::setBoardSize(int size)
+{
+    if (size == m_boardSize) {
+        return;
+    }
+    m_boardSize = size;
+    m_values.assign(static_cast<std::size_t>(size) * size, 0);
+    hideSprites();
+    updateGeometryCache();
+}
+
+void BoardWidget::setBoard(BoardState board)
+{
+    for (int row = 0; row < BoardState::Size; ++row) {
+        for (int col = 0; col < BoardState::Size; ++col) {
+            setCellValue(row, col, board.tileAt(row, col));
+        }
+    }
+}
+
+void BoardWidget::setCellValue(int row, int col, int value)
+{
+    int &current = m_values[row * m_boardSize + col];
+    if (current == value) {
+        return;
+    }
+    current = value;
+    update(cellRect(row, col));
+}
+
+QRect BoardWidget::cellRect(int row, int col) const
+{
+    return QRect(m_origin.x() + col * (m_tileSize + m_spacing),
+                 m_origin.y() + row * (m_tileSize + m_spacing),
+                 m_tileSize, m_tileSize);
+}
+
+QFont BoardWidget::tileFont() const
+{
+    return TileStyle::font(m_tileSize);
+}
+
+QPixmap BoardWidget::tilePixmap(int value) const
+{
+    const qreal devicePixelRatio = devicePixelRatioF();
+    // 按指数而不是数值做键：大棋盘的方块可以到 2^30，数值会占满低位。
+    // 指数占低 8 位，方块边长占 8 到 39 位，像素比（百分之一）从第 40 位开始，各字段互不重叠
+    const quint64 exponent = value == 0 ? 0 : qCountTrailingZeroBits(quint32(value));
+    const quint64 key = (quint64(qRound(devicePixelRatio * 100)) << 40)
+                      | (quint64(quint32(m_tileSize)) << 8)
+                      | exponent;
+    auto it = m_tileCache.constFind(key);
+    if (it != m_tileCache.constEnd()) {
+        return it.value();
+    }
+    const QPixmap pixmap = renderTile(value, devicePixelRatio);
+    if (m_frameMonitor) {
+        m_frameMonitor->tileRendered();
+    }
+    m_tileCache.insert(key, pixmap);
+    return pixmap;
+}
+
+void BoardWidget::setSprite(int index, int value, const QRectF &rect, qreal opacity)
+{
+    Sprite &sprite = m_sprites[index];
+    if (sprite.visible) {
+        update(sprite.rect.toAlignedRect());
+    }
+    sprite.visible = true;
+    sprite.value = value;
+    sprite.rect = rect;
+    sprite.opacity = opacity;
+    update(rect.toAlignedRect());
+}
+
+void BoardWidget::hideSprite(int index)
+{
+    Sprite &sprite = m_sprites[index];
+    if (sprite.visible) {
+        sprite.visible = false;
+        update(sprite.rect.toAlignedRect());
+    }
+}
+
+void BoardWidget::hideSprites()
+{
+    for (int i = 0; i < MaxSprites; ++i) {
+        hideSprite(i);
+    }
+}
+
+QPixmap BoardWidget::renderTile(int value, qreal devicePixelRatio) const
+{
+    QPixmap pixmap(QSize(m_tileSize, m_tileSize) * devicePixelRatio);
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+
+    TileStyle::paintTile(&painter, QRectF(0, 0, m_tileSize, m_tileSize), value);
+    return pixmap;
+}
+
+QSize BoardWidget::sizeHint() const
+{
+    return QSize(kBaseBoardSize, kBaseBoardSize);
+}
+
+QSize BoardWidget::minimumSizeHint() const
+{
+    return QSize(kBaseBoardSize / 2, kBaseBoardSize / 2);
+}
+
+void BoardWidget::paintEvent(QPaintEvent *event)
+{
+    const qint64 paintStart = m_frameMonitor ? m_frameMonitor->now() : 0;
+    QPainter painter(this);
+    const QRect dirty = event->rect();
+    
+    // 只遍历与重绘区域相交的行和列，大棋盘局部更新时不必扫描所有格子
+    const int pitch = m_tileSize + m_spacing;
+    const int firstRow = qMax(0, (dirty.top() - m_origin.y()) / pitch);
+    const int lastRow = qMin(m_boardSize - 1, (dirty.bottom() - m_origin.y()) / pitch);
+    const int firstCol = qMax(0, (dirty.left() - m_origin.x()) / pitch);
+    const int lastCol = qMin(m_boardSize - 1, (dirty.right() - m_origin.x()) / pitch);
+    for (int row = firstRow; row <= lastRow; ++row) {
+        for (int col = firstCol; col <= lastCol; ++col) {
+            const QRect rect = cellRect(row, col);
+            if (rect.intersects(dirty)) {
+                painter.drawPixmap(rect.topLeft(), tilePixmap(m_values[row * m_boardSize + col]));
+            }
+        }
+    }
+
+    // 精灵的大小可能与格子不同（缩放动画），需要平滑缩放
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    for (const Sprite &sprite : m_sprites) {
+        if (!sprite.visible || !sprite.rect.toAlignedRect().intersects(dirty)) {
+            continue;
+        }
+        painter.setOpacity(sprite.opacity);
+        painter.drawPixmap(sprite.rect, tilePixmap(sprite.value), QRectF());
+    }
+    painter.end();
+
+    if (m_frameMonitor) {
+        m_frameMonitor->framePainted(paintStart);
+    }
+}
+
+void BoardWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    updateGeometryCache();
+}
+
+void BoardWidget::updateGeometryCache()
+{
+    // 间距与方块边长保持原来 1:8 的比例；大棋盘的间距可以为 0
+    const int size = m_boardSize;
+    const int available = qMax(1, qMin(width(), height()));
+    const int baseBoardSize = size * TileStyle::BaseTileSize + (size - 1) * TileStyle::BaseSpacing;
+    const int spacing = available * TileStyle::BaseSpacing / baseBoardSize;
+    const int tileSize = qMax(1, (available - (size - 1) * spacing) / size);
+
+    if (tileSize != m_tileSize) {
+        // 旧尺寸的图像不会再用到
+        m_tileCache.clear();
+    }
+    m_tileSize = tileSize;
+    m_spacing = spacing;
+
+    const int boardSize = size * m_tileSize + (size - 1) * m_spacing;
+    m_origin = QPoint((width() - boardSize) / 2, (height() - boardSize) / 2);
+    if (m_frameMonitor) {
+        m_frameMonitor->geometryRecomputed();
+    }
+    update();
+}
@@ -0,0 +1,88 @@
+#ifndef BOARDWIDGET_H
+#define BOARDWIDGET_H
+
+#include <QWidget>
+#include <QHash>
+#include <QPixmap>
+#include <QFont>
+#include <vector>
+#include "boardstate.h"
+#include "movedelta.h"
+#include "framemonitor.h"
+
+// 自绘的棋盘：一个控件画出全部格子，代替每格一个使用样式表的 QLabel。
+// 每种数值的方块只渲染一次，按 (指数, 边长, 设备像素比) 缓存为 QPixmap；
+// 局面变化时只重绘数值改变的格子。窗口缩放时方块等比例缩放。
+// 棋盘边长可以改变，大棋盘的方块太小时不画数字。
+//
+// 动画中的方块是画在格子上面的“精灵”：数量固定，按序号绘制（序号大的在上层），
+// 移动时只重绘精灵新旧位置覆盖的区域。
+class BoardWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    // 有动画的棋盘（不超过 6x6）一步最多的滑动、合并和新方块数
+    static constexpr int MaxSprites = MoveDelta::MaxCells + MoveDelta::MaxCells / 2 + 1;
+
+    explicit BoardWidget(QWidget *parent = nullptr);
+
+    // 改变棋盘边长，所有格子清空
+    void setBoardSize(int size);
+    int boardSize() const { return m_boardSize; }
+
+    // 显示新的 4x4 局面，只重绘变化的格子
+    void setBoard(BoardState board);
+    // 单独修改一个格子显示的数值（动画期间临时隐藏或提前显示方块）
+    void setCellValue(int row, int col, int value);
+    int cellValue(int row, int col) const { return m_values[row * m_boardSize + col]; }
+
+    // 格子在本控件坐标系中的位置
+    QRect cellRect(int row, int col) const;
+    // 按当前方块大小缩放后的数字字体
+    QFont tileFont() const;
+    // 当前大小和像素比下的方块图像
+    QPixmap tilePixmap(int value) const;
+
+    // 在 rect 处（可以与格子大小不同）以给定不透明度画出数值为 value 的方块
+    void setSprite(int index, int value, const QRectF &rect, qreal opacity = 1.0);
+    void hideSprite(int index);
+    void hideSprites();
+
+    // 绘制时间、方块渲染和几何重算计入 monitor（可以为空）
+    void setFrameMonitor(FrameMonitor *monitor) { m_frameMonitor = monitor; }
+
+    QSize sizeHint() const override;
+    QSize minimumSizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    struct Sprite
+    {
+        bool visible = false;
+        int value = 0;
+        QRectF rect;
+        qreal opacity = 1.0;
+    };
+
+    void updateGeometryCache();
+    QPixmap renderTile(int value, qreal devicePixelRatio) const;
+
+    int m_boardSize;
+    // 行优先的格子数值
+    std::vector<int> m_values;
+    Sprite m_sprites[MaxSprites];
+
+    // 方块边长和间距（逻辑像素），整个棋盘在控件内居中
+    int m_tileSize;
+    int m_spacing;
+    QPoint m_origin;
+
+    mutable QHash<quint64, QPixmap> m_tileCache;
+    FrameMonitor *m_frameMonitor;
+};
+
+#endif // BOARDWIDGET_H
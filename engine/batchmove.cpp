@@ -0,0 +1,269 @@
+#include "batchmove.h"
+#include "movetables.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BATCHMOVE_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang 不需要全局的 -mavx2：只给向量化的函数打开对应指令集，是否调用由运行时检测决定
+#if defined(BATCHMOVE_X86) && (defined(__GNUC__) || defined(__clang__))
+#define BATCHMOVE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define BATCHMOVE_TARGET(isa)
+#endif
+
+namespace {
+
+using Direction = BoardState::Direction;
+
+inline void markChanged(std::uint64_t *changed, std::size_t index, std::uint64_t bits)
+{
+    changed[index / 64] |= bits << (index % 64);
+}
+
+void moveScalar(Direction direction, const std::uint64_t *boards, std::size_t begin, std::size_t count,
+                std::uint64_t *out, std::uint32_t *scoreDeltas, std::uint64_t *changed)
+{
+    for (std::size_t i = begin; i < count; ++i) {
+        const BoardState before(boards[i]);
+        int gained = 0;
+        const BoardState after = before.moved(direction, &gained);
+        out[i] = after.bits();
+        scoreDeltas[i] = static_cast<std::uint32_t>(gained);
+        markChanged(changed, i, after != before ? 1 : 0);
+    }
+}
+
+#if defined(BATCHMOVE_X86)
+
+// 与 BoardState::transposed() 相同的位运算，每个 64 位通道一个棋盘
+BATCHMOVE_TARGET("sse4.1")
+inline __m128i transposed128(__m128i x)
+{
+    const __m128i a1 = _mm_and_si128(x, _mm_set1_epi64x(static_cast<long long>(0xF0F00F0FF0F00F0FULL)));
+    const __m128i a2 = _mm_and_si128(x, _mm_set1_epi64x(0x0000F0F00000F0F0LL));
+    const __m128i a3 = _mm_and_si128(x, _mm_set1_epi64x(0x0F0F00000F0F0000LL));
+    const __m128i a = _mm_or_si128(a1, _mm_or_si128(_mm_slli_epi64(a2, 12), _mm_srli_epi64(a3, 12)));
+    const __m128i b1 = _mm_and_si128(a, _mm_set1_epi64x(static_cast<long long>(0xFF00FF0000FF00FFULL)));
+    const __m128i b2 = _mm_and_si128(a, _mm_set1_epi64x(0x00FF00FF00000000LL));
+    const __m128i b3 = _mm_and_si128(a, _mm_set1_epi64x(0x00000000FF00FF00LL));
+    return _mm_or_si128(b1, _mm_or_si128(_mm_srli_epi64(b2, 24), _mm_slli_epi64(b3, 24)));
+}
+
+BATCHMOVE_TARGET("avx2")
+inline __m256i transposed256(__m256i x)
+{
+    const __m256i a1 = _mm256_and_si256(x, _mm256_set1_epi64x(static_cast<long long>(0xF0F00F0FF0F00F0FULL)));
+    const __m256i a2 = _mm256_and_si256(x, _mm256_set1_epi64x(0x0000F0F00000F0F0LL));
+    const __m256i a3 = _mm256_and_si256(x, _mm256_set1_epi64x(0x0F0F00000F0F0000LL));
+    const __m256i a = _mm256_or_si256(a1, _mm256_or_si256(_mm256_slli_epi64(a2, 12), _mm256_srli_epi64(a3, 12)));
+    const __m256i b1 = _mm256_and_si256(a, _mm256_set1_epi64x(static_cast<long long>(0xFF00FF0000FF00FFULL)));
+    const __m256i b2 = _mm256_and_si256(a, _mm256_set1_epi64x(0x00FF00FF00000000LL));
+    const __m256i b3 = _mm256_and_si256(a, _mm256_set1_epi64x(0x00000000FF00FF00LL));
+    return _mm256_or_si256(b1, _mm256_or_si256(_mm256_srli_epi64(b2, 24), _mm256_slli_epi64(b3, 24)));
+}
+
+inline std::uint64_t lookupRows(std::uint64_t source, const std::uint16_t *rowTable, const std::uint32_t *scoreTable,
+                                std::uint32_t *score)
+{
+    std::uint64_t result = 0;
+    std::uint32_t gained = 0;
+    for (int row = 0; row < BoardState::Size; ++row) {
+        const std::uint16_t bits = static_cast<std::uint16_t>(source >> (16 * row));
+        result |= std::uint64_t(rowTable[bits]) << (16 * row);
+        gained += scoreTable[bits];
+    }
+    *score = gained;
+    return result;
+}
+
+// 每次 2 个棋盘，返回处理到的位置
+BATCHMOVE_TARGET("sse4.1")
+std::size_t moveSse41(Direction direction, const std::uint64_t *boards, std::size_t count, std::uint64_t *out,
+                      std::uint32_t *scoreDeltas, std::uint64_t *changed)
+{
+    const RowMoveTables &tables = rowMoveTables();
+    const bool vertical = direction == Direction::Up || direction == Direction::Down;
+    const bool towardsLow = direction == Direction::Up || direction == Direction::Left;
+    const std::uint16_t *rowTable = towardsLow ? tables.left : tables.right;
+    const std::uint32_t *scoreTable = towardsLow ? tables.leftScore : tables.rightScore;
+
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        const __m128i before = _mm_loadu_si128(reinterpret_cast<const __m128i *>(boards + i));
+        const __m128i source = vertical ? transposed128(before) : before;
+
+        std::uint32_t score0 = 0;
+        std::uint32_t score1 = 0;
+        const std::uint64_t row0 = lookupRows(static_cast<std::uint64_t>(_mm_cvtsi128_si64(source)),
+                                              rowTable, scoreTable, &score0);
+        const std::uint64_t row1 = lookupRows(static_cast<std::uint64_t>(_mm_extract_epi64(source, 1)),
+                                              rowTable, scoreTable, &score1);
+        __m128i result = _mm_set_epi64x(static_cast<long long>(row1), static_cast<long long>(row0));
+        if (vertical) {
+            result = transposed128(result);
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), result);
+        scoreDeltas[i] = score0;
+        scoreDeltas[i + 1] = score1;
+        const int same = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(result, before)));
+        markChanged(changed, i, static_cast<std::uint64_t>(~same & 0x3));
+    }
+    return i;
+}
+
+// 每次 4 个棋盘。每个 32 位通道是一个棋盘相邻的两行（第 0、1 行或第 2、3 行），
+// evenRows 取每个通道的低 16 位（第 0、2 行），oddRows 取高 16 位（第 1、3 行），一条 gather 指令查 8 行。
+// gather 按 32 位读取 16 位的行表，最后一项会多读 2 字节，落在 RowMoveTables 中紧随其后的表里，不会越界。
+// 这依赖成员的排列顺序，调整 RowMoveTables 时由下面的断言提醒。
+static_assert(offsetof(RowMoveTables, right) == offsetof(RowMoveTables, left) + sizeof(RowMoveTables::left)
+                  && offsetof(RowMoveTables, leftScore) == offsetof(RowMoveTables, right) + sizeof(RowMoveTables::right),
+              "moveAvx2 reads 2 bytes past left[] and right[]");
+
+BATCHMOVE_TARGET("avx2")
+std::size_t moveAvx2(Direction direction, const std::uint64_t *boards, std::size_t count, std::uint64_t *out,
+                     std::uint32_t *scoreDeltas, std::uint64_t *changed)
+{
+    const RowMoveTables &tables = rowMoveTables();
+    const bool vertical = direction == Direction::Up || direction == Direction::Down;
+    const bool towardsLow = direction == Direction::Up || direction == Direction::Left;
+    const int *rowTable = reinterpret_cast<const int *>(towardsLow ? tables.left : tables.right);
+    const int *scoreTable = reinterpret_cast<const int *>(towardsLow ? tables.leftScore : tables.rightScore);
+
+    const __m256i rowMask = _mm256_set1_epi32(0xFFFF);
+    // 把每个 64 位通道低 32 位的得分收拢到低 128 位
+    const __m256i packScores = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m256i before = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(boards + i));
+        const __m256i source = vertical ? transposed256(before) : before;
+
+        const __m256i evenRows = _mm256_and_si256(source, rowMask);
+        const __m256i oddRows = _mm256_srli_epi32(source, 16);
+        const __m256i evenMoved = _mm256_and_si256(_mm256_i32gather_epi32(rowTable, evenRows, 2), rowMask);
+        const __m256i oddMoved = _mm256_slli_epi32(_mm256_i32gather_epi32(rowTable, oddRows, 2), 16);
+        __m256i result = _mm256_or_si256(evenMoved, oddMoved);
+        if (vertical) {
+            result = transposed256(result);
+        }
+
+        __m256i scores = _mm256_add_epi32(_mm256_i32gather_epi32(scoreTable, evenRows, 4),
+                                          _mm256_i32gather_epi32(scoreTable, oddRows, 4));
+        scores = _mm256_add_epi32(scores, _mm256_srli_epi64(scores, 32));
+        scores = _mm256_permutevar8x32_epi32(scores, packScores);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), result);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(scoreDeltas + i), _mm256_castsi256_si128(scores));
+        const int same = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(result, before)));
+        markChanged(changed, i, static_cast<std::uint64_t>(~same & 0xF));
+    }
+    return i;
+}
+
+bool cpuSupports(BatchMover::Kernel kernel)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse41 = (info[2] & (1 << 19)) != 0;
+    if (kernel == BatchMover::Kernel::Sse41) {
+        return sse41;
+    }
+    // AVX2 还需要操作系统保存 YMM 寄存器
+    const bool osxsave = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0;
+    if (!osxsave || maxLeaf < 7 || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    if (kernel == BatchMover::Kernel::Sse41) {
+        return __builtin_cpu_supports("sse4.1");
+    }
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+}
+
+BatchMover::BatchMover()
+    : m_kernel(bestKernel())
+{
+}
+
+bool BatchMover::setKernel(Kernel kernel)
+{
+    if (!isSupported(kernel)) {
+        return false;
+    }
+    m_kernel = kernel;
+    return true;
+}
+
+BatchMover::Kernel BatchMover::bestKernel()
+{
+    static const Kernel best = isSupported(Kernel::Avx2) ? Kernel::Avx2
+                             : isSupported(Kernel::Sse41) ? Kernel::Sse41
+                                                          : Kernel::Scalar;
+    return best;
+}
+
+bool BatchMover::isSupported(Kernel kernel)
+{
+    if (kernel == Kernel::Scalar) {
+        return true;
+    }
+#if defined(BATCHMOVE_X86)
+    return cpuSupports(kernel);
+#else
+    return false;
+#endif
+}
+
+const char *BatchMover::kernelName(Kernel kernel)
+{
+    switch (kernel) {
+    case Kernel::Scalar: return "scalar";
+    case Kernel::Sse41: return "sse4.1";
+    case Kernel::Avx2: return "avx2";
+    }
+    return "unknown";
+}
+
+void BatchMover::move(Direction direction, const std::uint64_t *boards, std::size_t count, std::uint64_t *out,
+                      std::uint32_t *scoreDeltas, std::uint64_t *changed) const
+{
+    for (std::size_t word = 0; word < (count + 63) / 64; ++word) {
+        changed[word] = 0;
+    }
+
+    // 向量实现处理整组，剩下不足一组的棋盘走标量
+    std::size_t done = 0;
+#if defined(BATCHMOVE_X86)
+    if (m_kernel == Kernel::Avx2) {
+        done = moveAvx2(direction, boards, count, out, scoreDeltas, changed);
+    } else if (m_kernel == Kernel::Sse41) {
+        done = moveSse41(direction, boards, count, out, scoreDeltas, changed);
+    }
+#endif
+    moveScalar(direction, boards, done, count, out, scoreDeltas, changed);
+}
+
+void BatchMover::move(Direction direction, BoardBatch *batch) const
+{
+    batch->scoreDeltas.resize(batch->boards.size());
+    batch->changed.resize((batch->boards.size() + 63) / 64);
+    move(direction, batch->boards.data(), batch->boards.size(), batch->boards.data(), batch->scoreDeltas.data(),
+         batch->changed.data());
+}
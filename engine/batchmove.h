@@ -0,0 +1,69 @@
+#ifndef BATCHMOVE_H
+#define BATCHMOVE_H
+
+#include "boardstate.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 一批互相独立的 4x4 对局，按结构数组（SoA）存放：棋盘、得分增量和变化标记各占一个连续数组，
+// 同一方向的移动可以一次处理多个棋盘。
+struct BoardBatch
+{
+    // 第 i 局的位棋盘（BoardState::bits()）
+    std::vector<std::uint64_t> boards;
+    // 最近一次批量移动中第 i 局的合并得分
+    std::vector<std::uint32_t> scoreDeltas;
+    // 最近一次批量移动中第 i 局是否变化：第 i / 64 个字的第 i % 64 位
+    std::vector<std::uint64_t> changed;
+
+    void resize(std::size_t count)
+    {
+        boards.resize(count);
+        scoreDeltas.resize(count);
+        changed.resize((count + 63) / 64);
+    }
+    std::size_t size() const { return boards.size(); }
+    bool isChanged(std::size_t index) const { return (changed[index / 64] >> (index % 64)) & 1; }
+};
+
+// 批量移动：对每个棋盘的结果、得分和“是否变化”与 BoardState::moved()（即 GameCore::move()
+// 在生成新方块之前的部分）完全一致。新方块依赖每局自己的随机数，由调用方生成。
+//
+// 运行时按 CPU 选择实现：AVX2 一次处理 4 个棋盘（转置、比较用向量指令，查表用 gather），
+// SSE4.1 一次处理 2 个棋盘（向量化转置和比较，查表仍是标量），否则逐个调用 BoardState::moved()。
+class BatchMover
+{
+public:
+    using Direction = BoardState::Direction;
+
+    enum class Kernel {
+        Scalar,
+        Sse41,
+        Avx2
+    };
+
+    // 默认使用当前 CPU 支持的最快实现
+    BatchMover();
+
+    // 选择的实现不受支持时返回 false，保持原来的设置
+    bool setKernel(Kernel kernel);
+    Kernel kernel() const { return m_kernel; }
+
+    static Kernel bestKernel();
+    static bool isSupported(Kernel kernel);
+    static const char *kernelName(Kernel kernel);
+
+    // 把 direction 应用到 boards[0, count)，结果写入 out（可以与 boards 相同）。
+    // scoreDeltas[i] 为第 i 个棋盘的合并得分；changed 至少有 (count + 63) / 64 个字，按位记录是否变化。
+    void move(Direction direction, const std::uint64_t *boards, std::size_t count, std::uint64_t *out,
+              std::uint32_t *scoreDeltas, std::uint64_t *changed) const;
+    // 原地移动整批棋盘
+    void move(Direction direction, BoardBatch *batch) const;
+
+private:
+    Kernel m_kernel;
+};
+
+#endif // BATCHMOVE_H
@@ -0,0 +1,337 @@
+#include "boardengine.h"
+#include "workstealingpool.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// 第 line 行（列）沿移动方向排列：第 i 个格子是 start + i * step，i = 0 最靠边
+inline void lineLayout(BoardState::Direction direction, int line, int size, int *start, int *step)
+{
+    switch (direction) {
+    case BoardState::Direction::Up:
+        *start = line;
+        *step = size;
+        break;
+    case BoardState::Direction::Down:
+        *start = (size - 1) * size + line;
+        *step = -size;
+        break;
+    case BoardState::Direction::Left:
+        *start = line * size;
+        *step = 1;
+        break;
+    case BoardState::Direction::Right:
+        *start = line * size + size - 1;
+        *step = -1;
+        break;
+    }
+}
+
+// 把一行（列）按“移动-合并-再移动”规则一次扫描完成，结果写入 out[0, length)，返回这一行是否变化。
+// length 是编译期常量时（FixedBoardEngine）内联后循环会被完全展开。
+inline bool slideLine(const std::uint8_t *cells, int start, int step, int length, std::uint8_t *out,
+                      std::int64_t *score, int *merges, MoveDelta *delta)
+{
+    // target 是下一个方块落下的位置；pending 表示 target - 1 处的方块还可以被合并
+    int target = 0;
+    bool pending = false;
+    int pendingExponent = 0;
+    bool changed = false;
+
+    for (int i = 0; i < length; ++i) {
+        const int exponent = cells[start + i * step];
+        if (exponent == 0) {
+            continue;
+        }
+
+        int to;
+        bool merged = false;
+        if (pending && exponent == pendingExponent && exponent < BoardEngine::MaxExponent) {
+            to = target - 1;
+            merged = true;
+            pending = false;
+            out[to] = static_cast<std::uint8_t>(exponent + 1);
+            *score += 1 << (exponent + 1);
+            ++*merges;
+            if (delta) {
+                delta->merges[delta->mergeCount++] = static_cast<std::uint8_t>(start + to * step);
+            }
+        } else {
+            to = target++;
+            pending = true;
+            pendingExponent = exponent;
+            out[to] = static_cast<std::uint8_t>(exponent);
+        }
+
+        if (i != to) {
+            changed = true;
+            if (delta) {
+                MoveDelta::Slide &slide = delta->slides[delta->slideCount++];
+                slide.from = static_cast<std::uint8_t>(start + i * step);
+                slide.to = static_cast<std::uint8_t>(start + to * step);
+                slide.exponent = static_cast<std::uint8_t>(exponent);
+                slide.merged = merged;
+            }
+        }
+    }
+    for (int i = target; i < length; ++i) {
+        out[i] = 0;
+    }
+    return changed;
+}
+
+// 存在空格子或相邻的可合并方块
+inline bool cellsCanMove(const std::uint8_t *cells, int size)
+{
+    for (int row = 0; row < size; ++row) {
+        const std::uint8_t *line = cells + row * size;
+        for (int col = 0; col < size; ++col) {
+            const int exponent = line[col];
+            if (exponent == 0) {
+                return true;
+            }
+            if (exponent < BoardEngine::MaxExponent) {
+                if (col + 1 < size && line[col + 1] == exponent) {
+                    return true;
+                }
+                if (row + 1 < size && line[col + size] == exponent) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+}
+
+std::unique_ptr<BoardEngine> BoardEngine::create(int size, int threadCount)
+{
+    switch (size) {
+    case 2: return std::unique_ptr<BoardEngine>(new FixedBoardEngine<2>);
+    case 3: return std::unique_ptr<BoardEngine>(new FixedBoardEngine<3>);
+    case 5: return std::unique_ptr<BoardEngine>(new FixedBoardEngine<5>);
+    case 6: return std::unique_ptr<BoardEngine>(new FixedBoardEngine<6>);
+    default:
+        break;
+    }
+    if (size <= MaxFixedSize || size > MaxSize) {
+        return nullptr;
+    }
+    return std::unique_ptr<BoardEngine>(new LargeBoardEngine(size, threadCount));
+}
+
+bool BoardEngine::moveCells(const std::uint8_t *cells, int size, Direction direction, std::uint8_t *out,
+                            std::int64_t *scoreDelta)
+{
+    std::int64_t score = 0;
+    int merges = 0;
+    bool changed = false;
+    std::uint8_t line[MaxSize];
+    for (int index = 0; index < size; ++index) {
+        int start = 0;
+        int step = 1;
+        lineLayout(direction, index, size, &start, &step);
+        changed |= slideLine(cells, start, step, size, line, &score, &merges, nullptr);
+        for (int i = 0; i < size; ++i) {
+            out[start + i * step] = line[i];
+        }
+    }
+    if (scoreDelta) {
+        *scoreDelta = score;
+    }
+    return changed;
+}
+
+void BoardEngine::clear()
+{
+    std::memset(m_cells, 0, static_cast<std::size_t>(cellCount()));
+}
+
+int BoardEngine::emptyCount() const
+{
+    const int count = cellCount();
+    return static_cast<int>(std::count(m_cells, m_cells + count, std::uint8_t(0)));
+}
+
+int BoardEngine::nthEmptyCell(int n) const
+{
+    const int count = cellCount();
+    for (int cell = 0; cell < count; ++cell) {
+        if (m_cells[cell] == 0 && n-- == 0) {
+            return cell;
+        }
+    }
+    return -1;
+}
+
+int BoardEngine::maxExponent() const
+{
+    return *std::max_element(m_cells, m_cells + cellCount());
+}
+
+template <int N>
+bool FixedBoardEngine<N>::move(Direction direction, std::int64_t *scoreDelta, MoveDelta *delta)
+{
+    if (N * N > MoveDelta::MaxCells) {
+        delta = nullptr;
+    }
+    if (delta) {
+        delta->clear();
+        delta->direction = direction;
+    }
+
+    std::int64_t score = 0;
+    int merges = 0;
+    bool changed = false;
+    for (int line = 0; line < N; ++line) {
+        int start = 0;
+        int step = 1;
+        lineLayout(direction, line, N, &start, &step);
+        std::uint8_t out[N];
+        if (slideLine(m_storage, start, step, N, out, &score, &merges, delta)) {
+            changed = true;
+            for (int i = 0; i < N; ++i) {
+                m_storage[start + i * step] = out[i];
+            }
+        }
+    }
+
+    if (delta) {
+        delta->scoreDelta = score;
+    }
+    if (scoreDelta) {
+        *scoreDelta = score;
+    }
+    return changed;
+}
+
+template <int N>
+bool FixedBoardEngine<N>::previewMove(Direction direction, std::int64_t *scoreDelta, int *emptyAfter) const
+{
+    std::int64_t score = 0;
+    int merges = 0;
+    bool changed = false;
+    for (int line = 0; line < N; ++line) {
+        int start = 0;
+        int step = 1;
+        lineLayout(direction, line, N, &start, &step);
+        std::uint8_t out[N];
+        changed |= slideLine(m_storage, start, step, N, out, &score, &merges, nullptr);
+    }
+
+    if (scoreDelta) {
+        *scoreDelta = score;
+    }
+    if (emptyAfter) {
+        // 每次合并空出一个格子
+        *emptyAfter = emptyCount() + merges;
+    }
+    return changed;
+}
+
+template <int N>
+bool FixedBoardEngine<N>::canMove() const
+{
+    return cellsCanMove(m_storage, N);
+}
+
+template class FixedBoardEngine<2>;
+template class FixedBoardEngine<3>;
+template class FixedBoardEngine<5>;
+template class FixedBoardEngine<6>;
+
+LargeBoardEngine::LargeBoardEngine(int size, int threadCount)
+    : BoardEngine(size, nullptr)
+    , m_threadCount(threadCount)
+{
+    m_storage.assign(static_cast<std::size_t>(size) * size, 0);
+    m_cells = m_storage.data();
+}
+
+LargeBoardEngine::~LargeBoardEngine() = default;
+
+LargeBoardEngine::LineResult LargeBoardEngine::moveLines(Direction direction, std::uint8_t *target) const
+{
+    const int size = m_size;
+    const std::uint8_t *cells = m_cells;
+    auto moveRange = [size, cells, target, direction](std::size_t begin, std::size_t end, std::uint8_t *out,
+                                                      LineResult *result) {
+        for (std::size_t line = begin; line < end; ++line) {
+            int start = 0;
+            int step = 1;
+            lineLayout(direction, static_cast<int>(line), size, &start, &step);
+            if (slideLine(cells, start, step, size, out, &result->score, &result->merges, nullptr)) {
+                result->changed = true;
+                if (target) {
+                    for (int i = 0; i < size; ++i) {
+                        target[start + i * step] = out[i];
+                    }
+                }
+            }
+        }
+    };
+
+    if (m_size < ParallelMinSize || m_threadCount == 1) {
+        if (m_workerLines.empty()) {
+            m_workerLines.resize(1, std::vector<std::uint8_t>(static_cast<std::size_t>(size)));
+        }
+        LineResult result;
+        moveRange(0, static_cast<std::size_t>(size), m_workerLines[0].data(), &result);
+        return result;
+    }
+
+    // 各行（列）互不相交，可以由不同线程同时读写
+    if (!m_pool) {
+        m_pool.reset(new WorkStealingPool(m_threadCount));
+        m_workerLines.assign(static_cast<std::size_t>(m_pool->threadCount()),
+                             std::vector<std::uint8_t>(static_cast<std::size_t>(size)));
+        m_workerResults.resize(static_cast<std::size_t>(m_pool->threadCount()));
+    }
+    std::fill(m_workerResults.begin(), m_workerResults.end(), LineResult());
+    const std::size_t batch = std::max<std::size_t>(1, static_cast<std::size_t>(size) / (4 * m_pool->threadCount()));
+    m_pool->run(static_cast<std::size_t>(size), batch, [this, &moveRange](int worker, std::size_t begin, std::size_t end) {
+        moveRange(begin, end, m_workerLines[worker].data(), &m_workerResults[worker]);
+    });
+
+    LineResult result;
+    for (const LineResult &partial : m_workerResults) {
+        result.score += partial.score;
+        result.merges += partial.merges;
+        result.changed = result.changed || partial.changed;
+    }
+    return result;
+}
+
+bool LargeBoardEngine::move(Direction direction, std::int64_t *scoreDelta, MoveDelta *delta)
+{
+    // 大棋盘的方块去向不做记录
+    if (delta) {
+        delta->clear();
+        delta->direction = direction;
+    }
+    const LineResult result = moveLines(direction, m_cells);
+    if (scoreDelta) {
+        *scoreDelta = result.score;
+    }
+    return result.changed;
+}
+
+bool LargeBoardEngine::previewMove(Direction direction, std::int64_t *scoreDelta, int *emptyAfter) const
+{
+    const LineResult result = moveLines(direction, nullptr);
+    if (scoreDelta) {
+        *scoreDelta = result.score;
+    }
+    if (emptyAfter) {
+        *emptyAfter = emptyCount() + result.merges;
+    }
+    return result.changed;
+}
+
+bool LargeBoardEngine::canMove() const
+{
+    return cellsCanMove(m_cells, m_size);
+}
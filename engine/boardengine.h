@@ -0,0 +1,120 @@
+#ifndef BOARDENGINE_H
+#define BOARDENGINE_H
+
+#include "boardstate.h"
+#include "movedelta.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class WorkStealingPool;
+
+// 4x4 以外棋盘的移动规则。4x4 仍然使用 BoardState 位棋盘和查表移动；其他大小每格用一个字节
+// 保存方块指数（行优先，第 row 行第 col 列是第 row * size + col 格）。
+//
+//   - 2x2 到 6x6：FixedBoardEngine<N>，大小是编译期常量，逐行移动的循环可以被完全展开；
+//   - 更大的棋盘：LargeBoardEngine，格子存放在一块连续内存中，
+//     棋盘足够大时各行（列）分配到线程池并行移动。
+class BoardEngine
+{
+public:
+    using Direction = BoardState::Direction;
+
+    // 指数限制在 30 以内，保证单个方块的数值不会溢出 int。
+    // 最大 4096x4096 的棋盘一步合并的得分和整局的总分都可能超过 int，所以得分一律用 std::int64_t
+    static constexpr int MaxExponent = 30;
+    static constexpr int MinSize = 2;
+    static constexpr int MaxSize = 4096;
+    // 不超过这个大小的棋盘使用编译期特化的实现
+    static constexpr int MaxFixedSize = 6;
+
+    virtual ~BoardEngine() = default;
+
+    // size 不在 [MinSize, MaxSize] 内或等于 4（应使用 BoardState）时返回 nullptr。
+    // threadCount 只影响大棋盘的并行移动，0 表示使用硬件线程数。
+    static std::unique_ptr<BoardEngine> create(int size, int threadCount = 0);
+
+    // 不需要引擎实例的移动：把 size x size 的 cells 移动后写入 out（不能与 cells 相同），返回棋盘是否变化
+    static bool moveCells(const std::uint8_t *cells, int size, Direction direction, std::uint8_t *out,
+                          std::int64_t *scoreDelta);
+
+    int size() const { return m_size; }
+    int cellCount() const { return m_size * m_size; }
+
+    int exponentAt(int cell) const { return m_cells[cell]; }
+    void setExponent(int cell, int exponent) { m_cells[cell] = static_cast<std::uint8_t>(exponent); }
+    void clear();
+
+    int emptyCount() const;
+    // 第 n 个（从 0 开始，按格子序号排列）空格子的格子序号，n 必须小于 emptyCount()
+    int nthEmptyCell(int n) const;
+    int maxExponent() const;
+
+    // 执行移动，返回棋盘是否变化。delta 非空且棋盘不超过 MoveDelta::MaxCells 格时记录每个方块的去向。
+    virtual bool move(Direction direction, std::int64_t *scoreDelta, MoveDelta *delta) = 0;
+    // 不修改棋盘，只计算移动能否改变棋盘、得分和移动后的空格数
+    virtual bool previewMove(Direction direction, std::int64_t *scoreDelta, int *emptyAfter) const = 0;
+    virtual bool canMove() const = 0;
+
+protected:
+    BoardEngine(int size, std::uint8_t *cells) : m_size(size), m_cells(cells) {}
+
+    BoardEngine(const BoardEngine &) = delete;
+    BoardEngine &operator=(const BoardEngine &) = delete;
+
+    const int m_size;
+    // 指向派生类中的格子存储
+    std::uint8_t *m_cells;
+};
+
+// 编译期确定大小的小棋盘
+template <int N>
+class FixedBoardEngine : public BoardEngine
+{
+public:
+    FixedBoardEngine() : BoardEngine(N, m_storage), m_storage() {}
+
+    bool move(Direction direction, std::int64_t *scoreDelta, MoveDelta *delta) override;
+    bool previewMove(Direction direction, std::int64_t *scoreDelta, int *emptyAfter) const override;
+    bool canMove() const override;
+
+private:
+    std::uint8_t m_storage[N * N];
+};
+
+// 任意大小的大棋盘
+class LargeBoardEngine : public BoardEngine
+{
+public:
+    // 至少有这么多行时才把移动分配到线程池；更小的棋盘串行移动比唤醒线程更快
+    static constexpr int ParallelMinSize = 128;
+
+    explicit LargeBoardEngine(int size, int threadCount = 0);
+    ~LargeBoardEngine() override;
+
+    bool move(Direction direction, std::int64_t *scoreDelta, MoveDelta *delta) override;
+    bool previewMove(Direction direction, std::int64_t *scoreDelta, int *emptyAfter) const override;
+    bool canMove() const override;
+
+private:
+    // 每个工作线程的移动结果，对齐到缓存行避免伪共享
+    struct alignas(64) LineResult
+    {
+        std::int64_t score = 0;
+        int merges = 0;
+        bool changed = false;
+    };
+
+    // 逐行移动；target 非空时把结果写入 target（可以就是棋盘本身），为空时只统计
+    LineResult moveLines(Direction direction, std::uint8_t *target) const;
+
+    std::vector<std::uint8_t> m_storage;
+    int m_threadCount;
+    // 首次并行移动时创建
+    mutable std::unique_ptr<WorkStealingPool> m_pool;
+    mutable std::vector<LineResult> m_workerResults;
+    mutable std::vector<std::vector<std::uint8_t>> m_workerLines;
+};
+
+#endif // BOARDENGINE_H
@@ -0,0 +1,216 @@
+#include "boardstate.h"
+#include "movetables.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+
+constexpr std::uint64_t kNibbleLowBits = 0x1111111111111111ULL;
+// 每行前三列（可以和右边相邻格子比较的位置）
+constexpr std::uint64_t kHorizontalPairs = 0x0111011101110111ULL;
+// 前三行（可以和下方相邻格子比较的位置）
+constexpr std::uint64_t kVerticalPairs = 0x0000111111111111ULL;
+
+// 每个非零半字节的最低位置 1
+inline std::uint64_t nonZeroNibbles(std::uint64_t x)
+{
+    x |= x >> 2;
+    x |= x >> 1;
+    return x & kNibbleLowBits;
+}
+
+// 参考实现使用的行/列：cells[0] 是移动方向上最靠边的格子
+void lineCells(BoardState::Direction direction, int line, int cells[4])
+{
+    for (int i = 0; i < 4; ++i) {
+        switch (direction) {
+        case BoardState::Direction::Up:    cells[i] = i * 4 + line; break;
+        case BoardState::Direction::Down:  cells[i] = (3 - i) * 4 + line; break;
+        case BoardState::Direction::Left:  cells[i] = line * 4 + i; break;
+        case BoardState::Direction::Right: cells[i] = line * 4 + (3 - i); break;
+        }
+    }
+}
+
+}
+
+int BoardState::popcount(std::uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    return static_cast<int>(__popcnt64(value));
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(value);
+#else
+    int count = 0;
+    while (value) {
+        value &= value - 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+int BoardState::countTrailingZeros(std::uint64_t value)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<int>(index);
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(value);
+#else
+    int count = 0;
+    while (!(value & 1)) {
+        value >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+std::uint64_t BoardState::emptyMask() const
+{
+    return ~nonZeroNibbles(m_bits) & kNibbleLowBits;
+}
+
+int BoardState::emptyCount() const
+{
+    return popcount(emptyMask());
+}
+
+int BoardState::nthEmptyCell(int n) const
+{
+    std::uint64_t mask = emptyMask();
+    // 依次清除最低的 n 个置位，剩下的最低位就是目标格子
+    while (n-- > 0) {
+        mask &= mask - 1;
+    }
+    return countTrailingZeros(mask) / 4;
+}
+
+int BoardState::maxExponent() const
+{
+    int result = 0;
+    for (std::uint64_t bits = m_bits; bits; bits >>= 4) {
+        const int exponent = static_cast<int>(bits & 0xF);
+        if (exponent > result) {
+            result = exponent;
+        }
+    }
+    return result;
+}
+
+BoardState BoardState::moved(Direction direction, int *scoreDelta) const
+{
+    const RowMoveTables &tables = rowMoveTables();
+    const bool vertical = direction == Direction::Up || direction == Direction::Down;
+    const std::uint64_t source = vertical ? transposed().m_bits : m_bits;
+    // 上移在转置后就是左移，下移就是右移
+    const bool towardsLow = direction == Direction::Up || direction == Direction::Left;
+    const std::uint16_t *rowTable = towardsLow ? tables.left : tables.right;
+    const std::uint32_t *scoreTable = towardsLow ? tables.leftScore : tables.rightScore;
+
+    std::uint64_t result = 0;
+    std::uint32_t gained = 0;
+    for (int row = 0; row < Size; ++row) {
+        const std::uint16_t bits = static_cast<std::uint16_t>(source >> (16 * row));
+        result |= std::uint64_t(rowTable[bits]) << (16 * row);
+        gained += scoreTable[bits];
+    }
+
+    if (scoreDelta) {
+        *scoreDelta = static_cast<int>(gained);
+    }
+    return vertical ? BoardState(result).transposed() : BoardState(result);
+}
+
+BoardState BoardState::moved(Direction direction, MoveKernel kernel, int *scoreDelta) const
+{
+    return kernel == MoveKernel::LookupTable ? moved(direction, scoreDelta)
+                                             : movedReference(direction, scoreDelta);
+}
+
+BoardState BoardState::movedReference(Direction direction, int *scoreDelta) const
+{
+    BoardState board = *this;
+    int gained = 0;
+
+    for (int line = 0; line < Size; ++line) {
+        int cells[4];
+        lineCells(direction, line, cells);
+
+        // 移动：每个方块尽量向边缘滑动
+        auto slide = [&board, &cells]() {
+            for (int i = 1; i < 4; ++i) {
+                if (board.exponentAt(cells[i]) != 0) {
+                    int target = i;
+                    while (target > 0 && board.exponentAt(cells[target - 1]) == 0) {
+                        board.setExponent(cells[target - 1], board.exponentAt(cells[target]));
+                        board.setExponent(cells[target], 0);
+                        target--;
+                    }
+                }
+            }
+        };
+
+        slide();
+
+        // 合并：相邻且相同的方块合并到靠边的一侧
+        for (int i = 0; i < 3; ++i) {
+            const int exponent = board.exponentAt(cells[i]);
+            if (exponent != 0 && exponent < MaxExponent && exponent == board.exponentAt(cells[i + 1])) {
+                board.setExponent(cells[i], exponent + 1);
+                board.setExponent(cells[i + 1], 0);
+                gained += 1 << (exponent + 1);
+            }
+        }
+
+        slide(); // 合并后再次移动
+    }
+
+    if (scoreDelta) {
+        *scoreDelta = gained;
+    }
+    return board;
+}
+
+BoardState BoardState::transposed() const
+{
+    // 先交换每个 2x2 块内的对角半字节，再交换 2x2 块本身
+    const std::uint64_t x = m_bits;
+    const std::uint64_t a1 = x & 0xF0F00F0FF0F00F0FULL;
+    const std::uint64_t a2 = x & 0x0000F0F00000F0F0ULL;
+    const std::uint64_t a3 = x & 0x0F0F00000F0F0000ULL;
+    const std::uint64_t a = a1 | (a2 << 12) | (a3 >> 12);
+    const std::uint64_t b1 = a & 0xFF00FF0000FF00FFULL;
+    const std::uint64_t b2 = a & 0x00FF00FF00000000ULL;
+    const std::uint64_t b3 = a & 0x00000000FF00FF00ULL;
+    return BoardState(b1 | (b2 >> 24) | (b3 << 24));
+}
+
+bool BoardState::canMove() const
+{
+    // 有空格子
+    if (emptyMask()) {
+        return true;
+    }
+
+    // 与右边或下方相邻格子相同：异或后对应半字节为 0
+    const std::uint64_t horizontal = ~nonZeroNibbles(m_bits ^ (m_bits >> 4)) & kHorizontalPairs;
+    const std::uint64_t vertical = ~nonZeroNibbles(m_bits ^ (m_bits >> 16)) & kVerticalPairs;
+    return (horizontal | vertical) != 0;
+}
+
+std::size_t BoardState::hash() const
+{
+    // splitmix64 的终结函数，保证相近的棋盘也能散列到不同的桶
+    std::uint64_t x = m_bits;
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return static_cast<std::size_t>(x);
+}
@@ -0,0 +1,96 @@
+#ifndef BOARDSTATE_H
+#define BOARDSTATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// 4x4 棋盘的紧凑表示：16 个格子，每格 4 位，保存方块数值的指数（0 表示空格，
+// e 表示数值 2^e）。第 row 行第 col 列位于第 (row * 4 + col) 个半字节，
+// 因此每一行正好是一个 16 位的整数。
+//
+// 整个状态就是一个 uint64_t，可以随意拷贝、比较和哈希。
+// 由于每格只有 4 位，单个方块最大为 2^15 = 32768，两个 32768 不会再合并。
+class BoardState
+{
+public:
+    enum class Direction {
+        Up,
+        Down,
+        Left,
+        Right
+    };
+
+    // 移动的实现方式：查表（默认）或逐格移动合并的参考实现，便于对比和测速
+    enum class MoveKernel {
+        LookupTable,
+        Reference
+    };
+
+    static constexpr int Size = 4;
+    static constexpr int CellCount = Size * Size;
+    static constexpr int MaxExponent = 15;
+
+    constexpr BoardState() = default;
+    explicit constexpr BoardState(std::uint64_t bits) : m_bits(bits) {}
+
+    constexpr std::uint64_t bits() const { return m_bits; }
+
+    int exponentAt(int cell) const { return static_cast<int>((m_bits >> (4 * cell)) & 0xF); }
+    int exponentAt(int row, int col) const { return exponentAt(row * Size + col); }
+    int tileAt(int row, int col) const
+    {
+        const int exponent = exponentAt(row, col);
+        return exponent == 0 ? 0 : (1 << exponent);
+    }
+
+    void setExponent(int cell, int exponent)
+    {
+        const int shift = 4 * cell;
+        m_bits = (m_bits & ~(std::uint64_t(0xF) << shift))
+               | (std::uint64_t(exponent & 0xF) << shift);
+    }
+    void setExponent(int row, int col, int exponent) { setExponent(row * Size + col, exponent); }
+
+    // 每个空格子对应半字节的最低位为 1，其余位为 0
+    std::uint64_t emptyMask() const;
+    int emptyCount() const;
+    // 第 n 个（从 0 开始，按格子序号排列）空格子的格子序号，n 必须小于 emptyCount()
+    int nthEmptyCell(int n) const;
+
+    int maxExponent() const;
+
+    // 向指定方向移动后的棋盘（不生成新方块）。scoreDelta 非空时写入本次合并得分。
+    // 棋盘没有变化时返回值与 *this 相等。
+    BoardState moved(Direction direction, int *scoreDelta = nullptr) const;
+    BoardState moved(Direction direction, MoveKernel kernel, int *scoreDelta = nullptr) const;
+    // 逐格“移动-合并-再移动”的参考实现，结果与查表版本完全一致
+    BoardState movedReference(Direction direction, int *scoreDelta = nullptr) const;
+
+    // 行列互换，用于把上下移动转换成左右移动
+    BoardState transposed() const;
+
+    // 是否还存在空格子或相邻的相同方块
+    bool canMove() const;
+
+    std::size_t hash() const;
+
+    friend constexpr bool operator==(BoardState a, BoardState b) { return a.m_bits == b.m_bits; }
+    friend constexpr bool operator!=(BoardState a, BoardState b) { return a.m_bits != b.m_bits; }
+
+    static int popcount(std::uint64_t value);
+    static int countTrailingZeros(std::uint64_t value);
+
+private:
+    std::uint64_t m_bits = 0;
+};
+
+namespace std {
+template <>
+struct hash<BoardState>
+{
+    std::size_t operator()(BoardState state) const noexcept { return state.hash(); }
+};
+}
+
+#endif // BOARDSTATE_H
@@ -0,0 +1,109 @@
+#ifndef COUNTERRNG_H
+#define COUNTERRNG_H
+
+#include <cstdint>
+
+// 基于计数器的随机数生成器（Philox4x32-10）。
+//
+// 输出只取决于 (seed, stream, position)：第 position 个随机数 = Philox(密钥 = seed,
+// 计数器 = (stream, position / 4)) 的第 position % 4 个字。因此
+//   - 不同 stream 是互相独立的序列，适合每局、每线程各用一个；
+//   - seek() 可以 O(1) 跳到序列中任意位置；
+//   - 状态只有几十个字节，没有共享数据，多线程使用时没有任何同步开销。
+class CounterRng
+{
+public:
+    explicit CounterRng(std::uint64_t seed = 0, std::uint64_t stream = 0)
+    {
+        reset(seed, stream);
+    }
+
+    void reset(std::uint64_t seed, std::uint64_t stream)
+    {
+        m_seed = seed;
+        m_stream = stream;
+        seek(0);
+    }
+
+    std::uint64_t seed() const { return m_seed; }
+    std::uint64_t stream() const { return m_stream; }
+    // 已经取出的随机数个数
+    std::uint64_t position() const { return m_position; }
+
+    void seek(std::uint64_t position)
+    {
+        m_position = position;
+        m_block = ~std::uint64_t(0);
+    }
+
+    std::uint32_t next()
+    {
+        const std::uint64_t block = m_position >> 2;
+        if (block != m_block) {
+            generate(block);
+        }
+        return m_output[m_position++ & 3];
+    }
+
+    // [0, bound) 内均匀分布的整数（Lemire 乘法取高位，拒绝少量偏差值）
+    std::uint32_t bounded(std::uint32_t bound)
+    {
+        std::uint64_t product = std::uint64_t(next()) * bound;
+        std::uint32_t low = static_cast<std::uint32_t>(product);
+        if (low < bound) {
+            const std::uint32_t threshold = static_cast<std::uint32_t>(-bound) % bound;
+            while (low < threshold) {
+                product = std::uint64_t(next()) * bound;
+                low = static_cast<std::uint32_t>(product);
+            }
+        }
+        return static_cast<std::uint32_t>(product >> 32);
+    }
+
+    // 对 (seed, index) 做一次独立的混合，用于从一个基础种子派生其他种子
+    static std::uint64_t mix(std::uint64_t seed, std::uint64_t index)
+    {
+        CounterRng rng(seed, index);
+        return (std::uint64_t(rng.next()) << 32) | rng.next();
+    }
+
+private:
+    void generate(std::uint64_t block)
+    {
+        std::uint32_t c0 = static_cast<std::uint32_t>(block);
+        std::uint32_t c1 = static_cast<std::uint32_t>(block >> 32);
+        std::uint32_t c2 = static_cast<std::uint32_t>(m_stream);
+        std::uint32_t c3 = static_cast<std::uint32_t>(m_stream >> 32);
+        std::uint32_t k0 = static_cast<std::uint32_t>(m_seed);
+        std::uint32_t k1 = static_cast<std::uint32_t>(m_seed >> 32);
+
+        for (int round = 0; round < 10; ++round) {
+            if (round > 0) {
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+            const std::uint64_t p0 = std::uint64_t(0xD2511F53u) * c0;
+            const std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * c2;
+            const std::uint32_t next0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            const std::uint32_t next2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3 ^ k1;
+            c1 = static_cast<std::uint32_t>(p1);
+            c3 = static_cast<std::uint32_t>(p0);
+            c0 = next0;
+            c2 = next2;
+        }
+
+        m_output[0] = c0;
+        m_output[1] = c1;
+        m_output[2] = c2;
+        m_output[3] = c3;
+        m_block = block;
+    }
+
+    std::uint64_t m_seed;
+    std::uint64_t m_stream;
+    std::uint64_t m_position;
+    std::uint64_t m_block;
+    std::uint32_t m_output[4];
+};
+
+#endif // COUNTERRNG_H
@@ -0,0 +1,400 @@
+#include "endgametable.h"
+#include "boardengine.h"
+#include "perfcounters.h"
+#include "workstealingpool.h"
+
+#include <chrono>
+#include <cstring>
+#include <ostream>
+
+namespace {
+
+constexpr BoardState::Direction kDirections[] = {
+    BoardState::Direction::Up,
+    BoardState::Direction::Down,
+    BoardState::Direction::Left,
+    BoardState::Direction::Right
+};
+
+// 与 GameCore::addRandomTile() 相同：90% 生成 2，10% 生成 4
+constexpr double kSpawnTwoProbability = 0.9;
+constexpr double kSpawnFourProbability = 0.1;
+
+constexpr char kMagic[8] = {'2', '0', '4', '8', 'E', 'G', 'T', '\0'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+// 值从 4KB 处开始，保证映射后按页对齐
+constexpr std::size_t kValueOffset = 4096;
+
+// 文件头按本机字节序写入，读取时用 byteOrder 检查
+struct FileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t boardSize;
+    std::uint32_t targetExponent;
+    std::uint32_t metric;
+    std::uint32_t reserved;
+    std::uint64_t valueOffset;
+    std::uint64_t stateCount;
+};
+
+static_assert(sizeof(FileHeader) <= kValueOffset, "header must fit before the values");
+
+// 方块总和的一半（以 2 为单位），生成一个方块后增加 1 或 2
+std::uint32_t sumUnits(const std::uint8_t *cells, int cellCount)
+{
+    std::uint32_t units = 0;
+    for (int cell = 0; cell < cellCount; ++cell) {
+        if (cells[cell] != 0) {
+            units += 1u << (cells[cell] - 1);
+        }
+    }
+    return units;
+}
+
+}
+
+const char *EndgameTable::metricName(Metric metric)
+{
+    return metric == Metric::WinProbability ? "win" : "score";
+}
+
+bool EndgameTable::setShape(int boardSize, int targetExponent, Metric metric, std::string *error)
+{
+    if (boardSize < BoardEngine::MinSize || boardSize > MaxBoardSize
+            || targetExponent < MinTargetExponent || targetExponent > MaxTargetExponent) {
+        if (error) {
+            *error = "board size must be 2-4 and the target exponent 3-15";
+        }
+        return false;
+    }
+
+    const int cellCount = boardSize * boardSize;
+    std::uint64_t states = 1;
+    for (int cell = 0; cell < cellCount; ++cell) {
+        m_powers[cell] = states;
+        states *= static_cast<std::uint64_t>(targetExponent);
+        if (states > MaxStates) {
+            if (error) {
+                *error = "position class has more than 2^28 positions";
+            }
+            return false;
+        }
+    }
+
+    m_boardSize = boardSize;
+    m_targetExponent = targetExponent;
+    m_metric = metric;
+    m_stateCount = states;
+    return true;
+}
+
+bool EndgameTable::index(const std::uint8_t *cells, std::uint64_t *result) const
+{
+    std::uint64_t value = 0;
+    for (int cell = 0; cell < m_boardSize * m_boardSize; ++cell) {
+        if (cells[cell] >= m_targetExponent) {
+            return false;
+        }
+        value += cells[cell] * m_powers[cell];
+    }
+    *result = value;
+    return true;
+}
+
+bool EndgameTable::evaluateMoves(const std::uint8_t *cells, const float *values, Direction *best,
+                                 double *value) const
+{
+    const int cellCount = m_boardSize * m_boardSize;
+    bool found = false;
+    double bestValue = 0;
+    for (Direction direction : kDirections) {
+        std::uint8_t after[MaxCells];
+        std::int64_t gained = 0;
+        if (!BoardEngine::moveCells(cells, m_boardSize, direction, after, &gained)) {
+            continue;
+        }
+
+        double moveValue = m_metric == Metric::ExpectedScore ? gained : 0.0;
+        std::uint64_t base = 0;
+        if (!index(after, &base)) {
+            // 合并出了目标方块，对局到此结束
+            if (m_metric == Metric::WinProbability) {
+                moveValue = 1.0;
+            }
+        } else {
+            // 能移动的方向至少空出一个格子；新方块落在每个空格的概率相同
+            int empty = 0;
+            double spawned = 0;
+            for (int cell = 0; cell < cellCount; ++cell) {
+                if (after[cell] == 0) {
+                    ++empty;
+                    spawned += kSpawnTwoProbability * values[base + m_powers[cell]]
+                             + kSpawnFourProbability * values[base + 2 * m_powers[cell]];
+                }
+            }
+            moveValue += spawned / empty;
+        }
+
+        if (!found || moveValue > bestValue) {
+            found = true;
+            bestValue = moveValue;
+            if (best) {
+                *best = direction;
+            }
+        }
+    }
+    *value = bestValue;
+    return found;
+}
+
+bool EndgameTable::generate(const Settings &settings, std::string *error, Statistics *statistics)
+{
+    m_mapping.close();
+    m_values = nullptr;
+    if (!setShape(settings.boardSize, settings.targetExponent, settings.metric, error)) {
+        return false;
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    const int cellCount = m_boardSize * m_boardSize;
+    const std::uint32_t maxUnits = static_cast<std::uint32_t>(cellCount) << (m_targetExponent - 2);
+
+    // 按方块总和做计数排序：第一遍统计每层的局面数，第二遍把编号放进各层。
+    // 编号像里程表一样逐格进位，不必对每个编号做除法。
+    std::vector<std::uint64_t> levelBegin(maxUnits + 2, 0);
+    std::uint8_t digits[MaxCells] = {};
+    auto advance = [&digits, cellCount, this]() {
+        for (int cell = 0; cell < cellCount; ++cell) {
+            if (++digits[cell] < m_targetExponent) {
+                return;
+            }
+            digits[cell] = 0;
+        }
+    };
+    for (std::uint64_t state = 0; state < m_stateCount; ++state) {
+        ++levelBegin[sumUnits(digits, cellCount) + 1];
+        advance();
+    }
+    for (std::uint32_t units = 1; units < levelBegin.size(); ++units) {
+        levelBegin[units] += levelBegin[units - 1];
+    }
+    std::vector<std::uint32_t> order(m_stateCount);
+    {
+        std::vector<std::uint64_t> next(levelBegin.begin(), levelBegin.end() - 1);
+        std::memset(digits, 0, sizeof(digits));
+        for (std::uint64_t state = 0; state < m_stateCount; ++state) {
+            order[next[sumUnits(digits, cellCount)]++] = static_cast<std::uint32_t>(state);
+            advance();
+        }
+    }
+
+    m_ownedValues.assign(m_stateCount, 0.0f);
+    float *values = m_ownedValues.data();
+
+    // 从总和最大的一层开始；一层中的局面只读取更高层的值，写入各自的位置，可以并行
+    WorkStealingPool pool(settings.threadCount);
+    int levels = 0;
+    for (std::uint32_t units = maxUnits + 1; units-- > 0;) {
+        const std::uint64_t begin = levelBegin[units];
+        const std::uint64_t end = levelBegin[units + 1];
+        if (begin == end) {
+            continue;
+        }
+        ++levels;
+        PERF_TRACE_SCOPE("endgame level");
+        pool.run(static_cast<std::size_t>(end - begin), 256, [&](int, std::size_t first, std::size_t last) {
+            std::uint8_t cells[MaxCells];
+            for (std::size_t k = first; k < last; ++k) {
+                std::uint64_t state = order[begin + k];
+                for (int cell = 0; cell < cellCount; ++cell) {
+                    cells[cell] = static_cast<std::uint8_t>(state % m_targetExponent);
+                    state /= m_targetExponent;
+                }
+                double value = 0;
+                evaluateMoves(cells, values, nullptr, &value);
+                values[order[begin + k]] = static_cast<float>(value);
+            }
+        });
+    }
+    m_values = values;
+
+    if (statistics) {
+        statistics->states = m_stateCount;
+        statistics->levels = levels;
+        statistics->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    }
+    return true;
+}
+
+bool EndgameTable::saveFile(const std::string &path, std::string *error) const
+{
+    if (!isValid()) {
+        if (error) {
+            *error = "table has no values";
+        }
+        return false;
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.boardSize = static_cast<std::uint32_t>(m_boardSize);
+    header.targetExponent = static_cast<std::uint32_t>(m_targetExponent);
+    header.metric = static_cast<std::uint32_t>(m_metric);
+    header.valueOffset = kValueOffset;
+    header.stateCount = m_stateCount;
+
+    // 运行中的模拟器可能通过 --endgame 映射着 path
+    return MappedFile::writeFile(path, [&](std::ostream &file) {
+        std::vector<char> padding(kValueOffset - sizeof(header), 0);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        file.write(reinterpret_cast<const char *>(m_values),
+                   static_cast<std::streamsize>(m_stateCount * sizeof(float)));
+    }, error);
+}
+
+bool EndgameTable::mapFile(const std::string &path, std::string *error)
+{
+    m_ownedValues.clear();
+    m_ownedValues.shrink_to_fit();
+    m_values = nullptr;
+    if (!m_mapping.open(path, error)) {
+        return false;
+    }
+
+    FileHeader header;
+    bool valid = m_mapping.size() >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, m_mapping.data(), sizeof(header));
+        valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion;
+    }
+    if (!valid) {
+        if (error) {
+            *error = "not an endgame table file";
+        }
+        m_mapping.close();
+        return false;
+    }
+    if (header.byteOrder != kByteOrderMark) {
+        if (error) {
+            *error = "endgame table was written on a machine with a different byte order";
+        }
+        m_mapping.close();
+        return false;
+    }
+    if (header.metric > static_cast<std::uint32_t>(Metric::ExpectedScore)) {
+        if (error) {
+            *error = "unknown endgame table metric";
+        }
+        m_mapping.close();
+        return false;
+    }
+    if (!setShape(static_cast<int>(header.boardSize), static_cast<int>(header.targetExponent),
+                  static_cast<Metric>(header.metric), error)) {
+        m_mapping.close();
+        return false;
+    }
+    if (header.stateCount != m_stateCount
+            || !MappedFile::containsFloats(header.valueOffset, m_stateCount, sizeof(header), m_mapping.size())) {
+        if (error) {
+            *error = "endgame table is truncated or inconsistent";
+        }
+        m_mapping.close();
+        return false;
+    }
+
+    m_values = reinterpret_cast<const float *>(m_mapping.data() + header.valueOffset);
+    return true;
+}
+
+bool EndgameTable::lookup(const std::uint8_t *cells, double *value) const
+{
+    std::uint64_t state = 0;
+    if (!isValid() || !index(cells, &state)) {
+        return false;
+    }
+    *value = m_values[state];
+    return true;
+}
+
+bool EndgameTable::lookup(BoardState board, double *value) const
+{
+    if (m_boardSize != BoardState::Size) {
+        return false;
+    }
+    std::uint8_t cells[BoardState::CellCount];
+    for (int cell = 0; cell < BoardState::CellCount; ++cell) {
+        cells[cell] = static_cast<std::uint8_t>(board.exponentAt(cell));
+    }
+    return lookup(cells, value);
+}
+
+bool EndgameTable::bestMove(const std::uint8_t *cells, Direction *direction, double *value) const
+{
+    std::uint64_t state = 0;
+    if (!isValid() || !index(cells, &state)) {
+        return false;
+    }
+    double best = 0;
+    if (!evaluateMoves(cells, m_values, direction, &best)) {
+        return false;
+    }
+    if (value) {
+        *value = best;
+    }
+    return true;
+}
+
+double EndgameTable::initialValue() const
+{
+    if (!isValid()) {
+        return 0;
+    }
+
+    // 与 GameCore::newGame() 一样依次在空格中放两个方块
+    const int cellCount = m_boardSize * m_boardSize;
+    const double probabilities[] = {kSpawnTwoProbability, kSpawnFourProbability};
+    double total = 0;
+    for (int first = 0; first < cellCount; ++first) {
+        for (int second = 0; second < cellCount; ++second) {
+            if (second == first) {
+                continue;
+            }
+            for (int a = 0; a < 2; ++a) {
+                for (int b = 0; b < 2; ++b) {
+                    const std::uint64_t state = (a + 1) * m_powers[first] + (b + 1) * m_powers[second];
+                    total += probabilities[a] * probabilities[b] * m_values[state];
+                }
+            }
+        }
+    }
+    return total / (cellCount * (cellCount - 1));
+}
+
+EndgamePolicy::EndgamePolicy(const EndgameTable *table)
+    : m_table(table)
+    , m_tableMoves(0)
+{
+}
+
+Policy::Direction EndgamePolicy::chooseMove(const GameCore &game)
+{
+    if (game.boardSize() == m_table->boardSize()) {
+        std::uint8_t cells[EndgameTable::MaxCells];
+        for (int cell = 0; cell < game.cellCount(); ++cell) {
+            cells[cell] = static_cast<std::uint8_t>(game.exponentAt(cell));
+        }
+        Direction direction;
+        if (m_table->bestMove(cells, &direction)) {
+            ++m_tableMoves;
+            return direction;
+        }
+    }
+    return m_fallback.chooseMove(game);
+}
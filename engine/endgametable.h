@@ -0,0 +1,123 @@
+#ifndef ENDGAMETABLE_H
+#define ENDGAMETABLE_H
+
+#include "mappedfile.h"
+#include "policy.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 残局表：用逆向分析求出一类局面在最优走法下的精确值，保存为可直接内存映射的平坦文件。
+//
+// 局面类由棋盘边长 N 和目标指数 T 确定：所有方块都小于 2^T 的 NxN 局面（轮到玩家移动）。
+// 除了合并出 2^T（对局按“达成目标”结束）以外，移动和生成方块都不会离开这一类局面；
+// 每次生成方块都使方块总和增加 2 或 4，所以按总和从大到小逐层计算时，每个局面只依赖已经算好的层。
+// 同一层的局面互不依赖，分给工作窃取线程池并行计算。
+//
+// 局面按各格指数（0 .. T-1）组成的 T 进制数编号，第 0 格为最低位。文件中没有键，
+// 只有 4KB 文件头和 T^(N*N) 个 float；查询时算出编号直接取值，O(N*N)，只有被访问到的页才会读入内存。
+class EndgameTable
+{
+public:
+    using Direction = BoardState::Direction;
+
+    enum class Metric {
+        // 合并出 2^T 的概率
+        WinProbability,
+        // 合并出 2^T 或无法移动之前还能得到的期望分数
+        ExpectedScore
+    };
+
+    struct Settings
+    {
+        int boardSize = 3;
+        int targetExponent = 6;
+        Metric metric = Metric::WinProbability;
+        // 0 表示使用硬件线程数
+        int threadCount = 0;
+    };
+
+    struct Statistics
+    {
+        std::uint64_t states = 0;
+        int levels = 0;
+        double seconds = 0;
+    };
+
+    // 一张表最多的局面数，生成时每个局面需要 8 字节内存
+    static constexpr std::uint64_t MaxStates = std::uint64_t(1) << 28;
+    static constexpr int MinTargetExponent = 3;
+    static constexpr int MaxTargetExponent = BoardState::MaxExponent;
+    // MaxStates 以内的表最大是 4x4
+    static constexpr int MaxBoardSize = 4;
+    static constexpr int MaxCells = MaxBoardSize * MaxBoardSize;
+
+    EndgameTable() = default;
+
+    EndgameTable(const EndgameTable &) = delete;
+    EndgameTable &operator=(const EndgameTable &) = delete;
+
+    // 在内存中计算整张表
+    bool generate(const Settings &settings, std::string *error, Statistics *statistics = nullptr);
+    bool saveFile(const std::string &path, std::string *error) const;
+    // 只读映射表文件，不把整个文件读进内存
+    bool mapFile(const std::string &path, std::string *error);
+
+    bool isValid() const { return m_values != nullptr; }
+    int boardSize() const { return m_boardSize; }
+    int targetExponent() const { return m_targetExponent; }
+    Metric metric() const { return m_metric; }
+    std::uint64_t stateCount() const { return m_stateCount; }
+
+    // 局面属于这张表时写入精确值并返回 true。cells 是行优先的 N*N 个指数
+    bool lookup(const std::uint8_t *cells, double *value) const;
+    bool lookup(BoardState board, double *value) const;
+    // 按表选出期望值最高的方向；局面不属于这张表或不能移动时返回 false
+    bool bestMove(const std::uint8_t *cells, Direction *direction, double *value = nullptr) const;
+
+    // 新的一局（两个随机方块）开始时的期望值
+    double initialValue() const;
+
+    static const char *metricName(Metric metric);
+
+private:
+    bool setShape(int boardSize, int targetExponent, Metric metric, std::string *error);
+    // 所有指数都小于 T 时写入编号
+    bool index(const std::uint8_t *cells, std::uint64_t *result) const;
+    // 当前局面各个方向的期望值中的最大值；不能移动时返回 false（值为 0）
+    bool evaluateMoves(const std::uint8_t *cells, const float *values, Direction *best, double *value) const;
+
+    int m_boardSize = 0;
+    int m_targetExponent = 0;
+    Metric m_metric = Metric::WinProbability;
+    std::uint64_t m_stateCount = 0;
+    // 第 c 格的位权 T^c
+    std::uint64_t m_powers[MaxCells] = {};
+
+    std::vector<float> m_ownedValues;
+    MappedFile m_mapping;
+    // 指向 m_ownedValues 或映射文件中的值
+    const float *m_values = nullptr;
+};
+
+// 局面在残局表中时按表走最优方向，否则退回贪心策略。适用于与表大小相同的任意棋盘
+class EndgamePolicy : public Policy
+{
+public:
+    explicit EndgamePolicy(const EndgameTable *table);
+
+    const char *name() const override { return "endgame"; }
+    Direction chooseMove(const GameCore &game) override;
+
+    // 走出的步中由残局表决定的步数
+    std::uint64_t tableMoves() const { return m_tableMoves; }
+
+private:
+    const EndgameTable *m_table;
+    GreedyPolicy m_fallback;
+    std::uint64_t m_tableMoves;
+};
+
+#endif // ENDGAMETABLE_H
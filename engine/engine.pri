@@ -0,0 +1,51 @@
+# 不依赖 Qt 的游戏引擎核心，GUI 与命令行工具共用
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+# CONFIG += perf_counters（或 qmake "CONFIG+=perf_counters"）编译进性能计数器和 trace 事件
+perf_counters: DEFINES += GAME2048_PERF_COUNTERS
+
+SOURCES += \
+    $$PWD/batchmove.cpp \
+    $$PWD/boardengine.cpp \
+    $$PWD/boardstate.cpp \
+    $$PWD/endgametable.cpp \
+    $$PWD/expectimax.cpp \
+    $$PWD/gamecore.cpp \
+    $$PWD/gamehistory.cpp \
+    $$PWD/gameprotocol.cpp \
+    $$PWD/gamestatistics.cpp \
+    $$PWD/gamejournal.cpp \
+    $$PWD/mappedfile.cpp \
+    $$PWD/montecarlo.cpp \
+    $$PWD/movedelta.cpp \
+    $$PWD/movetables.cpp \
+    $$PWD/ntuplenetwork.cpp \
+    $$PWD/perfcounters.cpp \
+    $$PWD/policy.cpp \
+    $$PWD/tdtrainer.cpp \
+    $$PWD/transpositiontable.cpp \
+    $$PWD/workstealingpool.cpp
+
+HEADERS += \
+    $$PWD/batchmove.h \
+    $$PWD/boardengine.h \
+    $$PWD/boardstate.h \
+    $$PWD/counterrng.h \
+    $$PWD/endgametable.h \
+    $$PWD/expectimax.h \
+    $$PWD/gamecore.h \
+    $$PWD/gamehistory.h \
+    $$PWD/gameprotocol.h \
+    $$PWD/gamestatistics.h \
+    $$PWD/gamejournal.h \
+    $$PWD/mappedfile.h \
+    $$PWD/montecarlo.h \
+    $$PWD/movedelta.h \
+    $$PWD/movetables.h \
+    $$PWD/ntuplenetwork.h \
+    $$PWD/perfcounters.h \
+    $$PWD/policy.h \
+    $$PWD/tdtrainer.h \
+    $$PWD/transpositiontable.h \
+    $$PWD/workstealingpool.h
@@ -0,0 +1,305 @@
+#include "expectimax.h"
+#include "perfcounters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace {
+
+constexpr BoardState::Direction kDirections[] = {
+    BoardState::Direction::Up,
+    BoardState::Direction::Down,
+    BoardState::Direction::Left,
+    BoardState::Direction::Right
+};
+
+constexpr double kSpawnTwoProbability = 0.9;
+constexpr double kSpawnFourProbability = 0.1;
+// 每进入这么多个机会节点检查一次停止条件，读取时钟的开销可以忽略
+constexpr std::uint32_t kStopPollInterval = 1024;
+
+// 启发式权重：单调性和方块总和为惩罚项，空格和可合并数为奖励项
+constexpr double kLostPenalty = 200000.0;
+constexpr double kMonotonicityPower = 4.0;
+constexpr double kMonotonicityWeight = 47.0;
+constexpr double kSumPower = 3.5;
+constexpr double kSumWeight = 11.0;
+constexpr double kMergesWeight = 700.0;
+constexpr double kEmptyWeight = 270.0;
+
+std::unique_ptr<float[]> buildRowScores()
+{
+    std::unique_ptr<float[]> scores(new float[1 << 16]);
+    for (int row = 0; row < (1 << 16); ++row) {
+        int line[4];
+        for (int i = 0; i < 4; ++i) {
+            line[i] = (row >> (4 * i)) & 0xF;
+        }
+
+        double sum = 0;
+        int empty = 0;
+        int merges = 0;
+        int previous = 0;
+        int counter = 0;
+        for (int i = 0; i < 4; ++i) {
+            const int exponent = line[i];
+            sum += std::pow(exponent, kSumPower);
+            if (exponent == 0) {
+                ++empty;
+            } else {
+                if (previous == exponent) {
+                    ++counter;
+                } else if (counter > 0) {
+                    merges += 1 + counter;
+                    counter = 0;
+                }
+                previous = exponent;
+            }
+        }
+        if (counter > 0) {
+            merges += 1 + counter;
+        }
+
+        double monotonicityLeft = 0;
+        double monotonicityRight = 0;
+        for (int i = 1; i < 4; ++i) {
+            const double a = std::pow(line[i - 1], kMonotonicityPower);
+            const double b = std::pow(line[i], kMonotonicityPower);
+            if (line[i - 1] > line[i]) {
+                monotonicityLeft += a - b;
+            } else {
+                monotonicityRight += b - a;
+            }
+        }
+
+        scores[row] = static_cast<float>(kLostPenalty + kEmptyWeight * empty + kMergesWeight * merges
+                                         - kMonotonicityWeight * std::min(monotonicityLeft, monotonicityRight)
+                                         - kSumWeight * sum);
+    }
+    return scores;
+}
+
+const float *rowScores()
+{
+    static const std::unique_ptr<float[]> scores = buildRowScores();
+    return scores.get();
+}
+
+}
+
+HeuristicEvaluator::HeuristicEvaluator()
+    : m_rowScores(rowScores())
+{
+}
+
+double HeuristicEvaluator::evaluate(BoardState board) const
+{
+    const std::uint64_t rows = board.bits();
+    const std::uint64_t columns = board.transposed().bits();
+    double score = 0;
+    for (int i = 0; i < BoardState::Size; ++i) {
+        score += m_rowScores[(rows >> (16 * i)) & 0xFFFF];
+        score += m_rowScores[(columns >> (16 * i)) & 0xFFFF];
+    }
+    return score;
+}
+
+ExpectimaxSearch::ExpectimaxSearch(const BoardEvaluator *evaluator)
+    : m_evaluator(evaluator ? evaluator : &m_defaultEvaluator)
+    , m_ownTableBytes(0)
+    , m_sharedTable(nullptr)
+    , m_table(nullptr)
+    , m_nodes(0)
+    , m_stopFlag(nullptr)
+    , m_hasDeadline(false)
+    , m_pollCount(0)
+    , m_stopped(false)
+{
+}
+
+SearchResult ExpectimaxSearch::search(BoardState board)
+{
+    const Clock::time_point start = Clock::now();
+    prepareTable();
+    m_nodes = 0;
+    m_hasDeadline = false;
+    m_pollCount = 0;
+    m_stopped = false;
+
+    SearchResult result = searchRoot(board, m_settings.depth);
+    result.aborted = m_stopped;
+    result.nodes = m_nodes;
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return result;
+}
+
+SearchResult ExpectimaxSearch::searchIterative(BoardState board, double timeBudget, int maxDepth,
+                                               const std::function<void(const SearchResult &)> &progress)
+{
+    const Clock::time_point start = Clock::now();
+    prepareTable();
+    m_nodes = 0;
+    m_hasDeadline = true;
+    m_deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(timeBudget));
+    m_pollCount = 0;
+    m_stopped = false;
+
+    // 置换表跨层保留：表项记录了剩余深度，较浅一层的结果不会被误用到更深的搜索中
+    SearchResult best;
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        SearchResult result = searchRoot(board, depth);
+        if (m_stopped) {
+            break;
+        }
+        best = result;
+        best.nodes = m_nodes;
+        best.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (progress) {
+            progress(best);
+        }
+        if (!best.hasMove || best.seconds >= timeBudget) {
+            break;
+        }
+    }
+
+    best.aborted = m_stopped;
+    best.nodes = m_nodes;
+    best.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    m_hasDeadline = false;
+    return best;
+}
+
+void ExpectimaxSearch::prepareTable()
+{
+    if (m_sharedTable) {
+        m_table = m_sharedTable;
+        return;
+    }
+    if (m_ownTableBytes != m_settings.tableBytes) {
+        m_ownTableBytes = m_settings.tableBytes;
+        m_ownTable.resize(m_ownTableBytes);
+    }
+    m_table = m_ownTable.isValid() ? &m_ownTable : nullptr;
+    if (m_table) {
+        m_table->newSearch();
+    }
+}
+
+bool ExpectimaxSearch::stopRequested()
+{
+    if (m_stopped) {
+        return true;
+    }
+    if (!m_stopFlag && !m_hasDeadline) {
+        return false;
+    }
+    if (++m_pollCount % kStopPollInterval != 0) {
+        return false;
+    }
+    m_stopped = (m_stopFlag && m_stopFlag->load(std::memory_order_relaxed))
+             || (m_hasDeadline && Clock::now() >= m_deadline);
+    return m_stopped;
+}
+
+SearchResult ExpectimaxSearch::searchRoot(BoardState board, int depth)
+{
+    PERF_TRACE_SCOPE("expectimax");
+    SearchResult result;
+    result.depth = depth;
+    double bestValue = -std::numeric_limits<double>::infinity();
+    for (Direction direction : kDirections) {
+        const int index = static_cast<int>(direction);
+        const BoardState next = board.moved(direction);
+        if (next == board) {
+            continue;
+        }
+        ++m_nodes;
+        const double value = chanceNode(next, depth, 1.0);
+        result.legal[index] = true;
+        result.moveValues[index] = value;
+        if (value > bestValue) {
+            bestValue = value;
+            result.bestMove = direction;
+            result.hasMove = true;
+        }
+    }
+    return result;
+}
+
+double ExpectimaxSearch::maxNode(BoardState board, int depth, double probability)
+{
+    double best = 0;
+    for (Direction direction : kDirections) {
+        const BoardState next = board.moved(direction);
+        if (next == board) {
+            continue;
+        }
+        ++m_nodes;
+        best = std::max(best, chanceNode(next, depth, probability));
+    }
+    // 无路可走（游戏结束）时价值为 0
+    return best;
+}
+
+// depth 为进入该节点时剩余的玩家步数（包括导致该局面的这一步）
+double ExpectimaxSearch::chanceNode(BoardState board, int depth, double probability)
+{
+    if (depth <= 1 || probability < m_settings.probabilityCutoff) {
+        return m_evaluator->evaluate(board);
+    }
+    // 被打断的这一遍搜索整体作废，返回值和写入置换表的值都不会再被使用
+    if (stopRequested()) {
+        return 0;
+    }
+
+    const bool cacheable = m_table && depth >= m_settings.cacheMinDepth;
+    if (cacheable) {
+        TranspositionTable::Entry entry;
+        if (m_table->probe(board.bits(), &entry) && entry.depth >= depth) {
+            return entry.value;
+        }
+    }
+
+    const int emptyCount = board.emptyCount();
+    const double cellProbability = probability / emptyCount;
+    double total = 0;
+    std::uint64_t mask = board.emptyMask();
+    while (mask) {
+        const int shift = BoardState::countTrailingZeros(mask);
+        mask &= mask - 1;
+        const BoardState two(board.bits() | (std::uint64_t(1) << shift));
+        const BoardState four(board.bits() | (std::uint64_t(2) << shift));
+        total += kSpawnTwoProbability * maxNode(two, depth - 1, cellProbability * kSpawnTwoProbability);
+        total += kSpawnFourProbability * maxNode(four, depth - 1, cellProbability * kSpawnFourProbability);
+    }
+    m_nodes += 2 * emptyCount;
+
+    const double value = total / emptyCount;
+    // 被打断时子树的值不完整，不能留在（可能共享的）表里
+    if (cacheable && !m_stopped) {
+        m_table->store(board.bits(), depth, static_cast<float>(value));
+    }
+    return value;
+}
+
+ExpectimaxPolicy::ExpectimaxPolicy(const ExpectimaxSearch::Settings &settings,
+                                   const BoardEvaluator *evaluator)
+    : m_search(evaluator)
+    , m_totalNodes(0)
+    , m_totalSeconds(0)
+    , m_decisions(0)
+{
+    m_search.setSettings(settings);
+}
+
+Policy::Direction ExpectimaxPolicy::chooseMove(const GameCore &game)
+{
+    const SearchResult result = m_search.search(game.state());
+    m_totalNodes += result.nodes;
+    m_totalSeconds += result.seconds;
+    ++m_decisions;
+    return result.bestMove;
+}
@@ -0,0 +1,146 @@
+#ifndef EXPECTIMAX_H
+#define EXPECTIMAX_H
+
+#include "boardstate.h"
+#include "policy.h"
+#include "transpositiontable.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// 局面评估函数接口。评估值越大越好；必须可以在多个线程中同时调用（const 且无共享可变状态）。
+class BoardEvaluator
+{
+public:
+    virtual ~BoardEvaluator() = default;
+    virtual double evaluate(BoardState board) const = 0;
+};
+
+// 默认启发式：按行查表累加空格数、可合并数、单调性和方块大小惩罚，行和列各算一遍
+class HeuristicEvaluator : public BoardEvaluator
+{
+public:
+    HeuristicEvaluator();
+    double evaluate(BoardState board) const override;
+
+private:
+    const float *m_rowScores;
+};
+
+struct SearchResult
+{
+    using Direction = BoardState::Direction;
+
+    bool hasMove = false;
+    Direction bestMove = Direction::Up;
+    // 按 Direction 的顺序保存每个方向的期望值；不能移动的方向 legal 为 false
+    double moveValues[4] = {0, 0, 0, 0};
+    bool legal[4] = {false, false, false, false};
+
+    int depth = 0;
+    std::uint64_t nodes = 0;
+    double seconds = 0;
+    // 搜索被停止标志打断；迭代加深时表示没有搜完 maxDepth 就提前结束
+    bool aborted = false;
+
+    double nodesPerSecond() const { return seconds > 0 ? nodes / seconds : 0; }
+};
+
+// 期望最大化搜索：玩家节点取各方向的最大值，机会节点按生成规则
+// （均匀选择空格子，90% 为 2、10% 为 4）求期望。
+// 累积概率低于 probabilityCutoff 的分支直接用评估函数截断。
+class ExpectimaxSearch
+{
+public:
+    using Direction = BoardState::Direction;
+
+    struct Settings
+    {
+        // 搜索的玩家步数
+        int depth = 3;
+        double probabilityCutoff = 0.0001;
+        // 只有剩余深度不小于该值的机会节点才写入置换表，避免表过大
+        int cacheMinDepth = 1;
+        // 自带置换表的大小（字节），第一次搜索时分配；使用共享置换表时不分配
+        std::size_t tableBytes = std::size_t(16) << 20;
+    };
+
+    // evaluator 为空时使用默认启发式；evaluator 的生命周期由调用方保证
+    explicit ExpectimaxSearch(const BoardEvaluator *evaluator = nullptr);
+
+    void setSettings(const Settings &settings) { m_settings = settings; }
+    const Settings &settings() const { return m_settings; }
+
+    // 可选的停止标志，生命周期由调用方保证。搜索中定期检查，置位后尽快返回（aborted 为 true）
+    void setStopFlag(const std::atomic<bool> *stop) { m_stopFlag = stop; }
+
+    // 可选的共享置换表，生命周期由调用方保证；为空时使用自己的表。
+    // 自己的表每次搜索开始时失效，结果与线程数无关；共享表由拥有者决定何时调用 newSearch()，
+    // 多个线程共享时结果取决于线程间的交错
+    void setTranspositionTable(TranspositionTable *table) { m_sharedTable = table; }
+
+    SearchResult search(BoardState board);
+    // 迭代加深：依次搜索深度 1、2……maxDepth，每完成一层调用一次 progress。
+    // 超过 timeBudget 秒或停止标志置位时，进行到一半的那一层被丢弃，返回最后一个完整的深度（深度 1 总会完成）
+    SearchResult searchIterative(BoardState board, double timeBudget, int maxDepth,
+                                 const std::function<void(const SearchResult &)> &progress = nullptr);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // 根节点按给定深度搜索一遍，不清空置换表和节点计数
+    SearchResult searchRoot(BoardState board, int depth);
+    // 选定本次搜索使用的置换表，需要时分配自己的表；分配失败时不使用置换表
+    void prepareTable();
+    double maxNode(BoardState board, int depth, double probability);
+    double chanceNode(BoardState board, int depth, double probability);
+    // 每隔一段节点检查一次停止标志和截止时间
+    bool stopRequested();
+
+    HeuristicEvaluator m_defaultEvaluator;
+    const BoardEvaluator *m_evaluator;
+    Settings m_settings;
+    TranspositionTable m_ownTable;
+    // 上次为 m_ownTable 申请的大小，分配失败时不再重试
+    std::size_t m_ownTableBytes;
+    TranspositionTable *m_sharedTable;
+    // 本次搜索使用的置换表，可能为空
+    TranspositionTable *m_table;
+    std::uint64_t m_nodes;
+
+    const std::atomic<bool> *m_stopFlag;
+    bool m_hasDeadline;
+    Clock::time_point m_deadline;
+    std::uint32_t m_pollCount;
+    // 本次搜索已经被打断，之后的节点直接返回
+    bool m_stopped;
+};
+
+// 以期望最大化搜索作为对局策略
+class ExpectimaxPolicy : public Policy
+{
+public:
+    explicit ExpectimaxPolicy(const ExpectimaxSearch::Settings &settings,
+                              const BoardEvaluator *evaluator = nullptr);
+
+    const char *name() const override { return "expectimax"; }
+    Direction chooseMove(const GameCore &game) override;
+
+    // 累计的搜索统计，用于输出每秒节点数和平均决策时间
+    std::uint64_t totalNodes() const { return m_totalNodes; }
+    double totalSeconds() const { return m_totalSeconds; }
+    std::uint64_t decisions() const { return m_decisions; }
+
+    void setTranspositionTable(TranspositionTable *table) { m_search.setTranspositionTable(table); }
+
+private:
+    ExpectimaxSearch m_search;
+    std::uint64_t m_totalNodes;
+    double m_totalSeconds;
+    std::uint64_t m_decisions;
+};
+
+#endif // EXPECTIMAX_H
@@ -0,0 +1,329 @@
+#include "gamecore.h"
+#include "gamejournal.h"
+#include "mappedfile.h"
+
+#include <cstring>
+#include <fstream>
+#include <random>
+
+namespace {
+
+constexpr char kMagic[8] = {'2', '0', '4', '8', 'S', 'A', 'V', '\0'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+// 存档按本机字节序写入，读取时用 byteOrder 检查
+struct SaveFile
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint64_t seed;
+    std::uint64_t stream;
+    GameSnapshot snapshot;
+};
+
+static_assert(sizeof(SaveFile) == 56, "save files have a fixed size");
+
+}
+
+GameCore::GameCore()
+    : GameCore(std::random_device()())
+{
+}
+
+GameCore::GameCore(std::uint64_t seed, std::uint64_t stream)
+    : m_score(0)
+    , m_moveCount(0)
+    , m_gameOver(false)
+    , m_moveKernel(MoveKernel::LookupTable)
+    , m_random(seed, stream)
+    , m_journal(nullptr)
+    , m_journaling(false)
+{
+    newGame();
+}
+
+void GameCore::seed(std::uint64_t seed, std::uint64_t stream)
+{
+    m_random.reset(seed, stream);
+}
+
+bool GameCore::setBoardSize(int size, int threadCount)
+{
+    if (size == BoardState::Size) {
+        m_engine.reset();
+    } else {
+        std::unique_ptr<BoardEngine> engine = BoardEngine::create(size, threadCount);
+        if (!engine) {
+            return false;
+        }
+        m_engine = std::move(engine);
+    }
+    newGame();
+    return true;
+}
+
+void GameCore::newGame()
+{
+    m_board = BoardState();
+    if (m_engine) {
+        m_engine->clear();
+    }
+    m_score = 0;
+    m_moveCount = 0;
+    m_gameOver = false;
+
+    // 日志的格式只能表示 4x4 棋盘
+    GameJournalWriter *journal = m_engine ? nullptr : m_journal;
+    m_journaling = journal != nullptr;
+    if (journal) {
+        journal->beginGame();
+    }
+
+    // 添加两个初始方块
+    for (int i = 0; i < 2; ++i) {
+        int exponent = 0;
+        const int cell = addRandomTile(&exponent);
+        if (journal) {
+            journal->recordInitialSpawn(cell, exponent);
+        }
+    }
+}
+
+int GameCore::addRandomTile(int *exponent)
+{
+    PERF_TIME_SCOPE(SpawnTicks);
+    // 4x4 棋盘的空白格子数量直接由位运算得到，无需构建列表
+    const int emptyCount = m_engine ? m_engine->emptyCount() : m_board.emptyCount();
+    if (emptyCount == 0) {
+        return -1;
+    }
+    PERF_COUNT(Spawns);
+
+    // 随机选择一个空白格子
+    const int n = static_cast<int>(m_random.bounded(emptyCount));
+    const int cell = m_engine ? m_engine->nthEmptyCell(n) : m_board.nthEmptyCell(n);
+
+    // 90%概率生成2，10%概率生成4（保存的是指数）
+    const int spawned = m_random.bounded(10) < 9 ? 1 : 2;
+    if (m_engine) {
+        m_engine->setExponent(cell, spawned);
+    } else {
+        m_board.setExponent(cell, spawned);
+    }
+    if (exponent) {
+        *exponent = spawned;
+    }
+    return cell;
+}
+
+bool GameCore::move(Direction direction, std::int64_t *scoreDelta, MoveDelta *delta)
+{
+    if (scoreDelta) {
+        *scoreDelta = 0;
+    }
+    if (delta) {
+        delta->clear();
+    }
+    PERF_COUNT(MovesAttempted);
+    if (m_gameOver) {
+        return false;
+    }
+    if (m_engine) {
+        return moveEngine(direction, scoreDelta, delta);
+    }
+
+    // 移动、合并、再移动在一次查表（或参考实现）中完成；需要方块去向时逐行跟踪
+    int gained = 0;
+    BoardState next;
+    {
+        PERF_TIME_SCOPE(MoveTicks);
+        if (delta) {
+            next = MoveDelta::trace(m_board, direction, delta);
+            // 4x4 的得分不会超过 int
+            gained = static_cast<int>(delta->scoreDelta);
+        } else {
+            next = m_board.moved(direction, m_moveKernel, &gained);
+        }
+    }
+    if (next == m_board) {
+        if (delta) {
+            delta->clear();
+        }
+        return false;
+    }
+
+    // 每次合并少一个方块，所以合并次数就是移动后多出来的空格数
+    PERF_COUNT(MovesApplied);
+    PERF_MERGES(next.emptyCount() - m_board.emptyCount());
+    m_board = next;
+    m_score += gained;
+    ++m_moveCount;
+    if (scoreDelta) {
+        *scoreDelta = gained;
+    }
+
+    int exponent = 0;
+    const int cell = addRandomTile(&exponent);
+    if (delta) {
+        delta->spawnCell = cell;
+        delta->spawnExponent = exponent;
+    }
+    if (m_journaling) {
+        m_journal->recordMove(direction, cell, exponent);
+    }
+
+    if (!canMove()) {
+        m_gameOver = true;
+        if (m_journaling) {
+            m_journal->endGame();
+            m_journaling = false;
+        }
+    }
+    return true;
+}
+
+bool GameCore::moveEngine(Direction direction, std::int64_t *scoreDelta, MoveDelta *delta)
+{
+    std::int64_t gained = 0;
+#ifdef GAME2048_PERF_COUNTERS
+    const int emptyBefore = m_engine->emptyCount();
+#endif
+    bool moved = false;
+    {
+        PERF_TIME_SCOPE(MoveTicks);
+        moved = m_engine->move(direction, &gained, delta);
+    }
+    if (!moved) {
+        if (delta) {
+            delta->clear();
+        }
+        return false;
+    }
+    PERF_COUNT(MovesApplied);
+    PERF_MERGES(m_engine->emptyCount() - emptyBefore);
+
+    m_score += gained;
+    ++m_moveCount;
+    if (scoreDelta) {
+        *scoreDelta = gained;
+    }
+
+    // 大棋盘不记录方块去向，也不报告新方块，界面直接重绘
+    const bool traced = delta && cellCount() <= MoveDelta::MaxCells;
+    int exponent = 0;
+    const int cell = addRandomTile(&exponent);
+    if (traced) {
+        delta->spawnCell = cell;
+        delta->spawnExponent = exponent;
+    }
+
+    if (!canMove()) {
+        m_gameOver = true;
+    }
+    return true;
+}
+
+bool GameCore::previewMove(Direction direction, std::int64_t *scoreDelta, int *emptyAfter) const
+{
+    if (m_engine) {
+        return m_engine->previewMove(direction, scoreDelta, emptyAfter);
+    }
+    int gained = 0;
+    const BoardState next = m_board.moved(direction, m_moveKernel, &gained);
+    if (scoreDelta) {
+        *scoreDelta = gained;
+    }
+    if (emptyAfter) {
+        *emptyAfter = next.emptyCount();
+    }
+    return next != m_board;
+}
+
+void GameCore::setState(BoardState board, int score)
+{
+    // 局面总是 4x4。日志里没有办法表示任意局面，这一局此后不再记录
+    m_engine.reset();
+    m_journaling = false;
+    m_board = board;
+    m_score = score;
+    m_gameOver = !m_board.canMove();
+}
+
+GameSnapshot GameCore::snapshot() const
+{
+    GameSnapshot snapshot;
+    snapshot.board = m_board.bits();
+    snapshot.randomPosition = m_random.position();
+    // 快照只用于 4x4，分数不会超过 int32
+    snapshot.score = static_cast<std::int32_t>(m_score);
+    snapshot.moveCount = m_moveCount;
+    return snapshot;
+}
+
+void GameCore::restore(const GameSnapshot &snapshot)
+{
+    setState(BoardState(snapshot.board), snapshot.score);
+    m_moveCount = snapshot.moveCount;
+    m_random.seek(snapshot.randomPosition);
+}
+
+bool GameCore::saveFile(const std::string &path, std::string *error) const
+{
+    if (m_engine) {
+        if (error) {
+            *error = "only 4x4 games can be saved";
+        }
+        return false;
+    }
+
+    SaveFile save = {};
+    std::memcpy(save.magic, kMagic, sizeof(kMagic));
+    save.version = kVersion;
+    save.byteOrder = kByteOrderMark;
+    save.seed = m_random.seed();
+    save.stream = m_random.stream();
+    save.snapshot = snapshot();
+
+    // 写失败（例如磁盘满）时保留原来的存档
+    return MappedFile::writeFile(path, [&save](std::ostream &file) {
+        file.write(reinterpret_cast<const char *>(&save), sizeof(save));
+    }, error);
+}
+
+bool GameCore::loadFile(const std::string &path, std::string *error)
+{
+    if (m_engine) {
+        if (error) {
+            *error = "only 4x4 games can be loaded";
+        }
+        return false;
+    }
+
+    SaveFile save;
+    std::ifstream file(path, std::ios::binary);
+    if (!file.read(reinterpret_cast<char *>(&save), sizeof(save))
+            || std::memcmp(save.magic, kMagic, sizeof(kMagic)) != 0 || save.version != kVersion) {
+        if (error) {
+            *error = "not a saved game: " + path;
+        }
+        return false;
+    }
+    if (save.byteOrder != kByteOrderMark) {
+        if (error) {
+            *error = "saved game was written on a machine with a different byte order";
+        }
+        return false;
+    }
+
+    m_random.reset(save.seed, save.stream);
+    restore(save.snapshot);
+    return true;
+}
+
+int GameCore::maxTile() const
+{
+    const int exponent = m_engine ? m_engine->maxExponent() : m_board.maxExponent();
+    return exponent == 0 ? 0 : (1 << exponent);
+}
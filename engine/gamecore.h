@@ -0,0 +1,119 @@
+#ifndef GAMECORE_H
+#define GAMECORE_H
+
+#include "boardengine.h"
+#include "boardstate.h"
+#include "counterrng.h"
+#include "gamehistory.h"
+#include "movedelta.h"
+#include "perfcounters.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class GameJournalWriter;
+
+// 不依赖 Qt 的完整游戏规则：棋盘、分数、随机生成方块和结束判定。
+// Game2048 在它外面包了一层信号；命令行工具直接使用它，避免信号和事件循环的开销。
+//
+// 每个实例持有自己的计数器随机数生成器，一局游戏完全由 (seed, stream) 和移动序列决定；
+// 批量模拟时用对局编号作为 stream，各线程得到互相独立且可复现的序列。
+//
+// 默认是 4x4 棋盘，使用 BoardState 位棋盘；setBoardSize() 可以换成其他大小，
+// 此时规则由 BoardEngine 实现。state()、setState()、移动实现选择和对局日志只适用于 4x4。
+class GameCore
+{
+public:
+    using Direction = BoardState::Direction;
+    using MoveKernel = BoardState::MoveKernel;
+
+    GameCore();
+    explicit GameCore(std::uint64_t seed, std::uint64_t stream = 0);
+
+    // 切换到新的随机数序列（从序列开头开始）
+    void seed(std::uint64_t seed, std::uint64_t stream = 0);
+    std::uint64_t seed() const { return m_random.seed(); }
+    std::uint64_t stream() const { return m_random.stream(); }
+    // 已经消耗的随机数个数，配合 setRandomPosition() 可以精确恢复之后的生成序列
+    std::uint64_t randomPosition() const { return m_random.position(); }
+    void setRandomPosition(std::uint64_t position) { m_random.seek(position); }
+    void newGame();
+
+    // 移动成功（棋盘发生变化）时生成新方块并返回 true；scoreDelta 非空时写入本次得分。
+    // delta 非空时同时记录每个方块的去向、合并和新方块（供界面动画使用），移动失败时被清空。
+    bool move(Direction direction, std::int64_t *scoreDelta = nullptr, MoveDelta *delta = nullptr);
+    bool canMove() const
+    {
+        PERF_COUNT(CanMoveCalls);
+        return m_engine ? m_engine->canMove() : m_board.canMove();
+    }
+    // 在随机空格子生成 2 或 4；返回格子序号，没有空格子时返回 -1
+    int addRandomTile(int *exponent = nullptr);
+
+    // 4x4 局面（其他大小的棋盘返回空局面）
+    BoardState state() const { return m_board; }
+    // 直接设置 4x4 局面和分数（用于恢复、分析和基准测试），游戏是否结束由局面决定。
+    // 日志只能表示从开局起的完整对局，所以设置局面后当前对局不再写入日志（见 setJournal()）
+    void setState(BoardState board, int score);
+    // 4x4 对局的完整状态，用于撤销/重做；恢复后之后生成的方块与原来相同。
+    // 恢复同样通过 setState()，日志中的这一局到恢复前为止，之后的移动不再记录
+    GameSnapshot snapshot() const;
+    void restore(const GameSnapshot &snapshot);
+
+    // 把 4x4 对局（随机数的 seed、stream 和当前状态）保存为 56 字节的二进制文件，或从文件恢复；
+    // 当前不是 4x4 棋盘时两者都返回 false
+    bool saveFile(const std::string &path, std::string *error) const;
+    bool loadFile(const std::string &path, std::string *error);
+
+    // 大棋盘的总分可能超过 int（见 BoardEngine::MaxExponent）
+    std::int64_t score() const { return m_score; }
+    bool isGameOver() const { return m_gameOver; }
+    int tileAt(int row, int col) const
+    {
+        const int exponent = exponentAt(row * boardSize() + col);
+        return exponent == 0 ? 0 : (1 << exponent);
+    }
+    int maxTile() const;
+    int moveCount() const { return m_moveCount; }
+
+    // 切换棋盘边长并开始新的一局；大小不受支持时返回 false 且不做改变。
+    // threadCount 只影响大棋盘（见 LargeBoardEngine）的并行移动，0 表示使用硬件线程数。
+    bool setBoardSize(int size, int threadCount = 0);
+    int boardSize() const { return m_engine ? m_engine->size() : BoardState::Size; }
+    int cellCount() const { return boardSize() * boardSize(); }
+    int exponentAt(int cell) const { return m_engine ? m_engine->exponentAt(cell) : m_board.exponentAt(cell); }
+
+    // 不修改局面，计算向某个方向移动能否改变棋盘、得分和移动后的空格数（任意大小的棋盘）
+    bool previewMove(Direction direction, std::int64_t *scoreDelta = nullptr, int *emptyAfter = nullptr) const;
+
+    void setMoveKernel(MoveKernel kernel) { m_moveKernel = kernel; }
+    MoveKernel moveKernel() const { return m_moveKernel; }
+
+    // 设置后，从下一次 newGame() 开始，每局开始、每步移动及其生成的方块都会写入日志；传入 nullptr 关闭记录。
+    // 正在进行的对局开局没有写入日志，不会记录；setState()/restore()/loadFile() 之后的局面也一样，
+    // 日志中被中断的那一局没有结束记录，重放时显示为未完成
+    void setJournal(GameJournalWriter *journal)
+    {
+        m_journal = journal;
+        m_journaling = false;
+    }
+    GameJournalWriter *journal() const { return m_journal; }
+
+private:
+    bool moveEngine(Direction direction, std::int64_t *scoreDelta, MoveDelta *delta);
+
+    BoardState m_board;
+    std::int64_t m_score;
+    int m_moveCount;
+    bool m_gameOver;
+    MoveKernel m_moveKernel;
+    CounterRng m_random;
+    GameJournalWriter *m_journal;
+    // 当前对局从开局起就写入了 m_journal，后续移动可以接着记录
+    bool m_journaling;
+    // 非 4x4 棋盘的规则实现；为空时使用 m_board
+    std::unique_ptr<BoardEngine> m_engine;
+};
+
+#endif // GAMECORE_H
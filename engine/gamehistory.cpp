@@ -0,0 +1,63 @@
+#include "gamehistory.h"
+
+GameHistory::GameHistory(std::size_t capacity)
+    : m_start(0)
+    , m_undoCount(0)
+    , m_redoCount(0)
+{
+    setCapacity(capacity);
+}
+
+void GameHistory::setCapacity(std::size_t capacity)
+{
+    std::vector<GameSnapshot>(capacity).swap(m_entries);
+    clear();
+}
+
+void GameHistory::clear()
+{
+    m_start = 0;
+    m_undoCount = 0;
+    m_redoCount = 0;
+}
+
+void GameHistory::push(const GameSnapshot &before)
+{
+    if (m_entries.empty()) {
+        return;
+    }
+    // 新的移动之后，原来的重做项不再有意义
+    m_redoCount = 0;
+    if (m_undoCount == m_entries.size()) {
+        m_start = slot(1);
+        --m_undoCount;
+    }
+    m_entries[slot(m_undoCount)] = before;
+    ++m_undoCount;
+}
+
+bool GameHistory::undo(const GameSnapshot &current, GameSnapshot *previous)
+{
+    if (m_undoCount == 0) {
+        return false;
+    }
+    --m_undoCount;
+    GameSnapshot &entry = m_entries[slot(m_undoCount)];
+    *previous = entry;
+    entry = current;
+    ++m_redoCount;
+    return true;
+}
+
+bool GameHistory::redo(const GameSnapshot &current, GameSnapshot *next)
+{
+    if (m_redoCount == 0) {
+        return false;
+    }
+    GameSnapshot &entry = m_entries[slot(m_undoCount)];
+    *next = entry;
+    entry = current;
+    ++m_undoCount;
+    --m_redoCount;
+    return true;
+}
@@ -0,0 +1,66 @@
+#ifndef GAMEHISTORY_H
+#define GAMEHISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 4x4 对局在某一步的完整状态。随机数的 seed 和 stream 在一局中不变，只需记录已消耗的随机数个数，
+// 恢复后之后生成的方块与原来完全相同。24 字节，可以直接按值复制。
+struct GameSnapshot
+{
+    std::uint64_t board = 0;
+    std::uint64_t randomPosition = 0;
+    std::int32_t score = 0;
+    std::int32_t moveCount = 0;
+};
+
+static_assert(sizeof(GameSnapshot) == 24, "snapshots are stored by value in the history ring");
+
+// 撤销/重做历史：容量固定的环形缓冲区，撤销栈和重做栈共用同一块内存。
+//
+// 第 [0, undoCount) 项是可以撤销回去的状态（最旧在前），紧接着的 redoCount 项是可以重做的状态。
+// 撤销和重做把当前状态与游标处的一项交换，push() 在游标处写入并丢弃重做项；满了以后覆盖最旧的一项。
+// 所有操作都是 O(1)，不分配内存；内存在 setCapacity() 时一次分配，
+// 固定为 capacity * 24 字节（100 万项为 24,000,000 字节，约 22.9MB）。
+class GameHistory
+{
+public:
+    static constexpr std::size_t BytesPerEntry = sizeof(GameSnapshot);
+
+    explicit GameHistory(std::size_t capacity = 0);
+
+    // 改变容量会清空历史；容量为 0 时不记录
+    void setCapacity(std::size_t capacity);
+    std::size_t capacity() const { return m_entries.size(); }
+    std::size_t memoryBytes() const { return m_entries.size() * BytesPerEntry; }
+
+    void clear();
+    // 记录移动之前的状态
+    void push(const GameSnapshot &before);
+
+    bool canUndo() const { return m_undoCount > 0; }
+    bool canRedo() const { return m_redoCount > 0; }
+    std::size_t undoCount() const { return m_undoCount; }
+    std::size_t redoCount() const { return m_redoCount; }
+
+    // current 存入重做栈，返回上一步的状态
+    bool undo(const GameSnapshot &current, GameSnapshot *previous);
+    // current 存回撤销栈，返回撤销前的状态
+    bool redo(const GameSnapshot &current, GameSnapshot *next);
+
+private:
+    std::size_t slot(std::size_t index) const
+    {
+        const std::size_t position = m_start + index;
+        return position < m_entries.size() ? position : position - m_entries.size();
+    }
+
+    std::vector<GameSnapshot> m_entries;
+    // 最旧一项的位置
+    std::size_t m_start;
+    std::size_t m_undoCount;
+    std::size_t m_redoCount;
+};
+
+#endif // GAMEHISTORY_H
@@ -0,0 +1,290 @@
+#include "gamejournal.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+constexpr std::size_t kReadBufferSize = 64 * 1024;
+
+}
+
+JournalFile::~JournalFile()
+{
+    close();
+}
+
+bool JournalFile::open(const std::string &path, std::string *error)
+{
+    close();
+    m_file = std::fopen(path.c_str(), "wb");
+    if (!m_file) {
+        if (error) {
+            *error = "cannot write " + path + ": " + std::strerror(errno);
+        }
+        return false;
+    }
+    m_path = path;
+    m_error.clear();
+    if (std::fwrite(GameJournal::Magic, 1, sizeof(GameJournal::Magic), m_file) != sizeof(GameJournal::Magic)) {
+        fail("write");
+    }
+    return true;
+}
+
+bool JournalFile::close(std::string *error)
+{
+    if (m_file) {
+        // fwrite() 只写进 stdio 缓冲，磁盘满等错误可能到 fclose() 刷新时才出现
+        if (std::fclose(m_file) != 0) {
+            fail("close");
+        }
+        m_file = nullptr;
+    }
+    if (m_error.empty()) {
+        return true;
+    }
+    if (error) {
+        *error = m_error;
+    }
+    m_error.clear();
+    return false;
+}
+
+void JournalFile::append(const std::uint8_t *data, std::size_t size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file && m_error.empty() && std::fwrite(data, 1, size, m_file) != size) {
+        fail("write");
+    }
+}
+
+void JournalFile::fail(const char *operation)
+{
+    if (m_error.empty()) {
+        m_error = std::string("cannot ") + operation + " journal " + m_path + ": " + std::strerror(errno);
+    }
+}
+
+GameJournalWriter::GameJournalWriter(JournalFile *file, std::size_t flushThreshold)
+    : m_file(file)
+    , m_flushThreshold(flushThreshold)
+{
+    m_buffer.reserve(flushThreshold + 4096);
+}
+
+GameJournalWriter::~GameJournalWriter()
+{
+    flush();
+}
+
+void GameJournalWriter::beginGame()
+{
+    // 只在对局边界写入文件，保证每局的记录连续
+    if (m_buffer.size() >= m_flushThreshold) {
+        flush();
+    }
+    m_buffer.push_back(GameJournal::GameStart);
+}
+
+void GameJournalWriter::recordInitialSpawn(int cell, int exponent)
+{
+    m_buffer.push_back(GameJournal::InitialSpawn | GameJournal::spawnBits(cell, exponent));
+}
+
+void GameJournalWriter::recordMove(BoardState::Direction direction, int cell, int exponent)
+{
+    m_buffer.push_back(static_cast<std::uint8_t>((static_cast<int>(direction) << 5)
+                                                 | GameJournal::spawnBits(cell, exponent)));
+}
+
+void GameJournalWriter::endGame()
+{
+    m_buffer.push_back(GameJournal::GameEnd);
+    if (m_buffer.size() >= m_flushThreshold) {
+        flush();
+    }
+}
+
+void GameJournalWriter::flush()
+{
+    if (!m_buffer.empty() && m_file) {
+        m_file->append(m_buffer.data(), m_buffer.size());
+    }
+    m_buffer.clear();
+}
+
+JournalGame::Position JournalGame::positionAt(int moveCount) const
+{
+    Position position;
+    position.board = m_initial;
+    const int target = moveCount < 0 ? 0 : std::min(moveCount, this->moveCount());
+    replay([&position, target](const Step &step) {
+        if (step.index >= target) {
+            return false;
+        }
+        position.board = step.after;
+        position.score += step.scoreDelta;
+        position.moves = step.index + 1;
+        return true;
+    });
+    return position;
+}
+
+bool JournalGame::verify(std::string *error) const
+{
+    return replay([error](const Step &step) {
+        if (step.afterMove == step.before) {
+            if (error) {
+                *error = "move " + std::to_string(step.index) + " does not change the board";
+            }
+            return false;
+        }
+        if (step.afterMove.exponentAt(step.spawnCell) != 0) {
+            if (error) {
+                *error = "move " + std::to_string(step.index) + " spawns on an occupied cell";
+            }
+            return false;
+        }
+        return true;
+    });
+}
+
+JournalReader::~JournalReader()
+{
+    close();
+}
+
+bool JournalReader::open(const std::string &path, std::string *error)
+{
+    close();
+    m_file = std::fopen(path.c_str(), "rb");
+    if (!m_file) {
+        if (error) {
+            *error = "cannot open " + path + ": " + std::strerror(errno);
+        }
+        return false;
+    }
+
+    char magic[sizeof(GameJournal::Magic)];
+    if (std::fread(magic, 1, sizeof(magic), m_file) != sizeof(magic)
+            || std::memcmp(magic, GameJournal::Magic, sizeof(magic)) != 0) {
+        close();
+        if (error) {
+            *error = path + " is not a game journal";
+        }
+        return false;
+    }
+
+    m_buffer.resize(kReadBufferSize);
+    m_position = 0;
+    m_size = 0;
+    return true;
+}
+
+void JournalReader::close()
+{
+    if (m_file) {
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+}
+
+bool JournalReader::fill()
+{
+    if (m_position < m_size) {
+        return true;
+    }
+    if (!m_file) {
+        return false;
+    }
+    m_size = std::fread(m_buffer.data(), 1, m_buffer.size(), m_file);
+    m_position = 0;
+    return m_size > 0;
+}
+
+int JournalReader::peekByte()
+{
+    return fill() ? m_buffer[m_position] : -1;
+}
+
+int JournalReader::readByte()
+{
+    return fill() ? m_buffer[m_position++] : -1;
+}
+
+bool JournalReader::nextGame(JournalGame *game, std::string *error)
+{
+    if (error) {
+        error->clear();
+    }
+
+    const int start = readByte();
+    if (start < 0) {
+        return false;
+    }
+    if (start != GameJournal::GameStart) {
+        if (error) {
+            *error = "expected the start of a game";
+        }
+        return false;
+    }
+
+    game->m_initial = BoardState();
+    game->m_moves.clear();
+    game->m_finished = false;
+    for (;;) {
+        const int record = peekByte();
+        if (record < 0 || record == GameJournal::GameStart) {
+            // 文件结尾或下一局开始：这一局没有正常结束
+            return true;
+        }
+        readByte();
+
+        if (record == GameJournal::GameEnd) {
+            game->m_finished = true;
+            return true;
+        }
+        if ((record & 0xE0) == GameJournal::InitialSpawn) {
+            game->m_initial.setExponent(record & 0xF, (record & 0x10) ? 2 : 1);
+        } else if ((record & 0x80) == 0) {
+            game->m_moves.push_back(static_cast<std::uint8_t>(record));
+        } else {
+            if (error) {
+                *error = "unknown journal record";
+            }
+            return false;
+        }
+    }
+}
+
+bool JournalReader::skipGames(long long count, std::string *error)
+{
+    if (error) {
+        error->clear();
+    }
+    // 移动记录的最高位总是 0，所以直接扫描对局开始标记即可
+    long long starts = 0;
+    for (;;) {
+        if (!fill()) {
+            return false;
+        }
+        const std::uint8_t *begin = m_buffer.data() + m_position;
+        const std::uint8_t *end = m_buffer.data() + m_size;
+        const std::uint8_t *found = begin;
+        while (found < end) {
+            found = static_cast<const std::uint8_t *>(std::memchr(found, GameJournal::GameStart, end - found));
+            if (!found) {
+                break;
+            }
+            if (starts == count) {
+                m_position = found - m_buffer.data();
+                return true;
+            }
+            ++starts;
+            ++found;
+        }
+        m_position = m_size;
+    }
+}
@@ -0,0 +1,190 @@
+#ifndef GAMEJOURNAL_H
+#define GAMEJOURNAL_H
+
+#include "boardstate.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 对局日志的二进制格式：8 字节文件头 "2048JNL1"，之后每个事件一个字节。
+//
+//   0ddvcccc  一步移动：dd 为方向（Direction 的值），随后在格子 cccc 生成方块，v=1 表示 4，v=0 表示 2
+//   110vcccc  开局时生成的方块（每局两个）
+//   10100000  一局开始
+//   10100001  一局结束（游戏结束时写入；被中途放弃的对局没有这个记录）
+//
+// 每次成功的移动必然生成一个方块，所以一个字节就能完整描述一步，重放时不需要随机数。
+namespace GameJournal {
+
+constexpr char Magic[8] = {'2', '0', '4', '8', 'J', 'N', 'L', '1'};
+constexpr std::uint8_t GameStart = 0xA0;
+constexpr std::uint8_t GameEnd = 0xA1;
+constexpr std::uint8_t InitialSpawn = 0xC0;
+
+inline std::uint8_t spawnBits(int cell, int exponent)
+{
+    return static_cast<std::uint8_t>((exponent == 2 ? 0x10 : 0x00) | (cell & 0xF));
+}
+
+}
+
+// 日志文件。多个写入器（例如每个工作线程一个）可以共享同一个文件：
+// 写入器只在对局边界整块追加，所以每一局的记录在文件中总是连续的。
+class JournalFile
+{
+public:
+    JournalFile() = default;
+    ~JournalFile();
+
+    JournalFile(const JournalFile &) = delete;
+    JournalFile &operator=(const JournalFile &) = delete;
+
+    bool open(const std::string &path, std::string *error);
+    // 关闭文件。打开之后的任何一次写入或最后的关闭失败时返回 false，error 中是第一个错误；
+    // 这时文件中的日志不完整，不能用于重放
+    bool close(std::string *error = nullptr);
+    bool isOpen() const { return m_file != nullptr; }
+
+    // 线程安全。写入失败后不再写入，错误保留到 close() 时报告
+    void append(const std::uint8_t *data, std::size_t size);
+
+private:
+    // 调用时持有 m_mutex（或没有其他线程在使用）
+    void fail(const char *operation);
+
+    std::FILE *m_file = nullptr;
+    std::string m_path;
+    std::string m_error;
+    std::mutex m_mutex;
+};
+
+// 把一局（或多局）的事件编码到内存缓冲区，缓冲区超过阈值时在对局结束处写入文件。
+// 内存占用不超过阈值加上一局的长度。
+class GameJournalWriter
+{
+public:
+    explicit GameJournalWriter(JournalFile *file, std::size_t flushThreshold = 64 * 1024);
+    ~GameJournalWriter();
+
+    GameJournalWriter(const GameJournalWriter &) = delete;
+    GameJournalWriter &operator=(const GameJournalWriter &) = delete;
+
+    void beginGame();
+    void recordInitialSpawn(int cell, int exponent);
+    void recordMove(BoardState::Direction direction, int cell, int exponent);
+    void endGame();
+
+    void flush();
+
+private:
+    JournalFile *m_file;
+    std::size_t m_flushThreshold;
+    std::vector<std::uint8_t> m_buffer;
+};
+
+// 一局的原始记录及其重放。重放只做查表移动和写入已知的方块，不需要随机数也不发信号。
+class JournalGame
+{
+public:
+    using Direction = BoardState::Direction;
+
+    struct Position
+    {
+        BoardState board;
+        int score = 0;
+        int moves = 0;
+    };
+
+    // 每一步的回调参数
+    struct Step
+    {
+        int index;
+        Direction direction;
+        BoardState before;
+        // 移动后、生成新方块前的局面
+        BoardState afterMove;
+        BoardState after;
+        int scoreDelta;
+        int spawnCell;
+        int spawnExponent;
+    };
+
+    BoardState initialState() const { return m_initial; }
+    int moveCount() const { return static_cast<int>(m_moves.size()); }
+    bool isFinished() const { return m_finished; }
+
+    // 重放前 moveCount 步后的局面；moveCount 超出范围时截断到整局
+    Position positionAt(int moveCount) const;
+    Position finalPosition() const { return positionAt(moveCount()); }
+
+    // 依次重放每一步；callback 返回 false 时提前结束
+    template <typename Callback>
+    bool replay(Callback &&callback) const;
+
+    // 检查每一步是否合法（移动改变了棋盘且新方块落在空格子上）
+    bool verify(std::string *error) const;
+
+private:
+    friend class JournalReader;
+
+    BoardState m_initial;
+    std::vector<std::uint8_t> m_moves;
+    bool m_finished = false;
+};
+
+// 顺序读取日志文件，每次只在内存中保留一局
+class JournalReader
+{
+public:
+    JournalReader() = default;
+    ~JournalReader();
+
+    JournalReader(const JournalReader &) = delete;
+    JournalReader &operator=(const JournalReader &) = delete;
+
+    bool open(const std::string &path, std::string *error);
+    void close();
+
+    // 读取下一局；没有更多对局或文件损坏时返回 false（损坏时 error 非空）
+    bool nextGame(JournalGame *game, std::string *error);
+    // 跳过 count 局而不解码
+    bool skipGames(long long count, std::string *error);
+
+private:
+    bool fill();
+    int peekByte();
+    int readByte();
+
+    std::FILE *m_file = nullptr;
+    std::vector<std::uint8_t> m_buffer;
+    std::size_t m_position = 0;
+    std::size_t m_size = 0;
+};
+
+template <typename Callback>
+bool JournalGame::replay(Callback &&callback) const
+{
+    BoardState board = m_initial;
+    for (std::size_t i = 0; i < m_moves.size(); ++i) {
+        const std::uint8_t record = m_moves[i];
+        Step step;
+        step.index = static_cast<int>(i);
+        step.direction = static_cast<Direction>((record >> 5) & 0x3);
+        step.before = board;
+        step.afterMove = board.moved(step.direction, &step.scoreDelta);
+        step.spawnCell = record & 0xF;
+        step.spawnExponent = (record & 0x10) ? 2 : 1;
+        step.after = step.afterMove;
+        step.after.setExponent(step.spawnCell, step.spawnExponent);
+        board = step.after;
+        if (!callback(static_cast<const Step &>(step))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif // GAMEJOURNAL_H
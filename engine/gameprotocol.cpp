@@ -0,0 +1,85 @@
+#include "gameprotocol.h"
+
+namespace {
+
+void putLittle(std::uint8_t *out, std::uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; ++i) {
+        out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+std::uint64_t getLittle(const std::uint8_t *in, int bytes)
+{
+    std::uint64_t value = 0;
+    for (int i = 0; i < bytes; ++i) {
+        value |= std::uint64_t(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+}
+
+namespace GameProtocol {
+
+void writeHeader(std::uint8_t *out, const Header &header)
+{
+    out[0] = header.op;
+    out[1] = header.arg;
+    putLittle(out + 2, header.length, 2);
+    putLittle(out + 4, header.session, 4);
+}
+
+Header readHeader(const std::uint8_t *in)
+{
+    Header header;
+    header.op = in[0];
+    header.arg = in[1];
+    header.length = static_cast<std::uint16_t>(getLittle(in + 2, 2));
+    header.session = static_cast<std::uint32_t>(getLittle(in + 4, 4));
+    return header;
+}
+
+void writeState(std::uint8_t *out, const State &state)
+{
+    putLittle(out, state.board, 8);
+    putLittle(out + 8, state.score, 4);
+    putLittle(out + 12, state.moves, 4);
+    putLittle(out + 16, state.applied, 2);
+    out[18] = state.gameOver ? 1 : 0;
+    out[19] = 0;
+}
+
+State readState(const std::uint8_t *in)
+{
+    State state;
+    state.board = getLittle(in, 8);
+    state.score = static_cast<std::uint32_t>(getLittle(in + 8, 4));
+    state.moves = static_cast<std::uint32_t>(getLittle(in + 12, 4));
+    state.applied = static_cast<std::uint16_t>(getLittle(in + 16, 2));
+    state.gameOver = in[18] != 0;
+    return state;
+}
+
+void appendFrame(std::vector<std::uint8_t> *buffer, const Header &header, const std::uint8_t *payload)
+{
+    const std::size_t offset = buffer->size();
+    buffer->resize(offset + HeaderSize + header.length);
+    writeHeader(buffer->data() + offset, header);
+    for (std::size_t i = 0; i < header.length; ++i) {
+        (*buffer)[offset + HeaderSize + i] = payload[i];
+    }
+}
+
+const char *statusName(std::uint8_t status)
+{
+    switch (status) {
+    case Ok: return "ok";
+    case UnknownSession: return "unknown session";
+    case BadRequest: return "bad request";
+    case SessionLimit: return "session limit reached";
+    }
+    return "unknown status";
+}
+
+}
@@ -0,0 +1,78 @@
+#ifndef GAMEPROTOCOL_H
+#define GAMEPROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 对局服务器（tools/server）的二进制协议，所有整数都是小端序。
+//
+// 请求和响应都是 8 字节的帧头加上 length 字节的负载：
+//
+//   u8 op  u8 arg  u16 length  u32 session
+//
+// 请求的 arg 随操作而定；响应的 op 与请求相同，arg 为 Status。客户端可以连续发送多个请求
+// 而不等待响应（流水线），服务器按收到的顺序逐个响应。
+//
+//   NewGame   session 为 0 时创建新会话，否则在该会话中重新开始；负载为空或 u64 种子
+//   Move      arg 为方向（Direction 的值）
+//   Moves     负载为最多 MaxPayload 个方向，每个一字节，依次执行直到游戏结束
+//   GetState  只返回局面
+//   Close     结束会话；连接断开时它创建的会话也全部结束
+//
+// 除 Close 外，成功的响应负载是 StateSize 字节的 State：
+//
+//   u64 board  u32 score  u32 moves  u16 applied  u8 gameOver  u8 0
+//
+// board 为 BoardState::bits()，applied 为本次请求实际生效的移动数。
+namespace GameProtocol {
+
+constexpr std::size_t HeaderSize = 8;
+constexpr std::size_t StateSize = 20;
+constexpr std::size_t MaxPayload = 4096;
+
+enum Op : std::uint8_t {
+    NewGame = 1,
+    Move = 2,
+    Moves = 3,
+    GetState = 4,
+    Close = 5
+};
+
+enum Status : std::uint8_t {
+    Ok = 0,
+    UnknownSession = 1,
+    BadRequest = 2,
+    SessionLimit = 3
+};
+
+struct Header
+{
+    std::uint8_t op = 0;
+    std::uint8_t arg = 0;
+    std::uint16_t length = 0;
+    std::uint32_t session = 0;
+};
+
+struct State
+{
+    std::uint64_t board = 0;
+    std::uint32_t score = 0;
+    std::uint32_t moves = 0;
+    std::uint16_t applied = 0;
+    bool gameOver = false;
+};
+
+void writeHeader(std::uint8_t *out, const Header &header);
+Header readHeader(const std::uint8_t *in);
+void writeState(std::uint8_t *out, const State &state);
+State readState(const std::uint8_t *in);
+
+// 在 buffer 末尾追加一帧
+void appendFrame(std::vector<std::uint8_t> *buffer, const Header &header, const std::uint8_t *payload);
+
+const char *statusName(std::uint8_t status);
+
+}
+
+#endif // GAMEPROTOCOL_H
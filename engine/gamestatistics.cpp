@@ -0,0 +1,225 @@
+#include "gamestatistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+const double kGamma = (1 + QuantileSketch::RelativeAccuracy) / (1 - QuantileSketch::RelativeAccuracy);
+const double kLogGamma = std::log(kGamma);
+
+// 报告达成率的方块
+const int kReachTiles[] = {2048, 4096, 8192};
+
+int exponentOf(int tile)
+{
+    int exponent = 0;
+    while (tile > 1) {
+        tile >>= 1;
+        ++exponent;
+    }
+    return exponent;
+}
+
+}
+
+void RunningMoments::add(double value)
+{
+    if (m_count == 0) {
+        m_min = value;
+        m_max = value;
+    } else {
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+    ++m_count;
+    const double delta = value - m_mean;
+    m_mean += delta / m_count;
+    m_m2 += delta * (value - m_mean);
+}
+
+void RunningMoments::merge(const RunningMoments &other)
+{
+    if (other.m_count == 0) {
+        return;
+    }
+    if (m_count == 0) {
+        *this = other;
+        return;
+    }
+    const double total = static_cast<double>(m_count + other.m_count);
+    const double delta = other.m_mean - m_mean;
+    m_mean += delta * other.m_count / total;
+    m_m2 += other.m_m2 + delta * delta * m_count * other.m_count / total;
+    m_count += other.m_count;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+double RunningMoments::standardDeviation() const
+{
+    return std::sqrt(variance());
+}
+
+QuantileSketch::QuantileSketch()
+    : m_count(0)
+    , m_min(0)
+    , m_max(0)
+    , m_zeroCount(0)
+{
+    std::memset(m_buckets, 0, sizeof(m_buckets));
+}
+
+int QuantileSketch::bucketIndex(double value)
+{
+    // 第 i 个桶是 (gamma^(i-1), gamma^i]
+    const int index = static_cast<int>(std::ceil(std::log(value) / kLogGamma));
+    return std::min(std::max(index, 0), BucketCount - 1);
+}
+
+double QuantileSketch::bucketValue(int index)
+{
+    // 桶内任何值与它的相对误差都不超过 RelativeAccuracy
+    return 2 * std::pow(kGamma, index) / (kGamma + 1);
+}
+
+void QuantileSketch::add(double value, std::uint64_t count)
+{
+    if (count == 0) {
+        return;
+    }
+    m_min = m_count == 0 ? value : std::min(m_min, value);
+    m_max = m_count == 0 ? value : std::max(m_max, value);
+    m_count += count;
+    if (value < 1) {
+        m_zeroCount += count;
+        return;
+    }
+    m_buckets[bucketIndex(value)] += count;
+}
+
+void QuantileSketch::merge(const QuantileSketch &other)
+{
+    if (other.m_count == 0) {
+        return;
+    }
+    m_min = m_count == 0 ? other.m_min : std::min(m_min, other.m_min);
+    m_max = m_count == 0 ? other.m_max : std::max(m_max, other.m_max);
+    m_count += other.m_count;
+    m_zeroCount += other.m_zeroCount;
+    for (int i = 0; i < BucketCount; ++i) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+}
+
+double QuantileSketch::quantile(double q) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+    // 与模拟器原来的精确分位数一样取最近秩
+    const std::uint64_t rank = static_cast<std::uint64_t>(std::min(std::max(q, 0.0), 1.0) * (m_count - 1) + 0.5);
+    // 桶的代表值可能落在最小值之下或最大值之上（例如 p99 落在最大值所在的桶里）
+    const auto clamp = [this](double value) { return std::min(std::max(value, m_min), m_max); };
+    std::uint64_t seen = m_zeroCount;
+    if (rank < seen) {
+        return clamp(0);
+    }
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += m_buckets[i];
+        if (rank < seen) {
+            return clamp(bucketValue(i));
+        }
+    }
+    return clamp(bucketValue(BucketCount - 1));
+}
+
+GameStatistics::GameStatistics()
+    : m_totalMoves(0)
+{
+    std::memset(m_maxTiles, 0, sizeof(m_maxTiles));
+}
+
+void GameStatistics::add(std::int64_t score, int maxTile, int moves, double seconds)
+{
+    m_score.add(static_cast<double>(score));
+    m_moves.add(moves);
+    m_seconds.add(seconds);
+    m_scoreSketch.add(static_cast<double>(score));
+    m_totalMoves += static_cast<std::uint64_t>(moves);
+    ++m_maxTiles[std::min(exponentOf(maxTile), MaxExponent - 1)];
+}
+
+void GameStatistics::merge(const GameStatistics &other)
+{
+    m_score.merge(other.m_score);
+    m_moves.merge(other.m_moves);
+    m_seconds.merge(other.m_seconds);
+    m_scoreSketch.merge(other.m_scoreSketch);
+    m_totalMoves += other.m_totalMoves;
+    for (int i = 0; i < MaxExponent; ++i) {
+        m_maxTiles[i] += other.m_maxTiles[i];
+    }
+}
+
+void GameStatistics::clear()
+{
+    *this = GameStatistics();
+}
+
+double GameStatistics::reachRate(int tile) const
+{
+    if (games() == 0) {
+        return 0;
+    }
+    std::uint64_t reached = 0;
+    for (int i = exponentOf(tile); i < MaxExponent; ++i) {
+        reached += m_maxTiles[i];
+    }
+    return static_cast<double>(reached) / games();
+}
+
+std::string GameStatistics::toJson(double elapsedSeconds) const
+{
+    char buffer[512];
+    std::string json;
+    std::snprintf(buffer, sizeof(buffer),
+                  "{\"elapsed_seconds\":%.3f,\"games\":%llu,\"games_per_second\":%.1f,"
+                  "\"score\":{\"mean\":%.3f,\"stddev\":%.3f,\"min\":%.0f,\"max\":%.0f,"
+                  "\"p25\":%.0f,\"p50\":%.0f,\"p75\":%.0f,\"p90\":%.0f,\"p99\":%.0f},",
+                  elapsedSeconds, static_cast<unsigned long long>(games()),
+                  elapsedSeconds > 0 ? games() / elapsedSeconds : 0.0,
+                  m_score.mean(), m_score.standardDeviation(), m_score.min(), m_score.max(),
+                  scoreQuantile(0.25), scoreQuantile(0.50), scoreQuantile(0.75), scoreQuantile(0.90),
+                  scoreQuantile(0.99));
+    json += buffer;
+    std::snprintf(buffer, sizeof(buffer),
+                  "\"moves\":{\"mean\":%.3f,\"stddev\":%.3f,\"min\":%.0f,\"max\":%.0f,\"total\":%llu},"
+                  "\"game_ms\":{\"mean\":%.4f,\"stddev\":%.4f,\"max\":%.4f},",
+                  m_moves.mean(), m_moves.standardDeviation(), m_moves.min(), m_moves.max(),
+                  static_cast<unsigned long long>(m_totalMoves),
+                  1000 * m_seconds.mean(), 1000 * m_seconds.standardDeviation(), 1000 * m_seconds.max());
+    json += buffer;
+
+    json += "\"reach\":{";
+    for (std::size_t i = 0; i < sizeof(kReachTiles) / sizeof(kReachTiles[0]); ++i) {
+        std::snprintf(buffer, sizeof(buffer), "%s\"%d\":%.6f", i > 0 ? "," : "", kReachTiles[i],
+                      reachRate(kReachTiles[i]));
+        json += buffer;
+    }
+    json += "},\"max_tile\":{";
+    bool first = true;
+    for (int i = 0; i < MaxExponent; ++i) {
+        if (m_maxTiles[i] == 0) {
+            continue;
+        }
+        std::snprintf(buffer, sizeof(buffer), "%s\"%llu\":%llu", first ? "" : ",",
+                      1ULL << i, static_cast<unsigned long long>(m_maxTiles[i]));
+        json += buffer;
+        first = false;
+    }
+    json += "}}";
+    return json;
+}
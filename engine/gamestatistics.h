@@ -0,0 +1,106 @@
+#ifndef GAMESTATISTICS_H
+#define GAMESTATISTICS_H
+
+#include <cstdint>
+#include <string>
+
+// 流式的对局统计：每局结束时 add() 一次，内存大小固定，与对局数无关。
+// 每个工作线程持有自己的一份，merge() 合并的结果与把所有对局加进同一份完全相同（分位数草图也是），
+// 所以可以随时汇总出快照。
+
+// 均值、方差（Welford 算法）和最值，合并用 Chan 等人的公式
+class RunningMoments
+{
+public:
+    void add(double value);
+    void merge(const RunningMoments &other);
+
+    std::uint64_t count() const { return m_count; }
+    double mean() const { return m_mean; }
+    // 样本方差
+    double variance() const { return m_count > 1 ? m_m2 / (m_count - 1) : 0.0; }
+    double standardDeviation() const;
+    double min() const { return m_min; }
+    double max() const { return m_max; }
+    double sum() const { return m_mean * m_count; }
+
+private:
+    std::uint64_t m_count = 0;
+    double m_mean = 0;
+    double m_m2 = 0;
+    double m_min = 0;
+    double m_max = 0;
+};
+
+// 相对误差有界的分位数草图：非负值按对数分桶，桶边界是 gamma 的幂，gamma = (1 + a) / (1 - a)。
+// 任何分位数的返回值与真实样本值的相对误差不超过 a（RelativeAccuracy）。
+// 桶数固定，覆盖 [1, 2^40)，更大的值计入最后一个桶；合并就是逐桶相加。
+// 另外精确记录最小值和最大值，返回的分位数限制在 [min, max] 内，不会超出实际出现过的范围。
+class QuantileSketch
+{
+public:
+    static constexpr double RelativeAccuracy = 0.01;
+    static constexpr int BucketCount = 1400;
+
+    QuantileSketch();
+
+    // 加入 count 个相同的值
+    void add(double value, std::uint64_t count = 1);
+    void merge(const QuantileSketch &other);
+
+    std::uint64_t count() const { return m_count; }
+    double min() const { return m_min; }
+    double max() const { return m_max; }
+    // q 在 [0, 1] 之间；没有样本时返回 0
+    double quantile(double q) const;
+
+private:
+    static int bucketIndex(double value);
+    static double bucketValue(int index);
+
+    std::uint64_t m_count;
+    double m_min;
+    double m_max;
+    // 小于 1 的值（分数为 0 的对局）
+    std::uint64_t m_zeroCount;
+    std::uint64_t m_buckets[BucketCount];
+};
+
+class GameStatistics
+{
+public:
+    // 最大方块按指数精确计数；大棋盘的方块也不会超过 2^(MaxExponent - 1)
+    static constexpr int MaxExponent = 48;
+
+    GameStatistics();
+
+    // maxTile 为方块数值（2 的幂，0 表示空棋盘），seconds 为这一局的用时；大棋盘的分数可能超过 int
+    void add(std::int64_t score, int maxTile, int moves, double seconds);
+    void merge(const GameStatistics &other);
+    void clear();
+
+    std::uint64_t games() const { return m_score.count(); }
+    const RunningMoments &score() const { return m_score; }
+    const RunningMoments &moves() const { return m_moves; }
+    std::uint64_t totalMoves() const { return m_totalMoves; }
+    const RunningMoments &seconds() const { return m_seconds; }
+    double scoreQuantile(double q) const { return m_scoreSketch.quantile(q); }
+
+    // 最大方块恰好是 2^exponent 的对局数
+    std::uint64_t maxTileCount(int exponent) const { return m_maxTiles[exponent]; }
+    // 最大方块不小于 tile 的对局比例
+    double reachRate(int tile) const;
+
+    // 一行 JSON，elapsedSeconds 为快照时整个运行已经过去的时间
+    std::string toJson(double elapsedSeconds) const;
+
+private:
+    RunningMoments m_score;
+    RunningMoments m_moves;
+    RunningMoments m_seconds;
+    QuantileSketch m_scoreSketch;
+    std::uint64_t m_totalMoves;
+    std::uint64_t m_maxTiles[MaxExponent];
+};
+
+#endif // GAMESTATISTICS_H
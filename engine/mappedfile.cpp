@@ -0,0 +1,186 @@
+#include "mappedfile.h"
+
+#include <cstdio>
+#include <fstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::containsFloats(std::uint64_t offset, std::uint64_t count, std::size_t headerSize,
+                                std::size_t fileSize)
+{
+    if (offset < headerSize || offset % alignof(float) != 0 || offset > fileSize) {
+        return false;
+    }
+    return count <= (fileSize - offset) / sizeof(float);
+}
+
+bool MappedFile::writeFile(const std::string &path, const std::function<void(std::ostream &)> &write,
+                           std::string *error)
+{
+    const std::string temporaryPath = path + ".tmp";
+    std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        if (error) {
+            *error = "cannot write " + temporaryPath;
+        }
+        return false;
+    }
+    write(file);
+    // write() 只写进流缓冲，磁盘满等错误要到 close() 刷新时才出现
+    file.close();
+    if (!file) {
+        std::remove(temporaryPath.c_str());
+        if (error) {
+            *error = "failed writing " + temporaryPath;
+        }
+        return false;
+    }
+    return replace(temporaryPath, path, error);
+}
+
+#ifdef _WIN32
+
+bool MappedFile::replace(const std::string &temporaryPath, const std::string &path, std::string *error)
+{
+    // 目标文件正被映射时 Windows 不允许替换，此时报错而不是改写正在使用的文件
+    if (!MoveFileExA(temporaryPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+        std::remove(temporaryPath.c_str());
+        if (error) {
+            *error = "cannot replace " + path;
+        }
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::open(const std::string &path, std::string *error)
+{
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        if (error) {
+            *error = "cannot open " + path;
+        }
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        if (error) {
+            *error = "cannot map empty file " + path;
+        }
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    const void *view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!view) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        if (error) {
+            *error = "cannot map " + path;
+        }
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = static_cast<const unsigned char *>(view);
+    m_size = static_cast<std::size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+        CloseHandle(m_mapping);
+        CloseHandle(m_file);
+    }
+    m_data = nullptr;
+    m_size = 0;
+    m_file = nullptr;
+    m_mapping = nullptr;
+}
+
+#else
+
+bool MappedFile::replace(const std::string &temporaryPath, const std::string &path, std::string *error)
+{
+    // rename() 原子地把目录项指向新文件，旧文件在最后一个映射解除后才释放
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        const int savedErrno = errno;
+        std::remove(temporaryPath.c_str());
+        if (error) {
+            *error = "cannot replace " + path + ": " + std::strerror(savedErrno);
+        }
+        return false;
+    }
+    return true;
+}
+
+bool MappedFile::open(const std::string &path, std::string *error)
+{
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (error) {
+            *error = "cannot open " + path + ": " + std::strerror(errno);
+        }
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        if (error) {
+            *error = "cannot map empty file " + path;
+        }
+        return false;
+    }
+
+    void *view = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    // 映射建立后即可关闭文件描述符
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        if (error) {
+            *error = "cannot map " + path + ": " + std::strerror(errno);
+        }
+        return false;
+    }
+
+    m_data = static_cast<const unsigned char *>(view);
+    m_size = static_cast<std::size_t>(info.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (m_data) {
+        munmap(const_cast<unsigned char *>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+
+// 只读内存映射文件。多个进程映射同一个文件时共享同一份物理页，
+// 适合几百 MB 的权重表或残局表：只有被访问到的页才会读入内存。
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &path, std::string *error);
+    void close();
+
+    // 用写好的 temporaryPath 替换 path。已经映射 path 的进程继续看到原来的文件（旧 inode），
+    // 不会因为文件被截断或改写而收到 SIGBUS 或读到写了一半的数据。失败时删除 temporaryPath
+    static bool replace(const std::string &temporaryPath, const std::string &path, std::string *error);
+    // 由 write 把完整内容写入 path + ".tmp"，写入和关闭都成功后再 replace() 到 path。
+    // 任何一步失败时 path 保持原样（原来的内容不会被截断），临时文件被删除
+    static bool writeFile(const std::string &path, const std::function<void(std::ostream &)> &write,
+                          std::string *error);
+
+    // 文件头中记录的 [offset, offset + count 个 float) 是否可以直接当作 float 数组读取：
+    // 不与 headerSize 字节的文件头重叠、按 float 对齐（映射的起点按页对齐），并且完全位于 fileSize 之内。
+    // 比较时不做可能溢出的加法和乘法，被改坏的偏移和个数不会绕回成一个“合法”的范围
+    static bool containsFloats(std::uint64_t offset, std::uint64_t count, std::size_t headerSize,
+                               std::size_t fileSize);
+
+    bool isOpen() const { return m_data != nullptr; }
+    const unsigned char *data() const { return m_data; }
+    std::size_t size() const { return m_size; }
+
+private:
+    const unsigned char *m_data = nullptr;
+    std::size_t m_size = 0;
+#ifdef _WIN32
+    void *m_file = nullptr;
+    void *m_mapping = nullptr;
+#endif
+};
+
+#endif // MAPPEDFILE_H
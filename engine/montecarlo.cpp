@@ -0,0 +1,142 @@
+#include "montecarlo.h"
+#include "perfcounters.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+constexpr BoardState::Direction kDirections[] = {
+    BoardState::Direction::Up,
+    BoardState::Direction::Down,
+    BoardState::Direction::Left,
+    BoardState::Direction::Right
+};
+
+// 从刚移动完（尚未生成新方块）的局面开始随机对局，返回这段对局获得的分数
+int rollout(BoardState board, int maxMoves, CounterRng &random, std::uint64_t *moveCount)
+{
+    int score = 0;
+    for (int moves = 0; maxMoves == 0 || moves < maxMoves; ++moves) {
+        const int emptyCount = board.emptyCount();
+        if (emptyCount == 0) {
+            break;
+        }
+        const int cell = board.nthEmptyCell(static_cast<int>(random.bounded(emptyCount)));
+        board.setExponent(cell, random.bounded(10) < 9 ? 1 : 2);
+
+        BoardState options[4];
+        int gains[4];
+        int count = 0;
+        for (BoardState::Direction direction : kDirections) {
+            int gained = 0;
+            const BoardState next = board.moved(direction, &gained);
+            if (next != board) {
+                options[count] = next;
+                gains[count] = gained;
+                ++count;
+            }
+        }
+        if (count == 0) {
+            break;
+        }
+
+        const int choice = static_cast<int>(random.bounded(count));
+        board = options[choice];
+        score += gains[choice];
+        ++*moveCount;
+    }
+    return score;
+}
+
+}
+
+MonteCarloPolicy::MonteCarloPolicy(const Settings &settings, std::uint64_t seed)
+    : m_settings(settings)
+    , m_seed(seed)
+    , m_decision(0)
+    , m_pool(new WorkStealingPool(settings.threads))
+    , m_workers(m_pool->threadCount())
+{
+}
+
+MonteCarloPolicy::~MonteCarloPolicy() = default;
+
+void MonteCarloPolicy::reset(std::uint64_t seed)
+{
+    m_seed = seed;
+    m_decision = 0;
+}
+
+void MonteCarloPolicy::evaluateMoves(BoardState board, double meanScores[4], bool legal[4])
+{
+    BoardState starts[4];
+    int gains[4];
+    for (Direction direction : kDirections) {
+        const int index = static_cast<int>(direction);
+        starts[index] = board.moved(direction, &gains[index]);
+        legal[index] = starts[index] != board;
+        meanScores[index] = 0;
+    }
+
+    for (WorkerState &worker : m_workers) {
+        std::fill(worker.scoreSums, worker.scoreSums + 4, 0.0);
+        worker.moves = 0;
+    }
+
+    // 任务编号 i 对应方向 i / K；不能移动的方向直接跳过
+    const std::uint64_t decisionSeed = CounterRng::mix(m_seed, m_decision++);
+    const int rollouts = std::max(1, m_settings.rolloutsPerMove);
+    const int maxMoves = m_settings.maxRolloutMoves;
+    m_pool->run(static_cast<std::size_t>(4) * rollouts, static_cast<std::size_t>(std::max(1, m_settings.batchSize)),
+                [&](int workerIndex, std::size_t begin, std::size_t end) {
+        WorkerState &worker = m_workers[workerIndex];
+        for (std::size_t i = begin; i < end; ++i) {
+            const int index = static_cast<int>(i / rollouts);
+            if (!legal[index]) {
+                continue;
+            }
+            CounterRng random(decisionSeed, i);
+            worker.scoreSums[index] += gains[index] + rollout(starts[index], maxMoves, random, &worker.moves);
+        }
+    });
+
+    for (const WorkerState &worker : m_workers) {
+        for (int index = 0; index < 4; ++index) {
+            meanScores[index] += worker.scoreSums[index];
+        }
+        m_statistics.rolloutMoves += worker.moves;
+    }
+    for (int index = 0; index < 4; ++index) {
+        if (legal[index]) {
+            meanScores[index] /= rollouts;
+            m_statistics.rollouts += rollouts;
+        }
+    }
+}
+
+Policy::Direction MonteCarloPolicy::chooseMove(const GameCore &game)
+{
+    PERF_TRACE_SCOPE("mc decision");
+    const auto start = std::chrono::steady_clock::now();
+
+    double meanScores[4];
+    bool legal[4];
+    evaluateMoves(game.state(), meanScores, legal);
+
+    Direction best = Direction::Up;
+    double bestScore = -1;
+    for (Direction direction : kDirections) {
+        const int index = static_cast<int>(direction);
+        if (legal[index] && meanScores[index] > bestScore) {
+            best = direction;
+            bestScore = meanScores[index];
+        }
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ++m_statistics.decisions;
+    m_statistics.totalSeconds += seconds;
+    m_statistics.maxDecisionSeconds = std::max(m_statistics.maxDecisionSeconds, seconds);
+    return best;
+}
@@ -0,0 +1,71 @@
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include "policy.h"
+#include "workstealingpool.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 蒙特卡洛随机模拟策略：对每个能移动的方向，从移动后的局面出发做 K 次随机对局，
+// 选择平均总得分最高的方向。
+//
+// 模拟直接在 BoardState 上进行，没有信号和堆分配；K*4 次模拟按批分配到工作窃取线程池，
+// 每个工作线程使用自己的累加器。第 i 次模拟使用以 i 为 stream 的计数器随机数，
+// 所以结果与线程数和任务调度无关。
+class MonteCarloPolicy : public Policy
+{
+public:
+    struct Settings
+    {
+        // 每个方向的模拟次数 K
+        int rolloutsPerMove = 100;
+        // 每次从线程池取走的模拟次数
+        int batchSize = 16;
+        // 单次模拟最多走多少步，0 表示一直走到游戏结束
+        int maxRolloutMoves = 0;
+        // 模拟使用的线程数，0 表示全部核心
+        int threads = 1;
+    };
+
+    struct Statistics
+    {
+        std::uint64_t decisions = 0;
+        std::uint64_t rollouts = 0;
+        std::uint64_t rolloutMoves = 0;
+        double totalSeconds = 0;
+        double maxDecisionSeconds = 0;
+
+        double rolloutsPerSecond() const { return totalSeconds > 0 ? rollouts / totalSeconds : 0; }
+        double meanDecisionSeconds() const { return decisions > 0 ? totalSeconds / decisions : 0; }
+    };
+
+    MonteCarloPolicy(const Settings &settings, std::uint64_t seed);
+    ~MonteCarloPolicy() override;
+
+    const char *name() const override { return "mc"; }
+    void reset(std::uint64_t seed) override;
+    Direction chooseMove(const GameCore &game) override;
+
+    // 对每个方向给出平均得分；不能移动的方向 legal 为 false
+    void evaluateMoves(BoardState board, double meanScores[4], bool legal[4]);
+
+    const Statistics &statistics() const { return m_statistics; }
+
+private:
+    struct alignas(64) WorkerState
+    {
+        double scoreSums[4];
+        std::uint64_t moves;
+    };
+
+    Settings m_settings;
+    std::uint64_t m_seed;
+    std::uint64_t m_decision;
+    std::unique_ptr<WorkStealingPool> m_pool;
+    std::vector<WorkerState> m_workers;
+    Statistics m_statistics;
+};
+
+#endif // MONTECARLO_H
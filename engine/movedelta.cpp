@@ -0,0 +1,65 @@
+#include "movedelta.h"
+
+namespace {
+
+// cells[0] 是移动方向上最靠边的格子
+inline int lineCell(BoardState::Direction direction, int line, int i)
+{
+    switch (direction) {
+    case BoardState::Direction::Up:    return i * 4 + line;
+    case BoardState::Direction::Down:  return (3 - i) * 4 + line;
+    case BoardState::Direction::Left:  return line * 4 + i;
+    case BoardState::Direction::Right: return line * 4 + (3 - i);
+    }
+    return 0;
+}
+
+}
+
+BoardState MoveDelta::trace(BoardState board, Direction direction, MoveDelta *delta)
+{
+    delta->clear();
+    delta->direction = direction;
+
+    BoardState result;
+    for (int line = 0; line < BoardState::Size; ++line) {
+        // target 是下一个方块落下的位置；pending 表示 target - 1 处的方块还可以被合并
+        int target = 0;
+        bool pending = false;
+        int pendingExponent = 0;
+
+        for (int i = 0; i < BoardState::Size; ++i) {
+            const int from = lineCell(direction, line, i);
+            const int exponent = board.exponentAt(from);
+            if (exponent == 0) {
+                continue;
+            }
+
+            int to;
+            bool merged = false;
+            if (pending && exponent == pendingExponent && exponent < BoardState::MaxExponent) {
+                // 与前一个方块合并，合并后的方块不再参与合并
+                to = lineCell(direction, line, target - 1);
+                merged = true;
+                pending = false;
+                result.setExponent(to, exponent + 1);
+                delta->scoreDelta += 1 << (exponent + 1);
+                delta->merges[delta->mergeCount++] = static_cast<std::uint8_t>(to);
+            } else {
+                to = lineCell(direction, line, target++);
+                pending = true;
+                pendingExponent = exponent;
+                result.setExponent(to, exponent);
+            }
+
+            if (from != to) {
+                Slide &slide = delta->slides[delta->slideCount++];
+                slide.from = static_cast<std::uint8_t>(from);
+                slide.to = static_cast<std::uint8_t>(to);
+                slide.exponent = static_cast<std::uint8_t>(exponent);
+                slide.merged = merged;
+            }
+        }
+    }
+    return result;
+}
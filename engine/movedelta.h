@@ -0,0 +1,57 @@
+#ifndef MOVEDELTA_H
+#define MOVEDELTA_H
+
+#include "boardstate.h"
+
+#include <cstdint>
+
+// 一次移动中每个方块的去向、合并位置和新生成的方块，由引擎在执行移动时直接记录。
+// 容量固定（最大到 6x6 棋盘），整个结构可以按值拷贝，记录和读取都不分配内存。
+// 格子序号为 row * 棋盘边长 + col。
+struct MoveDelta
+{
+    using Direction = BoardState::Direction;
+
+    static constexpr int MaxCells = 36;
+
+    // 一个离开原位置的方块；合并时两个方块都滑向同一个目标格子
+    struct Slide
+    {
+        std::uint8_t from;
+        std::uint8_t to;
+        // 移动前的指数
+        std::uint8_t exponent;
+        // 这个方块在目标格子与另一个方块合并
+        bool merged;
+    };
+
+    Direction direction = Direction::Left;
+    std::int64_t scoreDelta = 0;
+
+    // 只包含位置发生变化的方块，按行（列）从靠边的一侧开始排列
+    Slide slides[MaxCells];
+    int slideCount = 0;
+
+    // 数值翻倍的格子（合并后的位置）
+    std::uint8_t merges[MaxCells / 2];
+    int mergeCount = 0;
+
+    // 移动后生成的方块；没有生成时 spawnCell 为 -1
+    int spawnCell = -1;
+    int spawnExponent = 0;
+
+    void clear()
+    {
+        scoreDelta = 0;
+        slideCount = 0;
+        mergeCount = 0;
+        spawnCell = -1;
+        spawnExponent = 0;
+    }
+
+    // 在 4x4 位棋盘上执行移动并记录每个方块的去向，返回移动后（尚未生成新方块）的棋盘。
+    // 结果与 BoardState::moved() 完全一致；每行只扫描一遍，总共 O(16)。
+    static BoardState trace(BoardState board, Direction direction, MoveDelta *delta);
+};
+
+#endif // MOVEDELTA_H
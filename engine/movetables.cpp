@@ -0,0 +1,72 @@
+#include "movetables.h"
+#include "boardstate.h"
+
+#include <memory>
+
+namespace {
+
+std::uint16_t reverseRow(std::uint16_t row)
+{
+    return static_cast<std::uint16_t>(((row & 0x000F) << 12) | ((row & 0x00F0) << 4)
+                                      | ((row & 0x0F00) >> 4) | ((row & 0xF000) >> 12));
+}
+
+std::unique_ptr<RowMoveTables> buildTables()
+{
+    std::unique_ptr<RowMoveTables> tables(new RowMoveTables);
+    for (int row = 0; row < RowMoveTables::RowCount; ++row) {
+        std::uint32_t score = 0;
+        tables->left[row] = slideRowLeft(static_cast<std::uint16_t>(row), &score);
+        tables->leftScore[row] = score;
+
+        // 向右移动等价于把行反转后向左移动，再反转回来
+        const std::uint16_t reversed = reverseRow(static_cast<std::uint16_t>(row));
+        tables->right[row] = reverseRow(slideRowLeft(reversed, &score));
+        tables->rightScore[row] = score;
+    }
+    return tables;
+}
+
+}
+
+std::uint16_t slideRowLeft(std::uint16_t row, std::uint32_t *score)
+{
+    int line[4];
+    for (int i = 0; i < 4; ++i) {
+        line[i] = (row >> (4 * i)) & 0xF;
+    }
+
+    // 先把非空格子靠左压紧
+    int packed[4] = {0, 0, 0, 0};
+    int count = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (line[i] != 0) {
+            packed[count++] = line[i];
+        }
+    }
+
+    // 相邻相同的方块从左到右两两合并，合并后再次压紧
+    int result[4] = {0, 0, 0, 0};
+    int out = 0;
+    std::uint32_t gained = 0;
+    for (int i = 0; i < count; ++i) {
+        if (i + 1 < count && packed[i] == packed[i + 1] && packed[i] < BoardState::MaxExponent) {
+            result[out++] = packed[i] + 1;
+            gained += 1u << (packed[i] + 1);
+            ++i;
+        } else {
+            result[out++] = packed[i];
+        }
+    }
+
+    if (score) {
+        *score = gained;
+    }
+    return static_cast<std::uint16_t>(result[0] | (result[1] << 4) | (result[2] << 8) | (result[3] << 12));
+}
+
+const RowMoveTables &rowMoveTables()
+{
+    static const std::unique_ptr<RowMoveTables> tables = buildTables();
+    return *tables;
+}
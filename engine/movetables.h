@@ -0,0 +1,24 @@
+#ifndef MOVETABLES_H
+#define MOVETABLES_H
+
+#include <cstdint>
+
+// 一行 4 格共 16 位，只有 65536 种状态，因此可以预先算出每种状态向左、向右
+// 移动后的结果和得分。上下移动通过转置复用同一组表。
+struct RowMoveTables
+{
+    static constexpr int RowCount = 1 << 16;
+
+    std::uint16_t left[RowCount];
+    std::uint16_t right[RowCount];
+    std::uint32_t leftScore[RowCount];
+    std::uint32_t rightScore[RowCount];
+};
+
+// 首次调用时生成（约 768KB），之后只读，可被多个线程同时访问
+const RowMoveTables &rowMoveTables();
+
+// 按“移动-合并-再移动”规则计算一行向低位（向左）移动的结果，用于生成查表
+std::uint16_t slideRowLeft(std::uint16_t row, std::uint32_t *score);
+
+#endif // MOVETABLES_H
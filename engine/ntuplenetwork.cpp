@@ -0,0 +1,337 @@
+#include "ntuplenetwork.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+
+namespace {
+
+constexpr BoardState::Direction kDirections[] = {
+    BoardState::Direction::Up,
+    BoardState::Direction::Down,
+    BoardState::Direction::Left,
+    BoardState::Direction::Right
+};
+
+constexpr char kMagic[8] = {'2', '0', '4', '8', 'N', 'T', 'W', '\0'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::uint32_t kByteOrderMark = 0x01020304;
+// 权重从 4KB 处开始，保证映射后按页对齐
+constexpr std::size_t kWeightOffset = 4096;
+// 保存可写副本时每次复制出来写入的权重个数
+constexpr std::size_t kSaveChunk = 64 * 1024;
+
+static_assert(std::atomic<float>::is_always_lock_free, "Hogwild updates need lock-free float atomics");
+static_assert(sizeof(std::atomic<float>) == sizeof(float), "atomic weights must keep the float layout");
+
+// 文件头按本机字节序写入，读取时用 byteOrder 检查
+struct FileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t tupleCount;
+    std::uint32_t tupleLength[NTupleNetwork::MaxTuples];
+    std::uint8_t cells[NTupleNetwork::MaxTuples][NTupleNetwork::MaxTupleLength];
+    std::uint64_t weightOffset;
+    std::uint64_t weightCount;
+};
+
+static_assert(sizeof(FileHeader) <= kWeightOffset, "header must fit before the weights");
+
+// 第 symmetry 种对称变换：低 2 位为顺时针旋转次数，第 3 位表示先左右翻转
+int transformCell(int cell, int symmetry)
+{
+    int row = cell / BoardState::Size;
+    int col = cell % BoardState::Size;
+    if (symmetry & 4) {
+        col = BoardState::Size - 1 - col;
+    }
+    for (int i = 0; i < (symmetry & 3); ++i) {
+        const int rotatedRow = col;
+        col = BoardState::Size - 1 - row;
+        row = rotatedRow;
+    }
+    return row * BoardState::Size + col;
+}
+
+}
+
+std::vector<std::vector<int>> NTupleNetwork::defaultTuples()
+{
+    return {
+        {0, 1, 2, 3, 4, 5},
+        {4, 5, 6, 7, 8, 9},
+        {0, 1, 2, 4, 5, 6},
+        {4, 5, 6, 8, 9, 10}
+    };
+}
+
+bool NTupleNetwork::setTuples(const std::vector<std::vector<int>> &tuples, std::string *error)
+{
+    if (tuples.empty() || tuples.size() > static_cast<std::size_t>(MaxTuples)) {
+        if (error) {
+            *error = "invalid tuple count";
+        }
+        return false;
+    }
+
+    m_tuples.clear();
+    m_tupleCells = tuples;
+    std::size_t offset = 0;
+    for (const std::vector<int> &cells : tuples) {
+        if (cells.empty() || cells.size() > static_cast<std::size_t>(MaxTupleLength)) {
+            if (error) {
+                *error = "invalid tuple length";
+            }
+            return false;
+        }
+
+        Tuple tuple;
+        tuple.length = static_cast<int>(cells.size());
+        tuple.offset = offset;
+        for (int symmetry = 0; symmetry < SymmetryCount; ++symmetry) {
+            for (int k = 0; k < tuple.length; ++k) {
+                if (cells[k] < 0 || cells[k] >= BoardState::CellCount) {
+                    if (error) {
+                        *error = "tuple cell out of range";
+                    }
+                    return false;
+                }
+                tuple.shifts[symmetry][k] = 4 * transformCell(cells[k], symmetry);
+            }
+        }
+        m_tuples.push_back(tuple);
+        offset += std::size_t(1) << (4 * tuple.length);
+    }
+    m_weightCount = offset;
+    return true;
+}
+
+bool NTupleNetwork::initialize(const std::vector<std::vector<int>> &tuples, std::string *error)
+{
+    m_mapping.close();
+    m_weights = nullptr;
+    m_ownedWeights.reset();
+    if (!setTuples(tuples, error)) {
+        return false;
+    }
+    m_ownedWeights.reset(new std::atomic<float>[m_weightCount]);
+    for (std::size_t i = 0; i < m_weightCount; ++i) {
+        m_ownedWeights[i].store(0.0f, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool NTupleNetwork::readHeader(const unsigned char *data, std::size_t size, std::vector<std::vector<int>> *tuples,
+                               std::size_t *weightOffset, std::string *error) const
+{
+    FileHeader header;
+    if (size < sizeof(header)) {
+        if (error) {
+            *error = "file too small";
+        }
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kVersion) {
+        if (error) {
+            *error = "not an n-tuple weight file";
+        }
+        return false;
+    }
+    if (header.byteOrder != kByteOrderMark) {
+        if (error) {
+            *error = "weight file was written on a machine with a different byte order";
+        }
+        return false;
+    }
+    if (header.tupleCount == 0 || header.tupleCount > static_cast<std::uint32_t>(MaxTuples)) {
+        if (error) {
+            *error = "invalid tuple count";
+        }
+        return false;
+    }
+
+    tuples->clear();
+    for (std::uint32_t t = 0; t < header.tupleCount; ++t) {
+        const std::uint32_t length = std::min<std::uint32_t>(header.tupleLength[t], MaxTupleLength);
+        tuples->emplace_back(header.cells[t], header.cells[t] + length);
+    }
+    *weightOffset = static_cast<std::size_t>(header.weightOffset);
+
+    std::size_t expected = 0;
+    for (const std::vector<int> &cells : *tuples) {
+        expected += std::size_t(1) << (4 * cells.size());
+    }
+    if (header.weightCount != expected
+            || !MappedFile::containsFloats(header.weightOffset, expected, sizeof(header), size)) {
+        if (error) {
+            *error = "weight file is truncated or inconsistent";
+        }
+        return false;
+    }
+    return true;
+}
+
+bool NTupleNetwork::mapFile(const std::string &path, std::string *error)
+{
+    m_ownedWeights.reset();
+    m_weights = nullptr;
+    if (!m_mapping.open(path, error)) {
+        return false;
+    }
+
+    std::vector<std::vector<int>> tuples;
+    std::size_t weightOffset = 0;
+    if (!readHeader(m_mapping.data(), m_mapping.size(), &tuples, &weightOffset, error)
+            || !setTuples(tuples, error)) {
+        m_mapping.close();
+        return false;
+    }
+    m_weights = reinterpret_cast<const float *>(m_mapping.data() + weightOffset);
+    return true;
+}
+
+bool NTupleNetwork::loadFile(const std::string &path, std::string *error)
+{
+    if (!mapFile(path, error)) {
+        return false;
+    }
+    // 从映射中复制出可写副本，然后释放映射
+    m_ownedWeights.reset(new std::atomic<float>[m_weightCount]);
+    for (std::size_t i = 0; i < m_weightCount; ++i) {
+        m_ownedWeights[i].store(m_weights[i], std::memory_order_relaxed);
+    }
+    m_mapping.close();
+    m_weights = nullptr;
+    return true;
+}
+
+bool NTupleNetwork::saveFile(const std::string &path, std::string *error) const
+{
+    if (!isValid()) {
+        if (error) {
+            *error = "network has no weights";
+        }
+        return false;
+    }
+
+    FileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byteOrder = kByteOrderMark;
+    header.tupleCount = static_cast<std::uint32_t>(m_tupleCells.size());
+    for (std::size_t t = 0; t < m_tupleCells.size(); ++t) {
+        header.tupleLength[t] = static_cast<std::uint32_t>(m_tupleCells[t].size());
+        for (std::size_t k = 0; k < m_tupleCells[t].size(); ++k) {
+            header.cells[t][k] = static_cast<std::uint8_t>(m_tupleCells[t][k]);
+        }
+    }
+    header.weightOffset = kWeightOffset;
+    header.weightCount = m_weightCount;
+
+    // 评估进程可能正映射着 path，不能原地改写
+    return MappedFile::writeFile(path, [&](std::ostream &file) {
+        std::vector<char> padding(kWeightOffset - sizeof(header), 0);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        writeWeights(file);
+    }, error);
+}
+
+void NTupleNetwork::writeWeights(std::ostream &file) const
+{
+    if (m_ownedWeights) {
+        // 训练线程可能仍在更新，逐个 relaxed 读出；得到的是各权重在某一时刻的值，不是一致的快照
+        std::vector<float> chunk(std::min(kSaveChunk, m_weightCount));
+        for (std::size_t begin = 0; begin < m_weightCount && file; begin += chunk.size()) {
+            const std::size_t count = std::min(chunk.size(), m_weightCount - begin);
+            for (std::size_t i = 0; i < count; ++i) {
+                chunk[i] = m_ownedWeights[begin + i].load(std::memory_order_relaxed);
+            }
+            file.write(reinterpret_cast<const char *>(chunk.data()), static_cast<std::streamsize>(count * sizeof(float)));
+        }
+    } else {
+        file.write(reinterpret_cast<const char *>(m_weights),
+                   static_cast<std::streamsize>(m_weightCount * sizeof(float)));
+    }
+}
+
+template <typename Weight>
+double NTupleNetwork::sumWeights(std::uint64_t bits, Weight weight) const
+{
+    double value = 0;
+    for (const Tuple &tuple : m_tuples) {
+        for (int symmetry = 0; symmetry < SymmetryCount; ++symmetry) {
+            value += weight(tuple.offset + tupleIndex(bits, tuple.shifts[symmetry], tuple.length));
+        }
+    }
+    return value;
+}
+
+double NTupleNetwork::evaluate(BoardState board) const
+{
+    if (m_weights) {
+        const float *weights = m_weights;
+        return sumWeights(board.bits(), [weights](std::size_t index) { return weights[index]; });
+    }
+    // relaxed 读在 x86 和 ARM 上都是普通的 load，只是不再允许编译器假设没有其他线程写入
+    const std::atomic<float> *weights = m_ownedWeights.get();
+    return sumWeights(board.bits(), [weights](std::size_t index) {
+        return weights[index].load(std::memory_order_relaxed);
+    });
+}
+
+void NTupleNetwork::update(BoardState board, float delta)
+{
+    std::atomic<float> *weights = m_ownedWeights.get();
+    const std::uint64_t bits = board.bits();
+    for (const Tuple &tuple : m_tuples) {
+        std::atomic<float> *table = weights + tuple.offset;
+        for (int symmetry = 0; symmetry < SymmetryCount; ++symmetry) {
+            // 有意不用 compare_exchange 循环：冲突时丢失一次更新，而不是让线程在热点权重上反复重试
+            std::atomic<float> &weight = table[tupleIndex(bits, tuple.shifts[symmetry], tuple.length)];
+            weight.store(weight.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+    }
+}
+
+NTuplePolicy::NTuplePolicy(const NTupleNetwork *network)
+    : m_network(network)
+{
+}
+
+bool NTuplePolicy::bestAfterstate(const NTupleNetwork &network, BoardState board, Direction *direction,
+                                  BoardState *afterstate, int *reward)
+{
+    bool found = false;
+    double bestValue = 0;
+    for (Direction candidate : kDirections) {
+        int gained = 0;
+        const BoardState next = board.moved(candidate, &gained);
+        if (next == board) {
+            continue;
+        }
+        const double value = gained + network.evaluate(next);
+        if (!found || value > bestValue) {
+            found = true;
+            bestValue = value;
+            *direction = candidate;
+            *afterstate = next;
+            *reward = gained;
+        }
+    }
+    return found;
+}
+
+Policy::Direction NTuplePolicy::chooseMove(const GameCore &game)
+{
+    Direction direction = Direction::Up;
+    BoardState afterstate;
+    int reward = 0;
+    bestAfterstate(*m_network, game.state(), &direction, &afterstate, &reward);
+    return direction;
+}
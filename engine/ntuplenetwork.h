@@ -0,0 +1,116 @@
+#ifndef NTUPLENETWORK_H
+#define NTUPLENETWORK_H
+
+#include "expectimax.h"
+#include "mappedfile.h"
+#include "policy.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+// N 元组网络评估函数。
+//
+// 每个元组是棋盘上若干个格子，这些格子的方块指数（每格 4 位）拼成索引，
+// 到该元组的权重表中取一个权重；每个元组按棋盘的 8 种对称变换各取一次，全部相加即为估值。
+// 默认的 4 个 6 元组共 4 * 16^6 个 float，约 256MB。
+//
+// 权重可以是进程私有的可写副本（训练用），也可以是只读的内存映射文件：
+// 多个评估进程映射同一个文件时共享同一份物理内存。
+// 可写副本的每个权重是 std::atomic<float>，训练线程之间以 relaxed 方式读写，不构成数据竞争。
+class NTupleNetwork : public BoardEvaluator
+{
+public:
+    static constexpr int MaxTuples = 16;
+    static constexpr int MaxTupleLength = 8;
+    static constexpr int SymmetryCount = 8;
+
+    NTupleNetwork() = default;
+
+    NTupleNetwork(const NTupleNetwork &) = delete;
+    NTupleNetwork &operator=(const NTupleNetwork &) = delete;
+
+    // 常用的 4 个 6 元组（两条直线形、两个 2x3 矩形）
+    static std::vector<std::vector<int>> defaultTuples();
+
+    // 分配全零的可写权重
+    bool initialize(const std::vector<std::vector<int>> &tuples, std::string *error);
+    // 只读映射权重文件，不把整个文件读进内存
+    bool mapFile(const std::string &path, std::string *error);
+    // 读入权重文件的可写副本，用于继续训练
+    bool loadFile(const std::string &path, std::string *error);
+    // 保存为可直接映射的平坦文件：4KB 文件头后紧跟所有权重表
+    bool saveFile(const std::string &path, std::string *error) const;
+
+    bool isValid() const { return m_weights != nullptr || m_ownedWeights != nullptr; }
+    bool isWritable() const { return m_ownedWeights != nullptr; }
+    std::size_t weightCount() const { return m_weightCount; }
+    // 每次估值访问的权重个数（元组数 * 对称数）
+    int featureCount() const { return static_cast<int>(m_tuples.size()) * SymmetryCount; }
+
+    double evaluate(BoardState board) const override;
+
+    // 把 delta 加到该局面访问的每个权重上。多个训练线程同时调用时不加锁
+    // （Hogwild 式更新）：每个权重是一次 relaxed 读和一次 relaxed 写，不是原子的读改写，
+    // 两个线程同时更新同一个权重时其中一次更新会丢失；偶尔丢失的更新不影响收敛，换来线性的扩展性。
+    void update(BoardState board, float delta);
+
+private:
+    struct Tuple
+    {
+        int length;
+        std::size_t offset;
+        // 每种对称变换下各个格子在 64 位棋盘中的位移
+        int shifts[SymmetryCount][MaxTupleLength];
+    };
+
+    bool setTuples(const std::vector<std::vector<int>> &tuples, std::string *error);
+    bool readHeader(const unsigned char *data, std::size_t size, std::vector<std::vector<int>> *tuples,
+                    std::size_t *weightOffset, std::string *error) const;
+    // 把全部权重按文件格式写出
+    void writeWeights(std::ostream &file) const;
+    // 按 weight(index) 取出该局面访问的每个权重并求和
+    template <typename Weight>
+    double sumWeights(std::uint64_t bits, Weight weight) const;
+
+    static std::size_t tupleIndex(std::uint64_t bits, const int *shifts, int length)
+    {
+        std::size_t index = 0;
+        for (int k = 0; k < length; ++k) {
+            index |= static_cast<std::size_t>((bits >> shifts[k]) & 0xF) << (4 * k);
+        }
+        return index;
+    }
+
+    std::vector<Tuple> m_tuples;
+    std::vector<std::vector<int>> m_tupleCells;
+    std::size_t m_weightCount = 0;
+    // 可写副本（initialize() 或 loadFile()），训练线程并发读写
+    std::unique_ptr<std::atomic<float>[]> m_ownedWeights;
+    MappedFile m_mapping;
+    // 映射文件中的只读权重（mapFile()），没有映射时为空
+    const float *m_weights = nullptr;
+};
+
+// 一步贪心策略：选择“合并得分 + 网络对移动后局面的估值”最大的方向
+class NTuplePolicy : public Policy
+{
+public:
+    explicit NTuplePolicy(const NTupleNetwork *network);
+
+    const char *name() const override { return "ntuple"; }
+    Direction chooseMove(const GameCore &game) override;
+
+    // 返回 false 表示没有能移动的方向
+    static bool bestAfterstate(const NTupleNetwork &network, BoardState board, Direction *direction,
+                               BoardState *afterstate, int *reward);
+
+private:
+    const NTupleNetwork *m_network;
+};
+
+#endif // NTUPLENETWORK_H
@@ -0,0 +1,277 @@
+#include "perfcounters.h"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define PERF_HAS_RDTSC 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define PERF_HAS_RDTSC 1
+#endif
+
+namespace {
+
+const char *const kCounterNames[] = {
+    "moves_attempted",
+    "moves_applied",
+    "merges",
+    "spawns",
+    "can_move_calls",
+    "move_ticks",
+    "spawn_ticks"
+};
+
+using Clock = std::chrono::steady_clock;
+
+// 所有时间都相对于进程启动时的这一刻，时间戳计数器的换算也以此为起点
+struct Epoch
+{
+    Clock::time_point time = Clock::now();
+    std::uint64_t ticks = PerfCounters::ticks();
+};
+
+const Epoch &epoch()
+{
+    static const Epoch value;
+    return value;
+}
+
+std::mutex &registryMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+void writeEscaped(std::FILE *file, const char *text)
+{
+    for (; *text; ++text) {
+        const unsigned char c = static_cast<unsigned char>(*text);
+        if (c == '"' || c == '\\') {
+            std::fprintf(file, "\\%c", c);
+        } else if (c < 0x20) {
+            std::fprintf(file, "\\u%04x", c);
+        } else {
+            std::fputc(c, file);
+        }
+    }
+}
+
+}
+
+std::vector<PerfCounters::ThreadData *> &PerfCounters::threads()
+{
+    static std::vector<ThreadData *> list;
+    return list;
+}
+
+std::atomic<bool> PerfTrace::s_recording(false);
+std::size_t PerfTrace::s_capacity = PerfTrace::DefaultEventsPerThread;
+
+PerfCounters::ThreadData *PerfCounters::registerThread()
+{
+    epoch();
+    ThreadData *data = new ThreadData();
+    for (std::atomic<std::uint64_t> &value : data->values) {
+        value.store(0, std::memory_order_relaxed);
+    }
+    for (std::atomic<std::uint64_t> &bucket : data->mergeHistogram) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    for (std::atomic<std::uint64_t> &calls : data->timedCalls) {
+        calls.store(0, std::memory_order_relaxed);
+    }
+    for (std::uint32_t &clock : data->timerClocks) {
+        clock = 0;
+    }
+    data->events = nullptr;
+    data->eventCapacity = 0;
+    data->eventCount = 0;
+    data->droppedEvents = 0;
+
+    std::lock_guard<std::mutex> lock(registryMutex());
+    data->threadId = static_cast<int>(threads().size()) + 1;
+    data->threadName = "thread " + std::to_string(data->threadId);
+    threads().push_back(data);
+    return data;
+}
+
+PerfCounters::Totals PerfCounters::totals()
+{
+    Totals result;
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (const ThreadData *data : threads()) {
+        for (int i = 0; i < CounterCount; ++i) {
+            result.values[i] += data->values[i].load(std::memory_order_relaxed);
+            result.timedCalls[i] += data->timedCalls[i].load(std::memory_order_relaxed);
+        }
+        for (int i = 0; i < MergeBuckets; ++i) {
+            result.mergeHistogram[i] += data->mergeHistogram[i].load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+void PerfCounters::reset()
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (ThreadData *data : threads()) {
+        for (std::atomic<std::uint64_t> &value : data->values) {
+            value.store(0, std::memory_order_relaxed);
+        }
+        for (std::atomic<std::uint64_t> &bucket : data->mergeHistogram) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        for (std::atomic<std::uint64_t> &calls : data->timedCalls) {
+            calls.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+std::uint64_t PerfCounters::ticks()
+{
+#ifdef PERF_HAS_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+#endif
+}
+
+double PerfCounters::ticksToNanoseconds(std::uint64_t ticks)
+{
+#ifdef PERF_HAS_RDTSC
+    // 按从进程开始到现在的实际时钟换算，运行时间越长越准
+    const Epoch &start = epoch();
+    const double elapsedNanoseconds = std::chrono::duration<double, std::nano>(Clock::now() - start.time).count();
+    const std::uint64_t elapsedTicks = PerfCounters::ticks() - start.ticks;
+    if (elapsedTicks == 0) {
+        return 0;
+    }
+    return ticks * (elapsedNanoseconds / elapsedTicks);
+#else
+    return static_cast<double>(ticks);
+#endif
+}
+
+double PerfCounters::meanNanoseconds(const Totals &totals, Counter counter)
+{
+    const std::uint64_t calls = totals.timedCalls[counter];
+    return calls > 0 ? ticksToNanoseconds(totals.values[counter]) / calls : 0.0;
+}
+
+const char *PerfCounters::counterName(Counter counter)
+{
+    return kCounterNames[counter];
+}
+
+void PerfTrace::start(std::size_t eventsPerThread)
+{
+    std::lock_guard<std::mutex> lock(registryMutex());
+    s_capacity = eventsPerThread;
+    for (PerfCounters::ThreadData *data : PerfCounters::threads()) {
+        if (data->eventCapacity != eventsPerThread) {
+            delete[] data->events;
+            data->events = nullptr;
+            data->eventCapacity = 0;
+        }
+        data->eventCount = 0;
+        data->droppedEvents = 0;
+    }
+    s_recording.store(true, std::memory_order_relaxed);
+}
+
+void PerfTrace::stop()
+{
+    s_recording.store(false, std::memory_order_relaxed);
+}
+
+std::int64_t PerfTrace::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch().time).count();
+}
+
+void PerfTrace::record(const char *name, std::int64_t begin, std::int64_t end)
+{
+    PerfCounters::ThreadData &data = PerfCounters::threadData();
+    if (!data.events) {
+        // 只分配不初始化，没有写到的页不占物理内存
+        data.eventCapacity = s_capacity;
+        data.events = new PerfCounters::TraceEvent[data.eventCapacity];
+    }
+    if (data.eventCount == data.eventCapacity) {
+        ++data.droppedEvents;
+        return;
+    }
+    data.events[data.eventCount++] = {name, begin, end - begin};
+}
+
+void PerfTrace::setThreadName(const std::string &name)
+{
+    PerfCounters::ThreadData &data = PerfCounters::threadData();
+    std::lock_guard<std::mutex> lock(registryMutex());
+    data.threadName = name;
+}
+
+std::uint64_t PerfTrace::eventCount()
+{
+    std::uint64_t count = 0;
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (const PerfCounters::ThreadData *data : PerfCounters::threads()) {
+        count += data->eventCount;
+    }
+    return count;
+}
+
+std::uint64_t PerfTrace::droppedEvents()
+{
+    std::uint64_t dropped = 0;
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (const PerfCounters::ThreadData *data : PerfCounters::threads()) {
+        dropped += data->droppedEvents;
+    }
+    return dropped;
+}
+
+bool PerfTrace::writeChromeTrace(const std::string &path, std::string *error)
+{
+    std::FILE *out = std::fopen(path.c_str(), "w");
+    if (!out) {
+        if (error) {
+            *error = "cannot create trace file: " + path;
+        }
+        return false;
+    }
+
+    // 时间单位是微秒；保留三位小数即纳秒精度
+    std::fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    bool first = true;
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (const PerfCounters::ThreadData *data : PerfCounters::threads()) {
+        std::fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"",
+                     first ? "" : ",\n", data->threadId);
+        writeEscaped(out, data->threadName.c_str());
+        std::fprintf(out, "\"}}");
+        first = false;
+
+        for (std::size_t i = 0; i < data->eventCount; ++i) {
+            const PerfCounters::TraceEvent &event = data->events[i];
+            std::fprintf(out, ",\n{\"name\":\"");
+            writeEscaped(out, event.name);
+            std::fprintf(out, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                         data->threadId, event.begin / 1000.0, event.duration / 1000.0);
+        }
+    }
+    std::fprintf(out, "\n]}\n");
+
+    const bool failed = std::ferror(out) != 0;
+    if (std::fclose(out) != 0 || failed) {
+        if (error) {
+            *error = "cannot write trace file: " + path;
+        }
+        return false;
+    }
+    return true;
+}
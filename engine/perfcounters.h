@@ -0,0 +1,233 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 引擎的性能计数器和 Chrome trace 事件。
+//
+// 引擎代码只通过下面的 PERF_* 宏记录。只有定义了 GAME2048_PERF_COUNTERS（qmake 中 CONFIG += perf_counters）
+// 时宏才展开，否则都是空语句，参数也不求值，热路径上没有任何开销。
+//
+// 计数器按线程存放在各自的缓存行里：线程只写自己的计数器（relaxed 读改写，不是带锁的原子加），
+// totals() 汇总所有线程（包括已经退出的）。耗时用时间戳计数器（x86 上为 rdtsc）累计，
+// 汇总时按实际时钟换算成纳秒。读一次时间戳比一步查表移动还贵，所以计时只抽样每个线程
+// 每 TimerSampleInterval 次中的一次，报告的是被抽中的调用的平均耗时。
+//
+// trace 事件是带开始时间和时长的区间（Chrome trace 的 "X" 事件），写入当前线程的缓冲区，
+// 不需要锁；只在 PerfTrace::start() 之后记录，未开始时一个作用域只多一次 relaxed 读。
+// writeChromeTrace() 输出可以直接在 chrome://tracing 或 Perfetto 中打开的 JSON。
+class PerfCounters
+{
+public:
+    enum Counter {
+        // GameCore::move() 的调用次数和真正改变了局面的次数
+        MovesAttempted,
+        MovesApplied,
+        // 合并次数（每次合并少一个方块）
+        Merges,
+        Spawns,
+        CanMoveCalls,
+        // 移动内核（滑动和合并在一次查表或逐行处理中完成）和生成方块的时间戳计数（抽样）
+        MoveTicks,
+        SpawnTicks,
+        CounterCount
+    };
+
+    // 一步中的合并次数分布；4x4 一步最多 8 次合并，更大的棋盘计入最后一个桶
+    static constexpr int MergeBuckets = 9;
+    static constexpr std::uint32_t TimerSampleInterval = 64;
+
+    struct Totals
+    {
+        std::uint64_t values[CounterCount] = {};
+        std::uint64_t mergeHistogram[MergeBuckets] = {};
+        // 计时类计数器被抽中计时的次数
+        std::uint64_t timedCalls[CounterCount] = {};
+
+        std::uint64_t operator[](Counter counter) const { return values[counter]; }
+    };
+
+#ifdef GAME2048_PERF_COUNTERS
+    static constexpr bool CompiledIn = true;
+#else
+    static constexpr bool CompiledIn = false;
+#endif
+
+    static void add(Counter counter, std::uint64_t value)
+    {
+        increment(threadData().values[counter], value);
+    }
+    static void recordMerges(int merges)
+    {
+        ThreadData &data = threadData();
+        increment(data.values[Merges], static_cast<std::uint64_t>(merges));
+        increment(data.mergeHistogram[merges < MergeBuckets ? merges : MergeBuckets - 1], 1);
+    }
+    // 本线程对 counter 的这次计时是否被抽中；每个计数器单独轮转，交替执行的计时不会互相错开
+    static bool sampleTimer(Counter counter)
+    {
+        return (++threadData().timerClocks[counter] & (TimerSampleInterval - 1)) == 0;
+    }
+    static void addTimed(Counter counter, std::uint64_t ticks)
+    {
+        ThreadData &data = threadData();
+        increment(data.values[counter], ticks);
+        increment(data.timedCalls[counter], 1);
+    }
+    // 被抽中的调用的平均耗时（纳秒）
+    static double meanNanoseconds(const Totals &totals, Counter counter);
+
+    // 所有线程的合计
+    static Totals totals();
+    // 所有线程的计数器清零；调用时不应有线程在记录
+    static void reset();
+
+    // 时间戳计数器的当前值
+    static std::uint64_t ticks();
+    static double ticksToNanoseconds(std::uint64_t ticks);
+
+    static const char *counterName(Counter counter);
+
+private:
+    friend class PerfTrace;
+
+    struct TraceEvent
+    {
+        const char *name;
+        std::int64_t begin;
+        std::int64_t duration;
+    };
+
+    // 每个线程一份，第一次使用时创建并登记，线程退出后仍然保留供汇总和输出
+    struct alignas(64) ThreadData
+    {
+        std::atomic<std::uint64_t> values[CounterCount];
+        std::atomic<std::uint64_t> mergeHistogram[MergeBuckets];
+        std::atomic<std::uint64_t> timedCalls[CounterCount];
+        std::uint32_t timerClocks[CounterCount];
+        int threadId;
+        std::string threadName;
+        // 第一次记录时按 PerfTrace 的容量分配
+        TraceEvent *events;
+        std::size_t eventCapacity;
+        std::size_t eventCount;
+        std::uint64_t droppedEvents;
+    };
+
+    // 只有本线程写，用 load + store 代替 fetch_add，避免锁总线
+    static void increment(std::atomic<std::uint64_t> &counter, std::uint64_t value)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static ThreadData &threadData()
+    {
+        static thread_local ThreadData *data = registerThread();
+        return *data;
+    }
+    static ThreadData *registerThread();
+    // 登记过的线程，只增不减；访问时持有 registryMutex()
+    static std::vector<ThreadData *> &threads();
+};
+
+// 累计一个作用域的耗时（抽样）
+class PerfScopedTimer
+{
+public:
+    explicit PerfScopedTimer(PerfCounters::Counter counter)
+        : m_counter(counter)
+        , m_start(PerfCounters::sampleTimer(counter) ? PerfCounters::ticks() : 0)
+    {
+    }
+    ~PerfScopedTimer()
+    {
+        if (m_start != 0) {
+            PerfCounters::addTimed(m_counter, PerfCounters::ticks() - m_start);
+        }
+    }
+
+    PerfScopedTimer(const PerfScopedTimer &) = delete;
+    PerfScopedTimer &operator=(const PerfScopedTimer &) = delete;
+
+private:
+    PerfCounters::Counter m_counter;
+    std::uint64_t m_start;
+};
+
+class PerfTrace
+{
+public:
+    // 每个线程默认最多保存的事件数，超出后丢弃并计数
+    static constexpr std::size_t DefaultEventsPerThread = std::size_t(1) << 20;
+
+    // 清空已有事件并开始记录
+    static void start(std::size_t eventsPerThread = DefaultEventsPerThread);
+    static void stop();
+    static bool isRecording() { return s_recording.load(std::memory_order_relaxed); }
+
+    // 进程内单调时钟（纳秒）
+    static std::int64_t now();
+    // name 必须在输出之前一直有效（通常是字符串字面量）
+    static void record(const char *name, std::int64_t begin, std::int64_t end);
+    // 在 trace 中显示的线程名
+    static void setThreadName(const std::string &name);
+
+    static std::uint64_t eventCount();
+    static std::uint64_t droppedEvents();
+
+    // 调用时不应有线程在记录（例如线程池的 run() 返回之后）
+    static bool writeChromeTrace(const std::string &path, std::string *error);
+
+private:
+    static std::atomic<bool> s_recording;
+    static std::size_t s_capacity;
+};
+
+// 把一个作用域记录为 trace 事件
+class PerfTraceScope
+{
+public:
+    explicit PerfTraceScope(const char *name)
+        : m_name(name)
+        , m_begin(PerfTrace::isRecording() ? PerfTrace::now() : -1)
+    {
+    }
+    ~PerfTraceScope()
+    {
+        if (m_begin >= 0) {
+            PerfTrace::record(m_name, m_begin, PerfTrace::now());
+        }
+    }
+
+    PerfTraceScope(const PerfTraceScope &) = delete;
+    PerfTraceScope &operator=(const PerfTraceScope &) = delete;
+
+private:
+    const char *m_name;
+    std::int64_t m_begin;
+};
+
+#define PERF_CONCAT_IMPL(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_IMPL(a, b)
+
+#ifdef GAME2048_PERF_COUNTERS
+#define PERF_COUNT(counter) PerfCounters::add(PerfCounters::counter, 1)
+#define PERF_ADD(counter, value) PerfCounters::add(PerfCounters::counter, (value))
+#define PERF_MERGES(merges) PerfCounters::recordMerges(merges)
+#define PERF_TIME_SCOPE(counter) PerfScopedTimer PERF_CONCAT(perfTimer, __LINE__)(PerfCounters::counter)
+#define PERF_TRACE_SCOPE(name) PerfTraceScope PERF_CONCAT(perfTrace, __LINE__)(name)
+#define PERF_THREAD_NAME(name) PerfTrace::setThreadName(name)
+#else
+#define PERF_COUNT(counter) ((void)0)
+#define PERF_ADD(counter, value) ((void)0)
+#define PERF_MERGES(merges) ((void)0)
+#define PERF_TIME_SCOPE(counter) ((void)0)
+#define PERF_TRACE_SCOPE(name) ((void)0)
+#define PERF_THREAD_NAME(name) ((void)0)
+#endif
+
+#endif // PERFCOUNTERS_H
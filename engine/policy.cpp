@@ -0,0 +1,113 @@
+#include "policy.h"
+
+#include <utility>
+
+namespace {
+
+constexpr BoardState::Direction kDirections[] = {
+    BoardState::Direction::Up,
+    BoardState::Direction::Down,
+    BoardState::Direction::Left,
+    BoardState::Direction::Right
+};
+
+}
+
+RandomPolicy::RandomPolicy(std::uint64_t seed)
+    : m_random(seed)
+{
+}
+
+Policy::Direction RandomPolicy::chooseMove(const GameCore &game)
+{
+    Direction legal[4];
+    int count = 0;
+    for (Direction direction : kDirections) {
+        if (game.previewMove(direction)) {
+            legal[count++] = direction;
+        }
+    }
+
+    if (count == 0) {
+        return Direction::Up;
+    }
+    return legal[m_random.bounded(count)];
+}
+
+Policy::Direction GreedyPolicy::chooseMove(const GameCore &game)
+{
+    Direction best = Direction::Up;
+    std::int64_t bestScore = -1;
+    int bestEmpty = -1;
+    for (Direction direction : kDirections) {
+        std::int64_t gained = 0;
+        int empty = 0;
+        if (!game.previewMove(direction, &gained, &empty)) {
+            continue;
+        }
+        if (gained > bestScore || (gained == bestScore && empty > bestEmpty)) {
+            best = direction;
+            bestScore = gained;
+            bestEmpty = empty;
+        }
+    }
+    return best;
+}
+
+ScriptedPolicy::ScriptedPolicy(std::vector<Direction> script)
+    : m_script(std::move(script))
+    , m_position(0)
+{
+}
+
+bool ScriptedPolicy::parse(const std::string &text, std::vector<Direction> *script, std::string *error)
+{
+    script->clear();
+    bool comment = false;
+    for (char ch : text) {
+        if (comment) {
+            comment = ch != '\n';
+            continue;
+        }
+        switch (ch) {
+        case 'U': case 'u': script->push_back(Direction::Up); break;
+        case 'D': case 'd': script->push_back(Direction::Down); break;
+        case 'L': case 'l': script->push_back(Direction::Left); break;
+        case 'R': case 'r': script->push_back(Direction::Right); break;
+        case '#': comment = true; break;
+        case ' ': case '\t': case '\r': case '\n': case ',': break;
+        default:
+            if (error) {
+                *error = std::string("unexpected character '") + ch + "' in script";
+            }
+            return false;
+        }
+    }
+
+    if (script->empty()) {
+        if (error) {
+            *error = "script contains no moves";
+        }
+        return false;
+    }
+    return true;
+}
+
+Policy::Direction ScriptedPolicy::chooseMove(const GameCore &game)
+{
+    // 最多尝试一整轮脚本；脚本中的方向都不能移动时，退回到第一个能移动的方向
+    for (std::size_t i = 0; i < m_script.size(); ++i) {
+        const Direction direction = m_script[m_position];
+        m_position = (m_position + 1) % m_script.size();
+        if (game.previewMove(direction)) {
+            return direction;
+        }
+    }
+
+    for (Direction direction : kDirections) {
+        if (game.previewMove(direction)) {
+            return direction;
+        }
+    }
+    return Direction::Up;
+}
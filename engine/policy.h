@@ -0,0 +1,68 @@
+#ifndef POLICY_H
+#define POLICY_H
+
+#include "counterrng.h"
+#include "gamecore.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 自动对局策略：根据当前局面选择下一步方向。
+// 策略对象带有自己的状态（随机数、脚本位置等），不同线程应各自持有实例。
+// 随机、贪心和脚本策略适用于任意大小的棋盘，搜索类策略只支持 4x4。
+class Policy
+{
+public:
+    using Direction = BoardState::Direction;
+
+    virtual ~Policy() = default;
+
+    virtual const char *name() const = 0;
+    // 新的一局开始前调用；需要随机数的策略用 seed 重新设定序列，使对局可以复现
+    virtual void reset(std::uint64_t seed) { (void)seed; }
+    // 只在 game.canMove() 为真时调用，返回的方向必须能改变棋盘
+    virtual Direction chooseMove(const GameCore &game) = 0;
+};
+
+// 在所有能改变棋盘的方向中均匀随机选择
+class RandomPolicy : public Policy
+{
+public:
+    explicit RandomPolicy(std::uint64_t seed);
+
+    const char *name() const override { return "random"; }
+    void reset(std::uint64_t seed) override { m_random.reset(seed, 0); }
+    Direction chooseMove(const GameCore &game) override;
+
+private:
+    CounterRng m_random;
+};
+
+// 选择立即得分最高的方向，得分相同时选择空格子最多的方向
+class GreedyPolicy : public Policy
+{
+public:
+    const char *name() const override { return "greedy"; }
+    Direction chooseMove(const GameCore &game) override;
+};
+
+// 按脚本循环尝试方向，跳过当前不能移动的方向
+class ScriptedPolicy : public Policy
+{
+public:
+    explicit ScriptedPolicy(std::vector<Direction> script);
+
+    // 解析由 U/D/L/R（不区分大小写）组成的脚本，忽略空白，'#' 到行尾为注释
+    static bool parse(const std::string &text, std::vector<Direction> *script, std::string *error);
+
+    const char *name() const override { return "script"; }
+    void reset(std::uint64_t) override { m_position = 0; }
+    Direction chooseMove(const GameCore &game) override;
+
+private:
+    std::vector<Direction> m_script;
+    std::size_t m_position;
+};
+
+#endif // POLICY_H
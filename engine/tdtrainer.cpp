@@ -0,0 +1,127 @@
+#include "tdtrainer.h"
+
+#include <algorithm>
+#include <chrono>
+
+void TDTrainer::Statistics::merge(const Statistics &other)
+{
+    games += other.games;
+    moves += other.moves;
+    updates += other.updates;
+    totalScore += other.totalScore;
+    maxScore = std::max(maxScore, other.maxScore);
+    reached2048 += other.reached2048;
+}
+
+TDTrainer::TDTrainer(NTupleNetwork *network, const Settings &settings)
+    : m_network(network)
+    , m_settings(settings)
+    // 学习率平摊到每次估值访问的所有权重上
+    , m_featureRate(static_cast<float>(settings.learningRate / network->featureCount()))
+    , m_pool(settings.threads)
+    , m_workers(m_pool.threadCount())
+    , m_gamesPlayed(0)
+{
+}
+
+TDTrainer::Statistics TDTrainer::train(std::uint64_t games, std::uint64_t seed)
+{
+    for (Worker &worker : m_workers) {
+        worker.statistics = Statistics();
+    }
+
+    const std::uint64_t firstGame = m_gamesPlayed;
+    const auto start = std::chrono::steady_clock::now();
+    m_pool.run(static_cast<std::size_t>(games), static_cast<std::size_t>(std::max(1, m_settings.batchSize)),
+               [this, firstGame, seed](int index, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            playEpisode(m_workers[index], seed, firstGame + i);
+        }
+    });
+    m_gamesPlayed += games;
+
+    Statistics total;
+    for (const Worker &worker : m_workers) {
+        total.merge(worker.statistics);
+    }
+    total.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return total;
+}
+
+void TDTrainer::playEpisode(Worker &worker, std::uint64_t seed, std::uint64_t gameIndex)
+{
+    GameCore &game = worker.game;
+    game.seed(seed, gameIndex);
+    game.newGame();
+    worker.episode.clear();
+
+    const bool online = m_settings.lambda <= 0.0;
+    bool hasPrevious = false;
+    BoardState previous;
+    for (;;) {
+        BoardState::Direction direction;
+        BoardState afterstate;
+        int reward = 0;
+        if (!NTuplePolicy::bestAfterstate(*m_network, game.state(), &direction, &afterstate, &reward)) {
+            break;
+        }
+
+        if (online) {
+            // TD(0)：V(s'_{t-1}) <- V(s'_{t-1}) + a * (r_t + V(s'_t) - V(s'_{t-1}))
+            if (hasPrevious) {
+                const double error = reward + m_network->evaluate(afterstate) - m_network->evaluate(previous);
+                m_network->update(previous, static_cast<float>(m_featureRate * error));
+                ++worker.statistics.updates;
+            }
+            previous = afterstate;
+            hasPrevious = true;
+        } else {
+            worker.episode.push_back({afterstate, reward});
+        }
+
+        game.move(direction);
+    }
+
+    if (online) {
+        // 最后一个移动后局面之后游戏结束，目标价值为 0
+        if (hasPrevious) {
+            m_network->update(previous, static_cast<float>(m_featureRate * -m_network->evaluate(previous)));
+            ++worker.statistics.updates;
+        }
+    } else {
+        learnFromEpisode(worker);
+    }
+
+    Statistics &statistics = worker.statistics;
+    ++statistics.games;
+    statistics.moves += game.moveCount();
+    // 训练只用 4x4 棋盘，分数不会超过 int
+    const int score = static_cast<int>(game.score());
+    statistics.totalScore += score;
+    statistics.maxScore = std::max(statistics.maxScore, score);
+    if (game.maxTile() >= 2048) {
+        ++statistics.reached2048;
+    }
+}
+
+void TDTrainer::learnFromEpisode(Worker &worker)
+{
+    // 从后向前：G_t = r_{t+1} + (1 - lambda) * V(s'_{t+1}) + lambda * G_{t+1}，终局后回报为 0
+    const double lambda = m_settings.lambda;
+    double nextReturn = 0;
+    double nextValue = 0;
+    int nextReward = 0;
+    for (std::size_t i = worker.episode.size(); i-- > 0;) {
+        const Step &step = worker.episode[i];
+        const bool last = i + 1 == worker.episode.size();
+        const double target = last ? 0.0 : nextReward + (1.0 - lambda) * nextValue + lambda * nextReturn;
+
+        const double value = m_network->evaluate(step.afterstate);
+        m_network->update(step.afterstate, static_cast<float>(m_featureRate * (target - value)));
+        ++worker.statistics.updates;
+
+        nextReturn = target;
+        nextValue = m_network->evaluate(step.afterstate);
+        nextReward = step.reward;
+    }
+}
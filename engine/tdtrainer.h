@@ -0,0 +1,79 @@
+#ifndef TDTRAINER_H
+#define TDTRAINER_H
+
+#include "gamecore.h"
+#include "ntuplenetwork.h"
+#include "workstealingpool.h"
+
+#include <cstdint>
+#include <vector>
+
+// 用自我对弈训练 N 元组网络的时序差分学习器。
+//
+// 策略为一步贪心（合并得分 + 移动后局面的估值），学习目标是移动后局面（afterstate）的价值：
+//   lambda == 0：每走一步立即按 TD(0) 更新上一个移动后局面；
+//   lambda  > 0：一局结束后从后向前计算 lambda 回报，再逐步更新。
+// 多个线程同时对弈并直接写同一份权重，不加锁（Hogwild 式）。
+class TDTrainer
+{
+public:
+    struct Settings
+    {
+        double learningRate = 0.1;
+        double lambda = 0.0;
+        // 0 表示全部核心
+        int threads = 0;
+        // 每次从线程池取走的对局数
+        int batchSize = 1;
+    };
+
+    struct Statistics
+    {
+        std::uint64_t games = 0;
+        std::uint64_t moves = 0;
+        // 对移动后局面价值的更新次数
+        std::uint64_t updates = 0;
+        double totalScore = 0;
+        int maxScore = 0;
+        std::uint64_t reached2048 = 0;
+        double seconds = 0;
+
+        void merge(const Statistics &other);
+        double gamesPerSecond() const { return seconds > 0 ? games / seconds : 0; }
+        double updatesPerSecond() const { return seconds > 0 ? updates / seconds : 0; }
+    };
+
+    // network 必须是可写的（initialize() 或 loadFile() 得到）
+    TDTrainer(NTupleNetwork *network, const Settings &settings);
+
+    int threadCount() const { return m_pool.threadCount(); }
+
+    // 再训练 games 局并返回这一轮的统计；每局的种子由 seed 和累计对局编号决定
+    Statistics train(std::uint64_t games, std::uint64_t seed);
+
+private:
+    struct Step
+    {
+        BoardState afterstate;
+        int reward;
+    };
+
+    struct alignas(64) Worker
+    {
+        GameCore game;
+        std::vector<Step> episode;
+        Statistics statistics;
+    };
+
+    void playEpisode(Worker &worker, std::uint64_t seed, std::uint64_t gameIndex);
+    void learnFromEpisode(Worker &worker);
+
+    NTupleNetwork *m_network;
+    Settings m_settings;
+    float m_featureRate;
+    WorkStealingPool m_pool;
+    std::vector<Worker> m_workers;
+    std::uint64_t m_gamesPlayed;
+};
+
+#endif // TDTRAINER_H
@@ -0,0 +1,340 @@
+#include "transpositiontable.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+// data 的布局：低 32 位为 float 值，之后依次为 6 位深度、3 位方向（方向 + 1，0 表示没有）和 23 位代号
+constexpr int kDepthShift = 32;
+constexpr int kMoveShift = 38;
+constexpr int kGenerationShift = 41;
+constexpr std::uint32_t kMaxGeneration = (1u << 23) - 1;
+
+std::uint64_t pack(float value, int depth, int bestMove, std::uint32_t generation)
+{
+    std::uint32_t valueBits;
+    std::memcpy(&valueBits, &value, sizeof(valueBits));
+    return valueBits
+         | (std::uint64_t(depth) << kDepthShift)
+         | (std::uint64_t(bestMove + 1) << kMoveShift)
+         | (std::uint64_t(generation) << kGenerationShift);
+}
+
+int depthOf(std::uint64_t data)
+{
+    return static_cast<int>((data >> kDepthShift) & 0x3F);
+}
+
+std::uint32_t generationOf(std::uint64_t data)
+{
+    return static_cast<std::uint32_t>(data >> kGenerationShift);
+}
+
+// 每个线程缓存最近用过的几张表中自己的统计：通常只有自己的表和共享表
+constexpr int kCachedTables = 4;
+
+// 计数器只有所属线程写，不需要原子的读改写
+void increment(std::atomic<std::uint64_t> &counter)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+std::uint64_t nextTableId()
+{
+    static std::atomic<std::uint64_t> next(1);
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+void *allocateBuckets(std::size_t bytes, bool *hugePages)
+{
+    *hugePages = false;
+#ifdef _WIN32
+    // 大页需要 SeLockMemoryPrivilege，这里只用普通页
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    void *memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+#ifdef MADV_HUGEPAGE
+    *hugePages = madvise(memory, bytes, MADV_HUGEPAGE) == 0;
+#endif
+    return memory;
+#endif
+}
+
+void freeBuckets(void *memory, std::size_t bytes)
+{
+#ifdef _WIN32
+    (void)bytes;
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, bytes);
+#endif
+}
+
+}
+
+static_assert(sizeof(TranspositionTable::Entry) <= 16, "entries are returned by value");
+
+TranspositionTable::TranspositionTable()
+    : m_buckets(nullptr)
+    , m_bucketCount(0)
+    , m_shift(64)
+    , m_hugePages(false)
+    , m_replacement(Replacement::DepthPreferred)
+    , m_generation(1)
+    , m_id(nextTableId())
+{
+    static_assert(sizeof(Bucket) == BucketBytes, "a bucket must fill exactly one cache line");
+}
+
+TranspositionTable::TranspositionTable(std::size_t bytes, Replacement replacement)
+    : TranspositionTable()
+{
+    m_replacement = replacement;
+    resize(bytes);
+}
+
+TranspositionTable::~TranspositionTable()
+{
+    release();
+}
+
+void TranspositionTable::release()
+{
+    if (m_buckets) {
+        freeBuckets(m_buckets, memoryBytes());
+    }
+    m_buckets = nullptr;
+    m_bucketCount = 0;
+    m_shift = 64;
+    m_hugePages = false;
+}
+
+bool TranspositionTable::resize(std::size_t bytes, std::string *error)
+{
+    release();
+
+    // 至少两个桶，桶数为 2 的幂，用乘法哈希的高位选桶
+    int bits = 1;
+    while ((std::size_t(BucketBytes) << (bits + 1)) <= bytes && bits < 40) {
+        ++bits;
+    }
+    const std::size_t count = std::size_t(1) << bits;
+    void *memory = allocateBuckets(count * BucketBytes, &m_hugePages);
+    if (!memory) {
+        if (error) {
+            *error = "cannot allocate " + std::to_string(count * BucketBytes) + " bytes for the transposition table: "
+                   + std::strerror(errno);
+        }
+        return false;
+    }
+
+    // 新映射的内存全为 0：代号 0 从不使用，所以都是空槽
+    m_buckets = static_cast<Bucket *>(memory);
+    m_bucketCount = count;
+    m_shift = 64 - bits;
+    m_generation.store(1, std::memory_order_relaxed);
+    resetStatistics();
+    return true;
+}
+
+void TranspositionTable::clear()
+{
+    clearSlots();
+    m_generation.store(1, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clearSlots()
+{
+    for (std::size_t i = 0; i < m_bucketCount; ++i) {
+        for (Slot &slot : m_buckets[i].slots) {
+            slot.check.store(0, std::memory_order_relaxed);
+            slot.data.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void TranspositionTable::newSearch()
+{
+    // 多个线程同时调用时只是多跳过几个代号
+    std::uint32_t current = m_generation.load(std::memory_order_relaxed);
+    std::uint32_t next;
+    do {
+        next = current < kMaxGeneration ? current + 1 : 1;
+    } while (!m_generation.compare_exchange_weak(current, next, std::memory_order_relaxed));
+    // 代号回绕时真正清空一次，保证旧表项不会因为代号重复而复活
+    if (next == 1) {
+        clearSlots();
+    }
+}
+
+TranspositionTable::Bucket &TranspositionTable::bucketFor(std::uint64_t key) const
+{
+    return m_buckets[(key * 0x9E3779B97F4A7C15ULL) >> m_shift];
+}
+
+TranspositionTable::ThreadStatistics &TranspositionTable::threadStatistics() const
+{
+    // 命中线程缓存时不加锁。表的编号从不重复，已经销毁的表留下的缓存项不会再被匹配
+    struct CachedStatistics
+    {
+        std::uint64_t table;
+        ThreadStatistics *statistics;
+    };
+    static thread_local CachedStatistics cache[kCachedTables] = {};
+    static thread_local int nextCached = 0;
+    for (const CachedStatistics &cached : cache) {
+        if (cached.table == m_id) {
+            return *cached.statistics;
+        }
+    }
+
+    // 第一次使用这张表，或者缓存项被其他表挤掉了：按线程找回原来的统计，没有时新建。
+    // 退出线程的编号可能被新线程复用，那时新线程接着写同一份统计，仍然只有一个写者
+    ThreadStatistics *statistics = nullptr;
+    {
+        const std::thread::id self = std::this_thread::get_id();
+        std::lock_guard<std::mutex> lock(m_statisticsMutex);
+        for (const std::unique_ptr<ThreadStatistics> &candidate : m_statistics) {
+            if (candidate->thread == self) {
+                statistics = candidate.get();
+                break;
+            }
+        }
+        if (!statistics) {
+            m_statistics.emplace_back(new ThreadStatistics());
+            statistics = m_statistics.back().get();
+            statistics->thread = self;
+        }
+    }
+    cache[nextCached] = {m_id, statistics};
+    nextCached = (nextCached + 1) % kCachedTables;
+    return *statistics;
+}
+
+bool TranspositionTable::probe(std::uint64_t key, Entry *entry) const
+{
+    ThreadStatistics &statistics = threadStatistics();
+    increment(statistics.probes);
+
+    const std::uint32_t generation = m_generation.load(std::memory_order_relaxed);
+    const Bucket &bucket = bucketFor(key);
+    bool full = true;
+    for (const Slot &slot : bucket.slots) {
+        const std::uint64_t data = slot.data.load(std::memory_order_relaxed);
+        const std::uint64_t check = slot.check.load(std::memory_order_relaxed);
+        if (generationOf(data) != generation) {
+            full = false;
+            continue;
+        }
+        if ((check ^ data) != key) {
+            continue;
+        }
+        const std::uint32_t valueBits = static_cast<std::uint32_t>(data);
+        std::memcpy(&entry->value, &valueBits, sizeof(valueBits));
+        entry->depth = depthOf(data);
+        entry->bestMove = static_cast<int>((data >> kMoveShift) & 0x7) - 1;
+        increment(statistics.hits);
+        return true;
+    }
+    if (full) {
+        increment(statistics.collisions);
+    }
+    return false;
+}
+
+void TranspositionTable::store(std::uint64_t key, int depth, float value, int bestMove)
+{
+    ThreadStatistics &statistics = threadStatistics();
+    const std::uint32_t generation = m_generation.load(std::memory_order_relaxed);
+    if (depth > MaxDepth) {
+        depth = MaxDepth;
+    }
+    const std::uint64_t data = pack(value, depth, bestMove, generation);
+
+    // 同一局面的表项原地更新；否则取空槽（包括旧代号的槽），再否则取最浅的槽
+    Bucket &bucket = bucketFor(key);
+    Slot *same = nullptr;
+    Slot *empty = nullptr;
+    Slot *shallowest = nullptr;
+    int shallowestDepth = MaxDepth + 1;
+    for (Slot &slot : bucket.slots) {
+        const std::uint64_t current = slot.data.load(std::memory_order_relaxed);
+        if (generationOf(current) != generation) {
+            if (!empty) {
+                empty = &slot;
+            }
+        } else if ((slot.check.load(std::memory_order_relaxed) ^ current) == key) {
+            same = &slot;
+            shallowestDepth = depthOf(current);
+            break;
+        } else if (depthOf(current) < shallowestDepth) {
+            shallowest = &slot;
+            shallowestDepth = depthOf(current);
+        }
+    }
+
+    Slot *victim = same ? same : empty;
+    if (!victim || same) {
+        if (m_replacement == Replacement::DepthPreferred && shallowestDepth > depth) {
+            increment(statistics.rejected);
+            return;
+        }
+        if (!victim) {
+            victim = shallowest;
+            increment(statistics.overwrites);
+        }
+    }
+    // 两个字分别写入；与其他写者交错时校验不通过，只会损失这一项
+    victim->check.store(key ^ data, std::memory_order_relaxed);
+    victim->data.store(data, std::memory_order_relaxed);
+    increment(statistics.stores);
+}
+
+TranspositionTable::Statistics TranspositionTable::statistics() const
+{
+    Statistics total;
+    std::lock_guard<std::mutex> lock(m_statisticsMutex);
+    for (const std::unique_ptr<ThreadStatistics> &thread : m_statistics) {
+        total.probes += thread->probes.load(std::memory_order_relaxed);
+        total.hits += thread->hits.load(std::memory_order_relaxed);
+        total.collisions += thread->collisions.load(std::memory_order_relaxed);
+        total.stores += thread->stores.load(std::memory_order_relaxed);
+        total.overwrites += thread->overwrites.load(std::memory_order_relaxed);
+        total.rejected += thread->rejected.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void TranspositionTable::resetStatistics()
+{
+    std::lock_guard<std::mutex> lock(m_statisticsMutex);
+    for (const std::unique_ptr<ThreadStatistics> &thread : m_statistics) {
+        thread->probes.store(0, std::memory_order_relaxed);
+        thread->hits.store(0, std::memory_order_relaxed);
+        thread->collisions.store(0, std::memory_order_relaxed);
+        thread->stores.store(0, std::memory_order_relaxed);
+        thread->overwrites.store(0, std::memory_order_relaxed);
+        thread->rejected.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char *TranspositionTable::replacementName(Replacement replacement)
+{
+    switch (replacement) {
+    case Replacement::Always:
+        return "always";
+    case Replacement::DepthPreferred:
+        return "depth";
+    }
+    return "unknown";
+}
@@ -0,0 +1,143 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 固定大小、无锁的置换表，多个搜索线程可以共享同一张表，不用任何互斥锁。
+//
+// 表按 64 字节的桶组织，每个桶 4 个槽，一次查询只访问一个缓存行。每个槽是两个 64 位原子字：
+// data 打包了值（float）、剩余深度、最佳方向和代号，check 存 key ^ data。
+// 读者分别读取两个字并检查 check ^ data == key：写到一半或被并发写坏的槽校验不通过，当作未命中，
+// 所以不需要锁也不会读到拼接出来的表项（Hyatt 的异或技巧）。
+//
+// newSearch() 只增加代号，不清空表：其他代号的表项视为空槽，查询不会返回。
+// 替换策略：Always 总是写入；DepthPreferred 在桶内没有空槽时不用较浅的结果覆盖较深的表项。
+// 两种策略都优先占用空槽，其次是剩余深度最小的槽。
+//
+// Linux 上用匿名映射分配并建议内核使用透明大页（MADV_HUGEPAGE），随机访问的 TLB 缺失更少；
+// 物理页在第一次写入时才分配。
+class TranspositionTable
+{
+public:
+    enum class Replacement {
+        Always,
+        DepthPreferred
+    };
+
+    struct Entry
+    {
+        int depth = 0;
+        float value = 0;
+        // BoardState::Direction 的数值，没有时为 NoMove
+        int bestMove = -1;
+    };
+
+    // 查询和写入的统计。misses = probes - hits；
+    // collisions 为未命中且桶里 4 个槽都被本代的其他局面占用的次数，overwrites 为写入时挤掉本代其他局面的次数
+    struct Statistics
+    {
+        std::uint64_t probes = 0;
+        std::uint64_t hits = 0;
+        std::uint64_t collisions = 0;
+        std::uint64_t stores = 0;
+        std::uint64_t overwrites = 0;
+        // DepthPreferred 拒绝的写入
+        std::uint64_t rejected = 0;
+
+        std::uint64_t misses() const { return probes - hits; }
+        double hitRate() const { return probes > 0 ? static_cast<double>(hits) / probes : 0.0; }
+    };
+
+    static constexpr int SlotsPerBucket = 4;
+    static constexpr std::size_t BucketBytes = 64;
+    static constexpr int MaxDepth = 63;
+    static constexpr int NoMove = -1;
+
+    TranspositionTable();
+    // 按不超过 bytes 的最大的 2 的幂个桶分配
+    explicit TranspositionTable(std::size_t bytes, Replacement replacement = Replacement::DepthPreferred);
+    ~TranspositionTable();
+
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+    // 重新分配并清空；调用时不能有其他线程在使用这张表
+    bool resize(std::size_t bytes, std::string *error = nullptr);
+    // 清空所有槽，O(表大小)
+    void clear();
+    // 开始新的一代：之前写入的表项全部失效，O(1)。可以在其他线程使用这张表时调用，
+    // 它们此前写入的表项随之失效
+    void newSearch();
+
+    void setReplacement(Replacement replacement) { m_replacement = replacement; }
+    Replacement replacement() const { return m_replacement; }
+
+    // 查找本代中 key 的表项。线程安全
+    bool probe(std::uint64_t key, Entry *entry) const;
+    // 写入表项，depth 超过 MaxDepth 时按 MaxDepth 保存。线程安全
+    void store(std::uint64_t key, int depth, float value, int bestMove = NoMove);
+
+    bool isValid() const { return m_buckets != nullptr; }
+    std::size_t bucketCount() const { return m_bucketCount; }
+    std::size_t slotCount() const { return m_bucketCount * SlotsPerBucket; }
+    std::size_t memoryBytes() const { return m_bucketCount * BucketBytes; }
+    // 内核接受了大页建议
+    bool usesHugePages() const { return m_hugePages; }
+
+    // 各线程统计的合计
+    Statistics statistics() const;
+    // 调用时不应有线程在使用这张表，否则清零可能被线程随后写回的旧计数覆盖
+    void resetStatistics();
+
+    static const char *replacementName(Replacement replacement);
+
+private:
+    struct Slot
+    {
+        std::atomic<std::uint64_t> check;
+        std::atomic<std::uint64_t> data;
+    };
+
+    struct alignas(BucketBytes) Bucket
+    {
+        Slot slots[SlotsPerBucket];
+    };
+
+    // 每个使用这张表的线程一份，在自己的缓存行里。只有所属线程写，
+    // 用 relaxed load + store 而不是带锁的 fetch_add；statistics() 读取时可能差几次尚未写回的计数
+    struct alignas(64) ThreadStatistics
+    {
+        std::atomic<std::uint64_t> probes{0};
+        std::atomic<std::uint64_t> hits{0};
+        std::atomic<std::uint64_t> collisions{0};
+        std::atomic<std::uint64_t> stores{0};
+        std::atomic<std::uint64_t> overwrites{0};
+        std::atomic<std::uint64_t> rejected{0};
+        std::thread::id thread;
+    };
+
+    Bucket &bucketFor(std::uint64_t key) const;
+    ThreadStatistics &threadStatistics() const;
+    void clearSlots();
+    void release();
+
+    Bucket *m_buckets;
+    std::size_t m_bucketCount;
+    int m_shift;
+    bool m_hugePages;
+    Replacement m_replacement;
+    std::atomic<std::uint32_t> m_generation;
+    // 区分不同的表（包括先后分配在同一地址的表），线程按它缓存自己的统计
+    const std::uint64_t m_id;
+    mutable std::mutex m_statisticsMutex;
+    mutable std::vector<std::unique_ptr<ThreadStatistics>> m_statistics;
+};
+
+#endif // TRANSPOSITIONTABLE_H
@@ -0,0 +1,162 @@
+#include "workstealingpool.h"
+#include "perfcounters.h"
+
+#include <algorithm>
+#include <string>
+
+WorkStealingPool::WorkStealingPool(int threadCount)
+    : m_threadCount(threadCount > 0 ? threadCount
+                                    : std::max(1, static_cast<int>(std::thread::hardware_concurrency())))
+    , m_queues(new Queue[m_threadCount])
+    , m_generation(0)
+    , m_busyWorkers(0)
+    , m_stopping(false)
+    , m_function(nullptr)
+    , m_batchSize(1)
+    , m_steals(0)
+{
+    // 0 号工作线程由调用 run() 的线程担任
+    for (int worker = 1; worker < m_threadCount; ++worker) {
+        m_threads.emplace_back(&WorkStealingPool::workerLoop, this, worker);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::run(std::size_t itemCount, std::size_t batchSize, const RangeFunction &function)
+{
+    if (itemCount == 0) {
+        return;
+    }
+
+    // 初始时平均切分，后续由窃取来修正不均衡
+    for (int worker = 0; worker < m_threadCount; ++worker) {
+        Queue &queue = m_queues[worker];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.begin = itemCount * worker / m_threadCount;
+        queue.end = itemCount * (worker + 1) / m_threadCount;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_function = &function;
+        m_batchSize = std::max<std::size_t>(1, batchSize);
+        m_steals = 0;
+        m_busyWorkers = m_threadCount;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    drain(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_finished.wait(lock, [this]() { return m_busyWorkers == 0; });
+    m_function = nullptr;
+}
+
+void WorkStealingPool::workerLoop(int worker)
+{
+    PERF_THREAD_NAME("pool worker " + std::to_string(worker));
+    std::uint64_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&]() { return m_stopping || m_generation != seenGeneration; });
+            if (m_stopping) {
+                return;
+            }
+            seenGeneration = m_generation;
+        }
+        drain(worker);
+    }
+}
+
+void WorkStealingPool::drain(int worker)
+{
+    std::uint64_t random = 0x9E3779B97F4A7C15ULL * (worker + 1);
+    std::size_t begin = 0;
+    std::size_t end = 0;
+    for (;;) {
+        while (takeOwn(worker, &begin, &end)) {
+            PERF_TRACE_SCOPE("batch");
+            (*m_function)(worker, begin, end);
+        }
+        PERF_TRACE_SCOPE("steal");
+        if (!steal(worker, &random)) {
+            break;
+        }
+    }
+
+    // 任务只会减少不会增加，所有队列都空了就可以退出
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_busyWorkers == 0) {
+        m_finished.notify_all();
+    }
+}
+
+bool WorkStealingPool::takeOwn(int worker, std::size_t *begin, std::size_t *end)
+{
+    Queue &queue = m_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.begin >= queue.end) {
+        return false;
+    }
+    *begin = queue.begin;
+    *end = std::min(queue.end, queue.begin + m_batchSize);
+    queue.begin = *end;
+    return true;
+}
+
+bool WorkStealingPool::steal(int worker, std::uint64_t *random)
+{
+    // xorshift 选择起始受害者，避免所有线程同时去偷同一个队列
+    *random ^= *random << 13;
+    *random ^= *random >> 7;
+    *random ^= *random << 17;
+    const int start = static_cast<int>(*random % m_threadCount);
+
+    for (int i = 0; i < m_threadCount; ++i) {
+        const int victim = (start + i) % m_threadCount;
+        if (victim == worker) {
+            continue;
+        }
+
+        std::size_t stolenBegin = 0;
+        std::size_t stolenEnd = 0;
+        {
+            Queue &queue = m_queues[victim];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.begin >= queue.end) {
+                continue;
+            }
+            // 从尾部偷走一半（至少一个任务）
+            const std::size_t remaining = queue.end - queue.begin;
+            stolenBegin = queue.end - std::max<std::size_t>(1, remaining / 2);
+            stolenEnd = queue.end;
+            queue.end = stolenBegin;
+        }
+
+        {
+            Queue &own = m_queues[worker];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            own.begin = stolenBegin;
+            own.end = stolenEnd;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_steals;
+        }
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,70 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 面向批量任务的工作窃取线程池。
+//
+// run() 把 [0, itemCount) 平均分给每个工作线程的本地队列，线程按 batchSize 从自己队列的
+// 头部取任务；本地队列空了就随机挑一个线程，从它队列的尾部偷走一半剩余任务。
+// 每个队列只有一把很少发生竞争的锁，没有全局任务队列。
+//
+// 回调的第一个参数是工作线程编号（0 .. threadCount()-1），调用方可以据此使用
+// 每线程独立的引擎实例和结果缓冲区，最后再合并。
+class WorkStealingPool
+{
+public:
+    using RangeFunction = std::function<void(int worker, std::size_t begin, std::size_t end)>;
+
+    // threadCount 为 0 时使用硬件线程数
+    explicit WorkStealingPool(int threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    int threadCount() const { return m_threadCount; }
+
+    // 阻塞直到所有任务完成；调用线程作为 0 号工作线程参与计算。不可重入。
+    void run(std::size_t itemCount, std::size_t batchSize, const RangeFunction &function);
+
+    // 本次 run() 中通过窃取获得的任务段数，用于观察负载是否均衡
+    std::uint64_t steals() const { return m_steals; }
+
+private:
+    struct alignas(64) Queue
+    {
+        std::mutex mutex;
+        std::size_t begin = 0;
+        std::size_t end = 0;
+    };
+
+    void workerLoop(int worker);
+    void drain(int worker);
+    bool takeOwn(int worker, std::size_t *begin, std::size_t *end);
+    bool steal(int worker, std::uint64_t *random);
+
+    int m_threadCount;
+    std::unique_ptr<Queue[]> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    std::uint64_t m_generation;
+    int m_busyWorkers;
+    bool m_stopping;
+
+    const RangeFunction *m_function;
+    std::size_t m_batchSize;
+    std::uint64_t m_steals;
+};
+
+#endif // WORKSTEALINGPOOL_H
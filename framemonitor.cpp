@@ -0,0 +1,277 @@
+#include "framemonitor.h"
+#include <QFile>
+#include <QTextStream>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+const char *const kMetricNames[] = {
+    "key_to_state",
+    "state_to_first_paint",
+    "key_to_final_frame",
+    "paint_time",
+    "frame_interval"
+};
+
+const char *const kMetricLabels[] = {
+    "key -> state",
+    "state -> paint",
+    "key -> final",
+    "paint",
+    "frame"
+};
+
+double toMilliseconds(qint64 nanoseconds)
+{
+    return nanoseconds / 1e6;
+}
+
+// 已排序样本的 q 分位数（最近秩）
+double percentile(const std::vector<qint64> &sorted, double q)
+{
+    const std::size_t rank = static_cast<std::size_t>(q * (sorted.size() - 1) + 0.5);
+    return toMilliseconds(sorted[rank]);
+}
+
+}
+
+FrameMonitor::FrameMonitor()
+    : m_refreshRate(60.0)
+    , m_framePeriod(1000000000 / 60)
+{
+    m_clock.start();
+    reset();
+}
+
+void FrameMonitor::setRefreshRate(qreal hz)
+{
+    if (hz <= 0) {
+        return;
+    }
+    m_refreshRate = hz;
+    m_framePeriod = static_cast<qint64>(1e9 / hz);
+}
+
+void FrameMonitor::reset()
+{
+    for (Series &series : m_series) {
+        series.count = 0;
+        series.total = 0;
+        series.max = 0;
+    }
+    m_stateTime = -1;
+    m_finalInputTime = -1;
+    m_awaitingFinalFrame = false;
+    m_animating = false;
+    m_lastFrameTime = -1;
+    m_framesPainted = 0;
+    m_droppedFrames = 0;
+    m_animations = 0;
+    m_tileRenders = 0;
+    m_geometryUpdates = 0;
+}
+
+void FrameMonitor::record(Metric metric, qint64 nanoseconds)
+{
+    Series &series = m_series[metric];
+    series.samples[series.count % SampleCapacity] = nanoseconds;
+    ++series.count;
+    series.total += nanoseconds;
+    series.max = qMax(series.max, nanoseconds);
+}
+
+void FrameMonitor::stateChanged(qint64 inputTime)
+{
+    const qint64 time = now();
+    if (inputTime >= 0) {
+        record(KeyToState, time - inputTime);
+    }
+    // 上一步还没画出末帧就被新的一步取代（快进）时，上一步的末帧不再计入
+    m_stateTime = time;
+    m_finalInputTime = inputTime;
+    m_awaitingFinalFrame = true;
+}
+
+void FrameMonitor::animationStarted()
+{
+    ++m_animations;
+    m_animating = true;
+    m_awaitingFinalFrame = false;
+    m_lastFrameTime = -1;
+}
+
+void FrameMonitor::animationFinished()
+{
+    m_animating = false;
+    m_awaitingFinalFrame = true;
+}
+
+void FrameMonitor::framePainted(qint64 paintStart)
+{
+    const qint64 time = now();
+    ++m_framesPainted;
+    record(PaintTime, time - paintStart);
+
+    if (m_stateTime >= 0) {
+        record(StateToFirstPaint, time - m_stateTime);
+        m_stateTime = -1;
+    }
+    if (m_awaitingFinalFrame) {
+        if (m_finalInputTime >= 0) {
+            record(KeyToFinalFrame, time - m_finalInputTime);
+        }
+        m_finalInputTime = -1;
+        m_awaitingFinalFrame = false;
+    }
+
+    if (m_animating) {
+        if (m_lastFrameTime >= 0) {
+            const qint64 interval = time - m_lastFrameTime;
+            record(FrameInterval, interval);
+            // 间隔超过 1.5 个周期说明中间至少错过了一次刷新
+            if (interval * 2 > m_framePeriod * 3) {
+                m_droppedFrames += static_cast<quint64>((interval + m_framePeriod / 2) / m_framePeriod - 1);
+            }
+        }
+        m_lastFrameTime = time;
+    }
+}
+
+FrameMonitor::Summary FrameMonitor::summary(Metric metric) const
+{
+    const Series &series = m_series[metric];
+    Summary result;
+    result.count = series.count;
+    if (series.count == 0) {
+        return result;
+    }
+    result.mean = toMilliseconds(series.total) / series.count;
+    result.max = toMilliseconds(series.max);
+
+    const std::size_t kept = static_cast<std::size_t>(qMin<quint64>(series.count, SampleCapacity));
+    std::vector<qint64> sorted(series.samples, series.samples + kept);
+    std::sort(sorted.begin(), sorted.end());
+    result.p50 = percentile(sorted, 0.50);
+    result.p95 = percentile(sorted, 0.95);
+    result.p99 = percentile(sorted, 0.99);
+    return result;
+}
+
+const char *FrameMonitor::metricName(Metric metric)
+{
+    return kMetricNames[metric];
+}
+
+QString FrameMonitor::overlayText() const
+{
+    QString text = QString("%1 %2 %3 %4\n")
+            .arg("ms", -15).arg("p50", 7).arg("p95", 7).arg("max", 7);
+    for (int i = 0; i < MetricCount; ++i) {
+        const Summary s = summary(static_cast<Metric>(i));
+        text += QString("%1 %2 %3 %4\n")
+                .arg(kMetricLabels[i], -15)
+                .arg(s.p50, 7, 'f', 2)
+                .arg(s.p95, 7, 'f', 2)
+                .arg(s.max, 7, 'f', 2);
+    }
+    text += QString("frames %1  dropped %2 @%3Hz\n")
+            .arg(m_framesPainted).arg(m_droppedFrames).arg(m_refreshRate, 0, 'f', 0);
+    text += QString("tile renders %1  layouts %2")
+            .arg(m_tileRenders).arg(m_geometryUpdates);
+    return text;
+}
+
+bool FrameMonitor::writeCsv(const QString &path, QString *error) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "metric,count,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+    for (int i = 0; i < MetricCount; ++i) {
+        const Summary s = summary(static_cast<Metric>(i));
+        out << kMetricNames[i] << ',' << s.count << ','
+            << QString::number(s.mean, 'f', 4) << ',' << QString::number(s.p50, 'f', 4) << ','
+            << QString::number(s.p95, 'f', 4) << ',' << QString::number(s.p99, 'f', 4) << ','
+            << QString::number(s.max, 'f', 4) << '\n';
+    }
+    out << "frames_painted," << m_framesPainted << ",,,,,\n";
+    out << "dropped_frames," << m_droppedFrames << ",,,,,\n";
+    out << "animations," << m_animations << ",,,,,\n";
+    out << "tile_renders," << m_tileRenders << ",,,,,\n";
+    out << "geometry_updates," << m_geometryUpdates << ",,,,,\n";
+    out.flush();
+
+    if (file.error() != QFileDevice::NoError) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool FrameMonitor::writeJson(const QString &path, QString *error) const
+{
+    QJsonObject metrics;
+    for (int i = 0; i < MetricCount; ++i) {
+        const Series &series = m_series[i];
+        const Summary s = summary(static_cast<Metric>(i));
+
+        // 样本按记录顺序输出（环形缓冲区从最旧的开始）
+        QJsonArray samples;
+        const quint64 kept = qMin<quint64>(series.count, SampleCapacity);
+        for (quint64 j = series.count - kept; j < series.count; ++j) {
+            samples.append(toMilliseconds(series.samples[j % SampleCapacity]));
+        }
+
+        QJsonObject metric;
+        metric["count"] = static_cast<double>(s.count);
+        metric["mean_ms"] = s.mean;
+        metric["p50_ms"] = s.p50;
+        metric["p95_ms"] = s.p95;
+        metric["p99_ms"] = s.p99;
+        metric["max_ms"] = s.max;
+        metric["samples_ms"] = samples;
+        metrics[kMetricNames[i]] = metric;
+    }
+
+    QJsonObject counters;
+    counters["frames_painted"] = static_cast<double>(m_framesPainted);
+    counters["dropped_frames"] = static_cast<double>(m_droppedFrames);
+    counters["animations"] = static_cast<double>(m_animations);
+    counters["tile_renders"] = static_cast<double>(m_tileRenders);
+    counters["geometry_updates"] = static_cast<double>(m_geometryUpdates);
+
+    QJsonObject root;
+    root["refresh_rate_hz"] = m_refreshRate;
+    root["metrics"] = metrics;
+    root["counters"] = counters;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || file.write(QJsonDocument(root).toJson()) < 0) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+
+bool FrameMonitor::write(const QString &path, QString *error) const
+{
+    if (path.endsWith(".csv", Qt::CaseInsensitive)) {
+        return writeCsv(path, error);
+    }
+    return writeJson(path, error);
+}
@@ -0,0 +1,116 @@
+#ifndef FRAMEMONITOR_H
+#define FRAMEMONITOR_H
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QtGlobal>
+
+// 从按键到画面的延迟和帧时间统计，可以显示为叠加层，也可以导出为 CSV 或 JSON。
+//
+// 时间点都取自同一个单调时钟（纳秒）：
+// - 按键到局面：keyPressEvent() 收到方向键到 Game2048::move() 改变局面，包括在动画队列中等待的时间
+// - 局面到首帧：局面改变到棋盘第一次画完
+// - 按键到末帧：按键到这一步动画结束后棋盘第一次画完（不播放动画时就是首帧）
+// - 绘制时间：每次 BoardWidget::paintEvent() 的耗时
+// - 帧间隔：动画期间相邻两帧之间的时间；超过 1.5 个刷新周期时按周期数计入掉帧
+// 另外统计方块图像的重新渲染次数（相当于原来样式表的重新计算）和棋盘几何重算次数。
+//
+// 画完指 paintEvent() 返回，之后合成和送显由窗口系统完成，不在统计范围内。
+// 每项指标保留最近 SampleCapacity 个样本用于分位数，计数、均值和最大值覆盖全部样本。
+// 记录操作是 O(1) 的，不分配内存，可以一直开启。
+class FrameMonitor
+{
+public:
+    enum Metric {
+        KeyToState,
+        StateToFirstPaint,
+        KeyToFinalFrame,
+        PaintTime,
+        FrameInterval,
+        MetricCount
+    };
+
+    // 时间单位都是毫秒
+    struct Summary
+    {
+        quint64 count = 0;
+        double mean = 0;
+        double p50 = 0;
+        double p95 = 0;
+        double p99 = 0;
+        double max = 0;
+    };
+
+    static constexpr int SampleCapacity = 1024;
+
+    FrameMonitor();
+
+    // 单调时钟的当前时间（纳秒）
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+
+    // 屏幕刷新率，用于判断掉帧，默认 60Hz
+    void setRefreshRate(qreal hz);
+    qreal refreshRate() const { return m_refreshRate; }
+
+    // 一步移动改变了局面；inputTime 为按键时间，电脑走的步为 -1
+    void stateChanged(qint64 inputTime);
+    void animationStarted();
+    void animationFinished();
+    // 一次绘制结束，paintStart 为开始时的 now()
+    void framePainted(qint64 paintStart);
+    void tileRendered() { ++m_tileRenders; }
+    void geometryRecomputed() { ++m_geometryUpdates; }
+
+    void reset();
+
+    Summary summary(Metric metric) const;
+    quint64 framesPainted() const { return m_framesPainted; }
+    quint64 droppedFrames() const { return m_droppedFrames; }
+    quint64 animations() const { return m_animations; }
+    quint64 tileRenders() const { return m_tileRenders; }
+    quint64 geometryUpdates() const { return m_geometryUpdates; }
+
+    static const char *metricName(Metric metric);
+
+    // 叠加层显示的多行文字
+    QString overlayText() const;
+    // 每项指标一行汇总，计数器也各占一行（时间列留空）
+    bool writeCsv(const QString &path, QString *error) const;
+    // 汇总、计数器和保留的原始样本
+    bool writeJson(const QString &path, QString *error) const;
+    // 按扩展名选择格式：.csv 为 CSV，其他为 JSON
+    bool write(const QString &path, QString *error) const;
+
+private:
+    struct Series
+    {
+        qint64 samples[SampleCapacity];
+        quint64 count;
+        qint64 total;
+        qint64 max;
+    };
+
+    void record(Metric metric, qint64 nanoseconds);
+
+    QElapsedTimer m_clock;
+    qreal m_refreshRate;
+    qint64 m_framePeriod;
+    Series m_series[MetricCount];
+
+    // 等待首帧的局面改变时间，没有时为 -1
+    qint64 m_stateTime;
+    // 等待末帧的按键时间；m_awaitingFinalFrame 为 true 时下一帧就是末帧
+    qint64 m_finalInputTime;
+    bool m_awaitingFinalFrame;
+    bool m_animating;
+    // 动画期间上一帧画完的时间，没有时为 -1
+    qint64 m_lastFrameTime;
+
+    quint64 m_framesPainted;
+    quint64 m_droppedFrames;
+    quint64 m_animations;
+    quint64 m_tileRenders;
+    quint64 m_geometryUpdates;
+};
+
+#endif // FRAMEMONITOR_H
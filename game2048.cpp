@@ -3,253 +3,125 @@
 
 Game2048::Game2048(QObject *parent)
     : QObject(parent)
-    , m_score(0)
-    , m_gameOver(false)
+    , m_history(DefaultHistoryCapacity)
 {
-    m_board.resize(4);
-    for (int i = 0; i < 4; ++i) {
-        m_board[i].resize(4);
-    }
-    
-    newGame();
 }
 
 void Game2048::newGame()
 {
-    // 清空游戏板
-    for (int row = 0; row < 4; ++row) {
-        for (int col = 0; col < 4; ++col) {
-            m_board[row][col] = 0;
-        }
-    }
-    
-    m_score = 0;
-    m_gameOver = false;
-    
-    // 添加两个初始方块
-    addRandomTile();
-    addRandomTile();
+    m_core.newGame();
+    m_lastMove.clear();
+    m_history.clear();
     
-    emit scoreChanged(m_score);
+    emit historyChanged();
+    emit scoreChanged(m_core.score());
     emit boardChanged();
 }
 
-void Game2048::addRandomTile()
+bool Game2048::setBoardSize(int size)
 {
-    QVector<QPair<int, int>> emptyCells;
-    
-    // 找出所有空白格子
-    for (int row = 0; row < 4; ++row) {
-        for (int col = 0; col < 4; ++col) {
-            if (m_board[row][col] == 0) {
-                emptyCells.append(qMakePair(row, col));
-            }
-        }
-    }
-    
-    if (emptyCells.isEmpty()) {
-        return;
+    if (!m_core.setBoardSize(size)) {
+        return false;
     }
+    m_lastMove.clear();
+    m_history.clear();
     
-    // 随机选择一个空白格子
-    int index = QRandomGenerator::global()->bounded(emptyCells.size());
-    int row = emptyCells[index].first;
-    int col = emptyCells[index].second;
-    
-    // 90%概率生成2，10%概率生成4
-    m_board[row][col] = (QRandomGenerator::global()->bounded(10) < 9) ? 2 : 4;
+    emit historyChanged();
+    emit scoreChanged(m_core.score());
+    emit boardChanged();
+    return true;
 }
 
 bool Game2048::move(Direction direction)
 {
-    if (m_gameOver) {
+    // 快照只有 24 字节，移动成功后才写入历史
+    const GameSnapshot before = m_core.snapshot();
+    std::int64_t gained = 0;
+    if (!m_core.move(direction, &gained, &m_lastMove)) {
         return false;
     }
+    if (m_core.boardSize() == BoardState::Size) {
+        m_history.push(before);
+        emit historyChanged();
+    }
     
-    bool moved = moveTiles(direction);
-    bool merged = mergeTiles(direction);
-    bool moved2 = moveTiles(direction); // 合并后再次移动
+    if (gained > 0) {
+        emit scoreChanged(m_core.score());
+    }
+    emit boardChanged();
     
-    if (moved || merged || moved2) {
-        addRandomTile();
-        emit boardChanged();
-        
-        if (!canMove()) {
-            m_gameOver = true;
-            emit gameOver();
-        }
-        
-        return true;
+    if (m_core.isGameOver()) {
+        emit gameOver();
     }
     
-    return false;
+    return true;
 }
 
-bool Game2048::moveTiles(Direction direction)
+bool Game2048::undo()
 {
-    bool moved = false;
-    
-    switch (direction) {
-    case Direction::Up:
-        for (int col = 0; col < 4; ++col) {
-            for (int row = 1; row < 4; ++row) {
-                if (m_board[row][col] != 0) {
-                    int newRow = row;
-                    while (newRow > 0 && m_board[newRow - 1][col] == 0) {
-                        m_board[newRow - 1][col] = m_board[newRow][col];
-                        m_board[newRow][col] = 0;
-                        newRow--;
-                        moved = true;
-                    }
-                }
-            }
-        }
-        break;
-        
-    case Direction::Down:
-        for (int col = 0; col < 4; ++col) {
-            for (int row = 2; row >= 0; --row) {
-                if (m_board[row][col] != 0) {
-                    int newRow = row;
-                    while (newRow < 3 && m_board[newRow + 1][col] == 0) {
-                        m_board[newRow + 1][col] = m_board[newRow][col];
-                        m_board[newRow][col] = 0;
-                        newRow++;
-                        moved = true;
-                    }
-                }
-            }
-        }
-        break;
-        
-    case Direction::Left:
-        for (int row = 0; row < 4; ++row) {
-            for (int col = 1; col < 4; ++col) {
-                if (m_board[row][col] != 0) {
-                    int newCol = col;
-                    while (newCol > 0 && m_board[row][newCol - 1] == 0) {
-                        m_board[row][newCol - 1] = m_board[row][newCol];
-                        m_board[row][newCol] = 0;
-                        newCol--;
-                        moved = true;
-                    }
-                }
-            }
-        }
-        break;
-        
-    case Direction::Right:
-        for (int row = 0; row < 4; ++row) {
-            for (int col = 2; col >= 0; --col) {
-                if (m_board[row][col] != 0) {
-                    int newCol = col;
-                    while (newCol < 3 && m_board[row][newCol + 1] == 0) {
-                        m_board[row][newCol + 1] = m_board[row][newCol];
-                        m_board[row][newCol] = 0;
-                        newCol++;
-                        moved = true;
-                    }
-                }
-            }
-        }
-        break;
+    GameSnapshot previous;
+    if (!m_history.undo(m_core.snapshot(), &previous)) {
+        return false;
     }
+    m_core.restore(previous);
+    m_lastMove.clear();
     
-    return moved;
+    emit historyChanged();
+    emit scoreChanged(m_core.score());
+    emit boardChanged();
+    return true;
 }
 
-bool Game2048::mergeTiles(Direction direction)
+bool Game2048::redo()
 {
-    bool merged = false;
-    
-    switch (direction) {
-    case Direction::Up:
-        for (int col = 0; col < 4; ++col) {
-            for (int row = 0; row < 3; ++row) {
-                if (m_board[row][col] != 0 && m_board[row][col] == m_board[row + 1][col]) {
-                    m_board[row][col] *= 2;
-                    m_board[row + 1][col] = 0;
-                    m_score += m_board[row][col];
-                    merged = true;
-                }
-            }
-        }
-        break;
-        
-    case Direction::Down:
-        for (int col = 0; col < 4; ++col) {
-            for (int row = 3; row > 0; --row) {
-                if (m_board[row][col] != 0 && m_board[row][col] == m_board[row - 1][col]) {
-                    m_board[row][col] *= 2;
-                    m_board[row - 1][col] = 0;
-                    m_score += m_board[row][col];
-                    merged = true;
-                }
-            }
-        }
-        break;
-        
-    case Direction::Left:
-        for (int row = 0; row < 4; ++row) {
-            for (int col = 0; col < 3; ++col) {
-                if (m_board[row][col] != 0 && m_board[row][col] == m_board[row][col + 1]) {
-                    m_board[row][col] *= 2;
-                    m_board[row][col + 1] = 0;
-                    m_score += m_board[row][col];
-                    merged = true;
-                }
-            }
-        }
-        break;
-        
-    case Direction::Right:
-        for (int row = 0; row < 4; ++row) {
-            for (int col = 3; col > 0; --col) {
-                if (m_board[row][col] != 0 && m_board[row][col] == m_board[row][col - 1]) {
-                    m_board[row][col] *= 2;
-                    m_board[row][col - 1] = 0;
-                    m_score += m_board[row][col];
-                    merged = true;
-                }
-            }
-        }
-        break;
-    }
-    
-    if (merged) {
-        emit scoreChanged(m_score);
+    GameSnapshot next;
+    if (!m_history.redo(m_core.snapshot(), &next)) {
+        return false;
     }
+    m_core.restore(next);
+    m_lastMove.clear();
     
-    return merged;
+    emit historyChanged();
+    emit scoreChanged(m_core.score());
+    emit boardChanged();
+    return true;
 }
 
-bool Game2048::canMove() const
+void Game2048::setHistoryCapacity(int capacity)
 {
-    // 检查是否有空格子
-    for (int row = 0; row < 4; ++row) {
-        for (int col = 0; col < 4; ++col) {
-            if (m_board[row][col] == 0) {
-                return true;
-            }
+    m_history.setCapacity(static_cast<std::size_t>(qMax(0, capacity)));
+    emit historyChanged();
+}
+
+bool Game2048::saveGame(const QString &path, QString *error) const
+{
+    std::string message;
+    if (!m_core.saveFile(path.toStdString(), &message)) {
+        if (error) {
+            *error = QString::fromStdString(message);
         }
+        return false;
     }
-    
-    // 检查是否有相邻的相同数字
-    for (int row = 0; row < 4; ++row) {
-        for (int col = 0; col < 3; ++col) {
-            if (m_board[row][col] == m_board[row][col + 1]) {
-                return true;
-            }
+    return true;
+}
+
+bool Game2048::loadGame(const QString &path, QString *error)
+{
+    std::string message;
+    if (!m_core.loadFile(path.toStdString(), &message)) {
+        if (error) {
+            *error = QString::fromStdString(message);
         }
+        return false;
     }
+    m_lastMove.clear();
+    m_history.clear();
     
-    for (int col = 0; col < 4; ++col) {
-        for (int row = 0; row < 3; ++row) {
-            if (m_board[row][col] == m_board[row + 1][col]) {
-                return true;
-            }
-        }
+    emit historyChanged();
+    emit scoreChanged(m_core.score());
+    emit boardChanged();
+    if (m_core.isGameOver()) {
+        emit gameOver();
     }
-    
-    return false;
-}
\ No newline at end of file
+    return true;
+}
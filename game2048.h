@@ -2,45 +2,71 @@
 #define GAME2048_H
 
 #include <QObject>
-#include <QVector>
-#include <QPair>
-#include <QRandomGenerator>
+#include <QString>
+#include "gamecore.h"
+#include "gamehistory.h"
 
 class Game2048 : public QObject
 {
     Q_OBJECT
 
 public:
-    enum class Direction {
-        Up,
-        Down,
-        Left,
-        Right
-    };
+    using Direction = BoardState::Direction;
+    using MoveKernel = BoardState::MoveKernel;
+    
+    // 默认保留的撤销步数，历史占用 DefaultHistoryCapacity * GameHistory::BytesPerEntry 字节（约 2.3MB）
+    static constexpr int DefaultHistoryCapacity = 100000;
     
     explicit Game2048(QObject *parent = nullptr);
     
     void newGame();
     bool move(Direction direction);
     
-    int score() const { return m_score; }
-    bool isGameOver() const { return m_gameOver; }
-    int tileAt(int row, int col) const { return m_board[row][col]; }
+    // 撤销/重做整个对局状态（棋盘、分数、随机数位置），只适用于 4x4
+    bool undo();
+    bool redo();
+    bool canUndo() const { return m_history.canUndo(); }
+    bool canRedo() const { return m_history.canRedo(); }
+    // 改变可撤销的步数（清空历史）
+    void setHistoryCapacity(int capacity);
+    
+    // 保存到小的二进制文件或从中恢复；恢复后撤销历史清空
+    bool saveGame(const QString &path, QString *error) const;
+    bool loadGame(const QString &path, QString *error);
+    
+    qint64 score() const { return m_core.score(); }
+    bool isGameOver() const { return m_core.isGameOver(); }
+    int tileAt(int row, int col) const { return m_core.tileAt(row, col); }
+    BoardState state() const { return m_core.state(); }
+    
+    // 改变棋盘边长（2 到 BoardEngine::MaxSize）并开始新游戏；4x4 以外的棋盘不能使用 state()
+    bool setBoardSize(int size);
+    int boardSize() const { return m_core.boardSize(); }
+    
+    // 最近一次移动中每个方块的去向、合并位置和新方块（移动失败时为空），界面据此直接生成动画
+    const MoveDelta &lastMove() const { return m_lastMove; }
+    
+    // 选择查表或参考实现来执行移动，默认查表
+    void setMoveKernel(MoveKernel kernel) { m_core.setMoveKernel(kernel); }
+    MoveKernel moveKernel() const { return m_core.moveKernel(); }
+    
+    // 可选的对局日志，记录每步方向和生成的方块，可用 JournalReader 逐位精确重放。
+    // 从下一局开始记录；撤销、重做或读取存档后，这一局余下的移动不再记录（见 GameCore::setJournal()）
+    void setJournal(GameJournalWriter *journal) { m_core.setJournal(journal); }
     
 signals:
-    void scoreChanged(int score);
+    void scoreChanged(qint64 score);
     void boardChanged();
     void gameOver();
+    void historyChanged();
     
 private:
-    void addRandomTile();
-    bool moveTiles(Direction direction);
-    bool mergeTiles(Direction direction);
-    bool canMove() const;
-    
-    QVector<QVector<int>> m_board;
-    int m_score;
-    bool m_gameOver;
+    friend class Benchmarks;
+    
+    // 游戏规则全部由不依赖 Qt 的 GameCore 实现，这里只负责发出信号
+    GameCore m_core;
+    MoveDelta m_lastMove;
+    GameHistory m_history;
 };
 
-#endif // GAME2048_H
\ No newline at end of file
+#endif // GAME2048_H
@@ -0,0 +1,23 @@
+# 界面部分的源文件，游戏程序和基准测试共用
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+include(engine/engine.pri)
+
+SOURCES += \
+    $$PWD/mainwindow.cpp \
+    $$PWD/game2048.cpp \
+    $$PWD/boardwidget.cpp \
+    $$PWD/tilestyle.cpp \
+    $$PWD/boardrenderer.cpp \
+    $$PWD/searchworker.cpp \
+    $$PWD/framemonitor.cpp
+
+HEADERS += \
+    $$PWD/mainwindow.h \
+    $$PWD/game2048.h \
+    $$PWD/boardwidget.h \
+    $$PWD/tilestyle.h \
+    $$PWD/boardrenderer.h \
+    $$PWD/searchworker.h \
+    $$PWD/framemonitor.h
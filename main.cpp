@@ -1,12 +1,55 @@
 #include "mainwindow.h"
 #include <QApplication>
+#include <QCommandLineParser>
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
     
+    // 动画期间按键的处理方式和缓存深度
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption animationsOption("animations",
+            "Animation policy while keys arrive: fast-forward (default), queue or off.", "policy",
+            "fast-forward");
+    QCommandLineOption queueOption("input-queue", "Maximum number of buffered moves (1-16).", "depth", "4");
+    QCommandLineOption searchTimeOption("search-time", "Search time per hint or autoplay move in ms (default 200).",
+            "ms", "200");
+    QCommandLineOption sizeOption("size", "Board size N for an NxN game (2-4096, default 4).", "n", "4");
+    parser.addOption(animationsOption);
+    parser.addOption(queueOption);
+    parser.addOption(sizeOption);
+    parser.addOption(searchTimeOption);
+    // 延迟和帧时间统计
+    QCommandLineOption overlayOption("frame-overlay", "Show the latency and frame time overlay (toggle with F3).");
+    QCommandLineOption frameStatsOption("frame-stats",
+            "Write latency and frame statistics to FILE on exit (.csv for CSV, otherwise JSON).", "file");
+    parser.addOption(overlayOption);
+    parser.addOption(frameStatsOption);
+    parser.process(app);
+    
     MainWindow window;
+    const QString policy = parser.value(animationsOption);
+    if (policy == "queue") {
+        window.setAnimationPolicy(MainWindow::AnimationPolicy::Queue);
+    } else if (policy == "off") {
+        window.setAnimationPolicy(MainWindow::AnimationPolicy::Disabled);
+    }
+    window.setInputQueueDepth(parser.value(queueOption).toInt());
+    window.setSearchTime(parser.value(searchTimeOption).toInt());
+    const int size = parser.value(sizeOption).toInt();
+    if (size != BoardState::Size && !window.setBoardSize(size)) {
+        qWarning("unsupported board size %d, using 4x4", size);
+    }
+    window.setFrameOverlayVisible(parser.isSet(overlayOption));
     window.show();
     
-    return app.exec();
+    const int result = app.exec();
+    if (parser.isSet(frameStatsOption)) {
+        QString error;
+        if (!window.frameMonitor().write(parser.value(frameStatsOption), &error)) {
+            qWarning("cannot write frame statistics: %s", qPrintable(error));
+        }
+    }
+    return result;
 }
\ No newline at end of file
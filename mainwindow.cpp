@@ -1,30 +1,93 @@
 #include "mainwindow.h"
+#include "tilestyle.h"
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QFont>
 #include <QMessageBox>
+#include <QFileDialog>
+#include <QShortcut>
+#include <QScreen>
+#include <QGuiApplication>
+#include <QFontDatabase>
 #include <QTimer>
+#include <QEasingCurve>
+#include <QLocale>
+
+namespace {
+
+const QEasingCurve &outQuad()
+{
+    static const QEasingCurve curve(QEasingCurve::OutQuad);
+    return curve;
+}
+
+const QEasingCurve &inQuad()
+{
+    static const QEasingCurve curve(QEasingCurve::InQuad);
+    return curve;
+}
+
+// 按 BoardState::Direction 的顺序
+const char *const kDirectionArrows[] = {"\u2191", "\u2193", "\u2190", "\u2192"};
+
+QRectF interpolateRect(const QRectF &from, const QRectF &to, qreal t)
+{
+    return QRectF(from.x() + (to.x() - from.x()) * t,
+                  from.y() + (to.y() - from.y()) * t,
+                  from.width() + (to.width() - from.width()) * t,
+                  from.height() + (to.height() - from.height()) * t);
+}
+
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , m_game(new Game2048(this))
     , m_animationGroup(new QParallelAnimationGroup(this))
     , m_animationRunning(false)
+    , m_usedSlots(0)
+    , m_animationPolicy(AnimationPolicy::FastForward)
+    , m_pendingHead(0)
+    , m_pendingCount(0)
+    , m_inputQueueDepth(4)
+    , m_searchWorker(new SearchWorker)
+    , m_searchGeneration(0)
+    , m_searchPurpose(SearchPurpose::None)
+    , m_searchTimeMs(200)
+    , m_autoplay(false)
+    , m_frameOverlay(nullptr)
 {
     setupUi();
     
-    // 初始化动画相关的成员变量
-    m_previousBoard.resize(4);
-    for (int i = 0; i < 4; ++i) {
-        m_previousBoard[i].resize(4);
+    // 掉帧按屏幕的刷新周期判断
+    if (QScreen *screen = QGuiApplication::primaryScreen()) {
+        m_frameMonitor.setRefreshRate(screen->refreshRate());
     }
+    m_board->setFrameMonitor(&m_frameMonitor);
+    m_overlayTimer.setInterval(250);
+    connect(&m_overlayTimer, &QTimer::timeout, this, &MainWindow::updateFrameOverlay);
+    
+    // 搜索对象属于后台线程，随线程结束释放；请求和结果都通过排队的信号传递
+    m_searchWorker->moveToThread(&m_searchThread);
+    connect(&m_searchThread, &QThread::finished, m_searchWorker, &QObject::deleteLater);
+    connect(this, &MainWindow::searchRequested, m_searchWorker, &SearchWorker::search);
+    connect(m_searchWorker, &SearchWorker::progress, this, &MainWindow::handleSearchProgress);
+    connect(m_searchWorker, &SearchWorker::finished, this, &MainWindow::handleSearchFinished);
+    m_searchThread.start();
     
     // 连接信号和槽
     connect(m_game, &Game2048::boardChanged, this, &MainWindow::updateBoard);
     connect(m_game, &Game2048::scoreChanged, this, &MainWindow::updateScore);
     connect(m_game, &Game2048::gameOver, this, &MainWindow::handleGameOver);
+    connect(m_game, &Game2048::historyChanged, this, &MainWindow::updateHistoryButtons);
     connect(m_newGameButton, &QPushButton::clicked, m_game, &Game2048::newGame);
     connect(m_newGameButton, &QPushButton::clicked, this, [this]() {
+        // 丢弃上一局排队的按键和搜索，结束还在播放的动画
+        m_pendingCount = 0;
+        cancelSearch();
+        finishAnimations();
+        continueAutoplay();
+        
         // 确保点击新游戏按钮后窗口重新获得焦点
         QTimer::singleShot(10, [this](){ this->setFocus(); });
     });
@@ -32,6 +95,7 @@ MainWindow::MainWindow(QWidget *parent)
     // 初始化游戏界面
     updateBoard();
     updateScore(0);
+    updateHistoryButtons();
     
     // 确保窗口获得焦点
     this->setFocus();
@@ -43,6 +107,9 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    cancelSearch();
+    m_searchThread.quit();
+    m_searchThread.wait();
 }
 
 void MainWindow::setupUi()
@@ -77,250 +144,510 @@ void MainWindow::setupUi()
     m_newGameButton->setFocusPolicy(Qt::NoFocus); // 防止按钮抢占焦点
     topLayout->addWidget(m_newGameButton);
     
-    // 创建游戏网格布局
-    m_gridLayout = new QGridLayout();
-    m_gridLayout->setSpacing(10);
-    mainLayout->addLayout(m_gridLayout);
-    
-    // 创建游戏方块
-    for (int row = 0; row < 4; ++row) {
-        for (int col = 0; col < 4; ++col) {
-            m_tiles[row][col] = new QLabel(this);
-            m_tiles[row][col]->setAlignment(Qt::AlignCenter);
-            m_tiles[row][col]->setFont(QFont("Arial", 20, QFont::Bold));
-            m_tiles[row][col]->setMinimumSize(80, 80);
-            m_tiles[row][col]->setMaximumSize(80, 80);
-            m_gridLayout->addWidget(m_tiles[row][col], row, col);
-            
-            // 设置初始样式
-            updateTileAppearance(m_tiles[row][col], 0);
-        }
-    }
+    // 提示和自动对局按钮
+    m_hintButton = new QPushButton("Hint", this);
+    m_hintButton->setFont(QFont("Arial", 12));
+    m_hintButton->setFocusPolicy(Qt::NoFocus);
+    topLayout->addWidget(m_hintButton);
+    connect(m_hintButton, &QPushButton::clicked, this, &MainWindow::requestHint);
+    
+    m_autoplayButton = new QPushButton("Autoplay", this);
+    m_autoplayButton->setFont(QFont("Arial", 12));
+    m_autoplayButton->setFocusPolicy(Qt::NoFocus);
+    m_autoplayButton->setCheckable(true);
+    topLayout->addWidget(m_autoplayButton);
+    connect(m_autoplayButton, &QPushButton::toggled, this, &MainWindow::setAutoplay);
+    
+    // 撤销和重做按钮
+    m_undoButton = new QPushButton("Undo", this);
+    m_undoButton->setFont(QFont("Arial", 12));
+    m_undoButton->setFocusPolicy(Qt::NoFocus);
+    topLayout->addWidget(m_undoButton);
+    connect(m_undoButton, &QPushButton::clicked, this, &MainWindow::undoMove);
+    
+    m_redoButton = new QPushButton("Redo", this);
+    m_redoButton->setFont(QFont("Arial", 12));
+    m_redoButton->setFocusPolicy(Qt::NoFocus);
+    topLayout->addWidget(m_redoButton);
+    connect(m_redoButton, &QPushButton::clicked, this, &MainWindow::redoMove);
+    
+    // 快捷键：事件过滤器只拦截方向键，其余按键照常触发快捷键
+    connect(new QShortcut(QKeySequence::Undo, this), &QShortcut::activated, this, &MainWindow::undoMove);
+    connect(new QShortcut(QKeySequence::Redo, this), &QShortcut::activated, this, &MainWindow::redoMove);
+    connect(new QShortcut(QKeySequence(Qt::CTRL | Qt::Key_Y), this), &QShortcut::activated,
+            this, &MainWindow::redoMove);
+    connect(new QShortcut(QKeySequence::Save, this), &QShortcut::activated, this, &MainWindow::saveGame);
+    connect(new QShortcut(QKeySequence::Open, this), &QShortcut::activated, this, &MainWindow::loadGame);
+    connect(new QShortcut(QKeySequence(Qt::Key_F3), this), &QShortcut::activated,
+            this, &MainWindow::toggleFrameOverlay);
+    connect(new QShortcut(QKeySequence(Qt::Key_F4), this), &QShortcut::activated,
+            this, &MainWindow::exportFrameStats);
+    
+    // 创建自绘的游戏棋盘
+    m_board = new BoardWidget(this);
+    mainLayout->addWidget(m_board, 1);
+    
+    // 搜索的实时状态：当前深度、用时和目前最好的方向
+    m_searchLabel = new QLabel(this);
+    m_searchLabel->setAlignment(Qt::AlignCenter);
+    mainLayout->addWidget(m_searchLabel);
     
     // 添加一些说明
-    QLabel *instructionLabel = new QLabel("使用方向键移动方块", this);
+    QLabel *instructionLabel = new QLabel("使用方向键移动方块，Ctrl+Z 撤销，Ctrl+Y 重做，Ctrl+S 保存，Ctrl+O 读取", this);
     instructionLabel->setAlignment(Qt::AlignCenter);
     mainLayout->addWidget(instructionLabel);
     
+    // 延迟叠加层：不参与布局，浮在左上角；背景不透明，刷新时不会连带重绘下面的棋盘
+    m_frameOverlay = new QLabel(m_centralWidget);
+    m_frameOverlay->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    m_frameOverlay->setAutoFillBackground(true);
+    QPalette overlayPalette = m_frameOverlay->palette();
+    overlayPalette.setColor(QPalette::Window, QColor(32, 32, 32));
+    overlayPalette.setColor(QPalette::WindowText, QColor(230, 230, 230));
+    m_frameOverlay->setPalette(overlayPalette);
+    m_frameOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+    m_frameOverlay->move(4, 4);
+    m_frameOverlay->hide();
+    
+    // 创建可复用的动画槽
+    setupAnimationPool();
+    
     // 连接动画完成信号
     connect(m_animationGroup, &QParallelAnimationGroup::finished, this, [this]() {
         m_animationRunning = false;
+        m_frameMonitor.animationFinished();
+        m_board->hideSprites();
         updateBoard(); // 确保所有方块显示正确的值
+        
+        // 执行动画期间排队的移动
+        processPendingMoves();
+        continueAutoplay();
     });
 }
 
+void MainWindow::setAnimationPolicy(AnimationPolicy policy)
+{
+    m_animationPolicy = policy;
+    if (policy == AnimationPolicy::Disabled) {
+        finishAnimations();
+    }
+}
+
+void MainWindow::setInputQueueDepth(int depth)
+{
+    m_inputQueueDepth = qBound(1, depth, MaxInputQueueDepth);
+    m_pendingCount = qMin(m_pendingCount, m_inputQueueDepth);
+}
+
+bool MainWindow::setBoardSize(int size)
+{
+    // 旧棋盘上的动画和排队的按键都不再有意义
+    m_pendingCount = 0;
+    finishAnimations();
+    
+    cancelSearch();
+    
+    m_board->setBoardSize(size);
+    const bool changed = m_game->setBoardSize(size);
+    if (!changed) {
+        m_board->setBoardSize(m_game->boardSize());
+        updateBoard();
+    }
+    
+    // 搜索只支持 4x4
+    const bool searchable = m_game->boardSize() == BoardState::Size;
+    if (!searchable) {
+        m_autoplayButton->setChecked(false);
+    }
+    m_hintButton->setEnabled(searchable);
+    m_autoplayButton->setEnabled(searchable);
+    continueAutoplay();
+    return changed;
+}
+
+void MainWindow::setSearchTime(int milliseconds)
+{
+    m_searchTimeMs = qMax(1, milliseconds);
+}
+
 void MainWindow::keyPressEvent(QKeyEvent *event)
 {
-    if (m_game->isGameOver() || m_animationRunning) {
+    const qint64 inputTime = m_frameMonitor.now();
+    Game2048::Direction direction;
+    if (!directionForKey(event->key(), &direction)) {
+        QMainWindow::keyPressEvent(event);
         return;
     }
     
-    // 保存当前棋盘状态，用于后续动画计算
-    for (int row = 0; row < 4; ++row) {
-        for (int col = 0; col < 4; ++col) {
-            m_previousBoard[row][col] = m_game->tileAt(row, col);
-        }
+    // 玩家自己走了一步，正在进行的搜索已经过时
+    cancelSearch();
+    submitMove(direction, inputTime);
+}
+
+void MainWindow::submitMove(Game2048::Direction direction, qint64 inputTime)
+{
+    if (m_game->isGameOver()) {
+        return;
     }
     
-    // 清空动画相关的列表
-    m_tileMovements.clear();
-    m_mergedTiles.clear();
-    m_newTiles.clear();
+    if (!m_animationRunning) {
+        applyMove(direction, inputTime);
+        return;
+    }
     
-    bool moved = false;
-    switch (event->key()) {
+    // 动画进行中：按键进入队列，队列满时丢弃
+    if (m_pendingCount < m_inputQueueDepth) {
+        const int tail = (m_pendingHead + m_pendingCount) % MaxInputQueueDepth;
+        m_pendingMoves[tail] = direction;
+        m_pendingInputTimes[tail] = inputTime;
+        ++m_pendingCount;
+    }
+    
+    // 不等动画播完：跳到结束状态，动画组的 finished 信号会接着执行排队的移动
+    if (m_animationPolicy == AnimationPolicy::FastForward) {
+        finishAnimations();
+    }
+}
+
+bool MainWindow::directionForKey(int key, Game2048::Direction *direction)
+{
+    switch (key) {
     case Qt::Key_Up:
-        moved = m_game->move(Game2048::Direction::Up);
-        break;
+        *direction = Game2048::Direction::Up;
+        return true;
     case Qt::Key_Down:
-        moved = m_game->move(Game2048::Direction::Down);
-        break;
+        *direction = Game2048::Direction::Down;
+        return true;
     case Qt::Key_Left:
-        moved = m_game->move(Game2048::Direction::Left);
-        break;
+        *direction = Game2048::Direction::Left;
+        return true;
     case Qt::Key_Right:
-        moved = m_game->move(Game2048::Direction::Right);
-        break;
+        *direction = Game2048::Direction::Right;
+        return true;
     default:
-        QMainWindow::keyPressEvent(event);
+        return false;
+    }
+}
+
+void MainWindow::applyMove(Game2048::Direction direction, qint64 inputTime)
+{
+    if (m_game->move(direction)) {
+        m_frameMonitor.stateChanged(inputTime);
+        if (m_animationPolicy != AnimationPolicy::Disabled) {
+            // 方块的移动、合并和新方块的位置由引擎在移动时记录，直接开始动画
+            startAnimations();
+        }
+    }
+    if (!m_animationRunning) {
+        continueAutoplay();
+    }
+}
+
+void MainWindow::startSearch(SearchPurpose purpose)
+{
+    // 新的编号让还在运行或排队的旧搜索立即作废
+    ++m_searchGeneration;
+    m_searchWorker->abortOlderThan(m_searchGeneration);
+    m_searchPurpose = purpose;
+    m_searchLabel->setText("Thinking...");
+    emit searchRequested(m_game->state().bits(), m_searchGeneration, m_searchTimeMs, MaxSearchDepth);
+}
+
+void MainWindow::cancelSearch()
+{
+    if (m_searchPurpose == SearchPurpose::None) {
         return;
     }
-    
-    if (moved) {
-        // 计算方块移动、合并和新方块的位置
-        calculateAnimations();
-        // 开始动画
-        startAnimations();
+    ++m_searchGeneration;
+    m_searchWorker->abortOlderThan(m_searchGeneration);
+    m_searchPurpose = SearchPurpose::None;
+    m_searchLabel->clear();
+}
+
+// 自动对局时，棋盘静止（没有动画和排队的移动）且没有进行中的搜索就为当前局面开始下一次搜索
+void MainWindow::continueAutoplay()
+{
+    if (!m_autoplay || m_animationRunning || m_pendingCount > 0 || m_game->isGameOver()
+            || m_searchPurpose != SearchPurpose::None) {
+        return;
     }
+    startSearch(SearchPurpose::Autoplay);
 }
 
-void MainWindow::updateBoard()
+void MainWindow::requestHint()
 {
-    // 如果动画正在运行，不更新界面
-    if (m_animationRunning) {
+    if (m_autoplay || m_game->isGameOver() || m_game->boardSize() != BoardState::Size) {
         return;
     }
-    
-    for (int row = 0; row < 4; ++row) {
-        for (int col = 0; col < 4; ++col) {
-            int value = m_game->tileAt(row, col);
-            updateTileAppearance(m_tiles[row][col], value);
-        }
+    // 提示针对动画结束后的局面
+    finishAnimations();
+    startSearch(SearchPurpose::Hint);
+}
+
+void MainWindow::setAutoplay(bool enabled)
+{
+    m_autoplay = enabled;
+    m_hintButton->setEnabled(!enabled && m_game->boardSize() == BoardState::Size);
+    if (enabled) {
+        cancelSearch();
+        continueAutoplay();
+    } else if (m_searchPurpose == SearchPurpose::Autoplay) {
+        cancelSearch();
     }
 }
 
-// 计算需要动画的方块
-void MainWindow::calculateAnimations()
-{
-    // 找出移动的方块
-    for (int newRow = 0; newRow < 4; ++newRow) {
-        for (int newCol = 0; newCol < 4; ++newCol) {
-            int newValue = m_game->tileAt(newRow, newCol);
-            
-            // 跳过空格子
-            if (newValue == 0) {
-                continue;
-            }
-            
-            // 如果这个位置原来是空的，可能是新方块或者移动过来的方块
-            if (m_previousBoard[newRow][newCol] == 0) {
-                // 查找这个值是否是从其他位置移动过来的
-                bool foundSource = false;
-                
-                for (int oldRow = 0; oldRow < 4 && !foundSource; ++oldRow) {
-                    for (int oldCol = 0; oldCol < 4 && !foundSource; ++oldCol) {
-                        // 跳过当前位置
-                        if (oldRow == newRow && oldCol == newCol) {
-                            continue;
-                        }
-                        
-                        // 如果找到了可能的源位置
-                        if (m_previousBoard[oldRow][oldCol] == newValue || 
-                            m_previousBoard[oldRow][oldCol] * 2 == newValue) {
-                            // 检查这个源位置是否已经被记录为其他移动的源
-                            bool alreadyMoved = false;
-                            for (const TileMovement &move : m_tileMovements) {
-                                if (move.fromRow == oldRow && move.fromCol == oldCol) {
-                                    alreadyMoved = true;
-                                    break;
-                                }
-                            }
-                            
-                            if (!alreadyMoved) {
-                                // 记录移动
-                                TileMovement move;
-                                move.fromRow = oldRow;
-                                move.fromCol = oldCol;
-                                move.toRow = newRow;
-                                move.toCol = newCol;
-                                m_tileMovements.append(move);
-                                
-                                // 如果值翻倍了，记录为合并
-                                if (m_previousBoard[oldRow][oldCol] * 2 == newValue) {
-                                    m_mergedTiles.append(qMakePair(newRow, newCol));
-                                }
-                                
-                                foundSource = true;
-                            }
-                        }
-                    }
-                }
-                
-                // 如果没找到源位置，认为是新方块
-                if (!foundSource) {
-                    m_newTiles.append(qMakePair(newRow, newCol));
-                }
-            }
-            // 如果这个位置原来有值，但值变了，可能是合并的结果
-            else if (m_previousBoard[newRow][newCol] != newValue) {
-                // 如果值翻倍了，记录为合并
-                if (m_previousBoard[newRow][newCol] * 2 == newValue) {
-                    m_mergedTiles.append(qMakePair(newRow, newCol));
-                }
-            }
-        }
+void MainWindow::prepareStateChange()
+{
+    m_pendingCount = 0;
+    m_autoplayButton->setChecked(false);
+    cancelSearch();
+    finishAnimations();
+}
+
+void MainWindow::undoMove()
+{
+    if (!m_game->canUndo()) {
+        return;
     }
+    prepareStateChange();
+    m_game->undo();
 }
 
-void MainWindow::updateScore(int score)
+void MainWindow::redoMove()
 {
-    m_scoreLabel->setText(QString("Score: %1").arg(score));
+    if (!m_game->canRedo()) {
+        return;
+    }
+    prepareStateChange();
+    m_game->redo();
 }
 
-void MainWindow::handleGameOver()
+void MainWindow::saveGame()
 {
-    QMessageBox::information(this, "Game Over", QString("Game Over! Your score: %1").arg(m_game->score()));
+    if (m_game->boardSize() != BoardState::Size) {
+        QMessageBox::warning(this, "Save Game", "Only 4x4 games can be saved.");
+        return;
+    }
+    // 保存动画结束后的局面
+    prepareStateChange();
+    const QString path = QFileDialog::getSaveFileName(this, "Save Game", QString(), "2048 saves (*.2048)");
+    if (path.isEmpty()) {
+        return;
+    }
+    QString error;
+    if (!m_game->saveGame(path, &error)) {
+        QMessageBox::warning(this, "Save Game", error);
+    }
+}
+
+void MainWindow::loadGame()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "Load Game", QString(), "2048 saves (*.2048)");
+    if (path.isEmpty()) {
+        return;
+    }
+    prepareStateChange();
+    if (m_game->boardSize() != BoardState::Size) {
+        setBoardSize(BoardState::Size);
+    }
+    QString error;
+    if (!m_game->loadGame(path, &error)) {
+        QMessageBox::warning(this, "Load Game", error);
+    }
 }
 
-void MainWindow::updateTileAppearance(QLabel *label, int value)
+void MainWindow::updateHistoryButtons()
 {
-    if (value == 0) {
-        label->setText("");
+    m_undoButton->setEnabled(m_game->canUndo());
+    m_redoButton->setEnabled(m_game->canRedo());
+}
+
+void MainWindow::setFrameOverlayVisible(bool visible)
+{
+    if (visible) {
+        updateFrameOverlay();
+        m_frameOverlay->show();
+        m_frameOverlay->raise();
+        m_overlayTimer.start();
     } else {
-        label->setText(QString::number(value));
+        m_overlayTimer.stop();
+        m_frameOverlay->hide();
+    }
+}
+
+void MainWindow::toggleFrameOverlay()
+{
+    setFrameOverlayVisible(!m_frameOverlay->isVisible());
+}
+
+void MainWindow::updateFrameOverlay()
+{
+    m_frameOverlay->setText(m_frameMonitor.overlayText());
+    m_frameOverlay->adjustSize();
+}
+
+void MainWindow::exportFrameStats()
+{
+    const QString path = QFileDialog::getSaveFileName(this, "Export Frame Statistics", "frame-stats.json",
+                                                      "JSON (*.json);;CSV (*.csv)");
+    if (path.isEmpty()) {
+        return;
+    }
+    QString error;
+    if (!m_frameMonitor.write(path, &error)) {
+        QMessageBox::warning(this, "Export Frame Statistics", error);
+    }
+}
+
+void MainWindow::showSearchStatus(const QString &prefix, int direction, int depth, double seconds, quint64 nodes)
+{
+    const QString move = direction >= 0 ? QString::fromUtf8(kDirectionArrows[direction]) : QString("-");
+    const double rate = seconds > 0 ? nodes / seconds : 0;
+    m_searchLabel->setText(QString("%1 %2   depth %3   %4 ms   %5 nodes/s")
+                               .arg(prefix, move)
+                               .arg(depth)
+                               .arg(qRound(seconds * 1000))
+                               .arg(QLocale().toString(qRound64(rate))));
+}
+
+void MainWindow::handleSearchProgress(int generation, int direction, int depth, double seconds, quint64 nodes)
+{
+    if (generation != m_searchGeneration || m_searchPurpose == SearchPurpose::None) {
+        return;
     }
+    showSearchStatus("Thinking", direction, depth, seconds, nodes);
+}
+
+void MainWindow::handleSearchFinished(int generation, int direction, int depth, double seconds, quint64 nodes)
+{
+    if (generation != m_searchGeneration || m_searchPurpose == SearchPurpose::None) {
+        return;
+    }
+    const SearchPurpose purpose = m_searchPurpose;
+    m_searchPurpose = SearchPurpose::None;
+    showSearchStatus(purpose == SearchPurpose::Hint ? "Hint" : "Autoplay", direction, depth, seconds, nodes);
     
-    label->setStyleSheet(getTileStyleSheet(value));
+    if (purpose == SearchPurpose::Autoplay && m_autoplay && direction >= 0) {
+        submitMove(static_cast<Game2048::Direction>(direction));
+    }
 }
 
-QString MainWindow::getTileStyleSheet(int value)
+// 把正在播放的动画直接推进到结束状态（精灵消失、棋盘显示最终局面）
+void MainWindow::finishAnimations()
 {
-    return QString("background-color: %1; color: %2; border-radius: 10px; font-weight: bold;")
-            .arg(getTileColor(value))
-            .arg(getTextColor(value));
+    if (m_animationRunning) {
+        m_animationGroup->setCurrentTime(m_animationGroup->totalDuration());
+    }
+}
+
+void MainWindow::processPendingMoves()
+{
+    // 不能移动的方向不产生动画，继续执行下一个
+    while (m_pendingCount > 0 && !m_animationRunning && !m_game->isGameOver()) {
+        const Game2048::Direction direction = m_pendingMoves[m_pendingHead];
+        const qint64 inputTime = m_pendingInputTimes[m_pendingHead];
+        m_pendingHead = (m_pendingHead + 1) % MaxInputQueueDepth;
+        --m_pendingCount;
+        applyMove(direction, inputTime);
+    }
+    if (m_game->isGameOver()) {
+        m_pendingCount = 0;
+    }
 }
 
-QString MainWindow::getTileColor(int value)
+void MainWindow::updateBoard()
 {
-    switch (value) {
-    case 0: return "#CDC1B4";
-    case 2: return "#EEE4DA";
-    case 4: return "#EDE0C8";
-    case 8: return "#F2B179";
-    case 16: return "#F59563";
-    case 32: return "#F67C5F";
-    case 64: return "#F65E3B";
-    case 128: return "#EDCF72";
-    case 256: return "#EDCC61";
-    case 512: return "#EDC850";
-    case 1024: return "#EDC53F";
-    case 2048: return "#EDC22E";
-    default: return "#3C3A32";
+    // 如果动画正在运行，不更新界面
+    if (m_animationRunning) {
+        return;
+    }
+    
+    // 只有数值变化的格子会被重绘；4x4 直接读取位棋盘
+    const int size = m_game->boardSize();
+    if (size == BoardState::Size) {
+        m_board->setBoard(m_game->state());
+        return;
+    }
+    for (int row = 0; row < size; ++row) {
+        for (int col = 0; col < size; ++col) {
+            m_board->setCellValue(row, col, m_game->tileAt(row, col));
+        }
     }
 }
 
-QString MainWindow::getTextColor(int value)
+void MainWindow::updateScore(qint64 score)
 {
-    return (value <= 4) ? "#776E65" : "#F9F6F2";
+    m_scoreLabel->setText(QString("Score: %1").arg(score));
+}
+
+void MainWindow::handleGameOver()
+{
+    m_autoplayButton->setChecked(false);
+    QMessageBox::information(this, "Game Over", QString("Game Over! Your score: %1").arg(m_game->score()));
+}
+
+// 创建动画槽。每个槽的进度动画常驻在动画组中，之后每一步只重新配置，不再创建对象
+void MainWindow::setupAnimationPool()
+{
+    for (int i = 0; i < BoardWidget::MaxSprites; ++i) {
+        AnimationSlot &slot = m_animationSlots[i];
+        slot.kind = AnimationKind::None;
+        slot.value = 0;
+        slot.row = 0;
+        slot.col = 0;
+        
+        // 以动画组为父对象的动画会自动加入该组
+        slot.animation = new QVariantAnimation(m_animationGroup);
+        slot.animation->setStartValue(0.0);
+        slot.animation->setEndValue(1.0);
+        slot.animation->setDuration(0);
+        connect(slot.animation, &QVariantAnimation::valueChanged, this, [this, i](const QVariant &value) {
+            updateSprite(i, value.toReal());
+        });
+    }
 }
 
 // 开始所有动画
 void MainWindow::startAnimations()
 {
+    const MoveDelta &delta = m_game->lastMove();
+    
     // 如果没有需要动画的方块，直接返回
-    if (m_tileMovements.isEmpty() && m_mergedTiles.isEmpty() && m_newTiles.isEmpty()) {
+    if (delta.slideCount == 0 && delta.mergeCount == 0 && delta.spawnCell < 0) {
         return;
     }
     
-    // 清空之前的动画组
-    m_animationGroup->clear();
+    m_animationGroup->stop();
+    m_usedSlots = 0;
     
     // 标记动画开始运行
     m_animationRunning = true;
+    m_frameMonitor.animationStarted();
+    
+    // 格子序号按行优先排列
+    const int size = m_game->boardSize();
     
-    // 首先执行移动动画
-    for (const TileMovement &move : m_tileMovements) {
-        animateTileMovement(move.fromRow, move.fromCol, move.toRow, move.toCol);
+    // 精灵按槽的顺序绘制：合并动画占用前面的槽，画在滑入的方块下面
+    for (int i = 0; i < delta.mergeCount; ++i) {
+        animateTileMerge(delta.merges[i] / size, delta.merges[i] % size);
     }
     
-    // 然后执行合并动画
-    for (const QPair<int, int> &pos : m_mergedTiles) {
-        animateTileMerge(pos.first, pos.second);
+    // 然后是移动动画
+    for (int i = 0; i < delta.slideCount; ++i) {
+        const MoveDelta::Slide &slide = delta.slides[i];
+        animateTileMovement(slide.from / size, slide.from % size, slide.to / size, slide.to % size,
+                            1 << slide.exponent);
     }
     
-    // 最后执行新方块出现的动画
-    for (const QPair<int, int> &pos : m_newTiles) {
-        animateNewTile(pos.first, pos.second);
+    // 最后是新方块出现的动画
+    if (delta.spawnCell >= 0) {
+        animateNewTile(delta.spawnCell / size, delta.spawnCell % size);
+    }
+    
+    // 这一步用不到的槽时长为 0，随动画组启动立即结束
+    for (int i = m_usedSlots; i < BoardWidget::MaxSprites; ++i) {
+        m_animationSlots[i].kind = AnimationKind::None;
+        m_animationSlots[i].animation->setDuration(0);
     }
     
     // 开始动画
@@ -328,162 +655,97 @@ void MainWindow::startAnimations()
 }
 
 // 方块移动动画
-void MainWindow::animateTileMovement(int fromRow, int fromCol, int toRow, int toCol)
+void MainWindow::animateTileMovement(int fromRow, int fromCol, int toRow, int toCol, int value)
 {
-    // 创建一个临时标签用于动画
-    QLabel *tempLabel = new QLabel(this);
-    tempLabel->setAlignment(Qt::AlignCenter);
-    tempLabel->setFont(QFont("Arial", 20, QFont::Bold));
-    
-    // 设置临时标签的初始位置和大小
-    QRect fromRect = m_tiles[fromRow][fromCol]->geometry();
-    QRect toRect = m_tiles[toRow][toCol]->geometry();
-    tempLabel->setGeometry(fromRect);
-    
-    // 设置临时标签的样式和文本
-    int value = m_previousBoard[fromRow][fromCol];
-    updateTileAppearance(tempLabel, value);
-    
-    // 将临时标签添加到中央部件
-    tempLabel->setParent(m_centralWidget);
-    tempLabel->show();
-    
-    // 创建位置动画
-    QPropertyAnimation *animation = new QPropertyAnimation(tempLabel, "geometry");
-    animation->setDuration(200); // 200毫秒的动画时间
-    animation->setStartValue(fromRect);
-    animation->setEndValue(toRect);
-    animation->setEasingCurve(QEasingCurve::OutQuad); // 使用平滑的缓动曲线
-    
-    // 动画结束后删除临时标签
-    connect(animation, &QPropertyAnimation::finished, tempLabel, &QLabel::deleteLater);
-    
-    // 将动画添加到动画组
-    m_animationGroup->addAnimation(animation);
+    AnimationSlot &slot = m_animationSlots[m_usedSlots++];
+    slot.kind = AnimationKind::Slide;
+    slot.value = value; // 移动前的数值
+    slot.row = toRow;
+    slot.col = toCol;
+    slot.from = m_board->cellRect(fromRow, fromCol);
+    slot.to = m_board->cellRect(toRow, toCol);
+    slot.animation->setDuration(TileStyle::SlideDurationMs);
     
     // 隐藏原始方块
-    m_tiles[fromRow][fromCol]->setText("");
-    m_tiles[fromRow][fromCol]->setStyleSheet(getTileStyleSheet(0));
+    m_board->setCellValue(fromRow, fromCol, 0);
 }
 
 // 方块合并动画
 void MainWindow::animateTileMerge(int row, int col)
 {
-    // 创建一个缩放动画
-    QPropertyAnimation *scaleAnimation = new QPropertyAnimation(m_tiles[row][col], "geometry");
-    QRect originalRect = m_tiles[row][col]->geometry();
-    QRect largerRect = originalRect;
-    largerRect.setLeft(originalRect.left() - 5);
-    largerRect.setTop(originalRect.top() - 5);
-    largerRect.setRight(originalRect.right() + 5);
-    largerRect.setBottom(originalRect.bottom() + 5);
-    
-    scaleAnimation->setDuration(150); // 150毫秒的动画时间
-    scaleAnimation->setStartValue(originalRect);
-    scaleAnimation->setEndValue(largerRect);
-    scaleAnimation->setEasingCurve(QEasingCurve::OutQuad);
-    
-    // 创建第二个动画，恢复原始大小
-    QPropertyAnimation *scaleBackAnimation = new QPropertyAnimation(m_tiles[row][col], "geometry");
-    scaleBackAnimation->setDuration(150); // 150毫秒的动画时间
-    scaleBackAnimation->setStartValue(largerRect);
-    scaleBackAnimation->setEndValue(originalRect);
-    scaleBackAnimation->setEasingCurve(QEasingCurve::InQuad);
-    
-    // 创建顺序动画组
-    QSequentialAnimationGroup *mergeAnimation = new QSequentialAnimationGroup();
-    mergeAnimation->addAnimation(scaleAnimation);
-    mergeAnimation->addAnimation(scaleBackAnimation);
-    
-    // 将合并动画添加到主动画组
-    m_animationGroup->addAnimation(mergeAnimation);
+    AnimationSlot &slot = m_animationSlots[m_usedSlots++];
+    slot.kind = AnimationKind::Merge;
+    slot.value = m_game->tileAt(row, col);
+    slot.row = row;
+    slot.col = col;
+    slot.to = m_board->cellRect(row, col);
+    
+    // 先向四周放大 5 像素（按方块大小缩放），再恢复原始大小，各占一半时间
+    const qreal grow = TileStyle::BaseMergeGrow * slot.to.width() / TileStyle::BaseTileSize;
+    slot.from = slot.to.adjusted(-grow, -grow, grow, grow);
+    slot.animation->setDuration(TileStyle::MergeDurationMs);
     
     // 更新方块外观
-    int value = m_game->tileAt(row, col);
-    updateTileAppearance(m_tiles[row][col], value);
+    m_board->setCellValue(row, col, slot.value);
 }
 
 // 新方块出现动画
 void MainWindow::animateNewTile(int row, int col)
 {
-    // 创建一个不透明度动画
-    QLabel *tile = m_tiles[row][col];
-    tile->setStyleSheet(getTileStyleSheet(0)); // 先设置为空方块样式
-    
-    // 创建一个临时标签用于动画
-    QLabel *tempLabel = new QLabel(this);
-    tempLabel->setAlignment(Qt::AlignCenter);
-    tempLabel->setFont(QFont("Arial", 20, QFont::Bold));
-    
-    // 设置临时标签的位置和大小
-    QRect originalRect = tile->geometry();
-    
-    // 计算缩放起始矩形（从中心点开始，初始大小为0）
-    QRect startRect = originalRect;
-    int centerX = originalRect.x() + originalRect.width() / 2;
-    int centerY = originalRect.y() + originalRect.height() / 2;
-    startRect.setLeft(centerX);
-    startRect.setTop(centerY);
-    startRect.setRight(centerX);
-    startRect.setBottom(centerY);
-    
-    tempLabel->setGeometry(startRect);
-    
-    // 设置临时标签的样式和文本
-    int value = m_game->tileAt(row, col);
-    updateTileAppearance(tempLabel, value);
-    
-    // 设置初始透明度
-    QString styleSheet = tempLabel->styleSheet();
-    styleSheet.replace("background-color:", "background-color: rgba(238, 228, 218, 0);");
-    styleSheet.replace("color:", "color: rgba");
-    tempLabel->setStyleSheet(styleSheet);
-    
-    // 将临时标签添加到中央部件
-    tempLabel->setParent(m_centralWidget);
-    tempLabel->show();
-    
-    // 创建缩放动画
-    QPropertyAnimation *scaleAnimation = new QPropertyAnimation(tempLabel, "geometry");
-    scaleAnimation->setDuration(200); // 200毫秒的动画时间
-    scaleAnimation->setStartValue(startRect);
-    scaleAnimation->setEndValue(originalRect);
-    scaleAnimation->setEasingCurve(QEasingCurve::OutQuad);
-    
-    // 创建不透明度动画（通过样式表变化实现）
-    QPropertyAnimation *opacityAnimation = new QPropertyAnimation(tempLabel, "styleSheet");
-    opacityAnimation->setDuration(200); // 200毫秒的动画时间
-    opacityAnimation->setStartValue(styleSheet);
-    
-    // 创建结束时的样式表（完全不透明）
-    QString endStyleSheet = tempLabel->styleSheet();
-    endStyleSheet.replace("rgba(238, 228, 218, 0)", "rgba(238, 228, 218, 1)");
-    endStyleSheet.replace("color: rgba", "color:");
-    opacityAnimation->setEndValue(endStyleSheet);
-    opacityAnimation->setEasingCurve(QEasingCurve::OutQuad);
-    
-    // 创建并行动画组，同时执行缩放和不透明度动画
-    QParallelAnimationGroup *newTileAnimation = new QParallelAnimationGroup();
-    newTileAnimation->addAnimation(scaleAnimation);
-    newTileAnimation->addAnimation(opacityAnimation);
-    
-    // 动画结束后删除临时标签，并显示实际方块
-    connect(newTileAnimation, &QParallelAnimationGroup::finished, this, [this, tempLabel, tile, value]() {
-        tempLabel->deleteLater();
-        updateTileAppearance(tile, value);
-    });
-    
-    // 将新方块动画添加到主动画组
-    m_animationGroup->addAnimation(newTileAnimation);
+    AnimationSlot &slot = m_animationSlots[m_usedSlots++];
+    slot.kind = AnimationKind::Spawn;
+    slot.value = m_game->tileAt(row, col);
+    slot.row = row;
+    slot.col = col;
+    
+    // 从格子中心点开始放大，同时逐渐不透明
+    slot.to = m_board->cellRect(row, col);
+    slot.from = QRectF(slot.to.center(), QSizeF(0, 0));
+    slot.animation->setDuration(TileStyle::SpawnDurationMs);
+    
+    // 先把格子显示为空方块，动画结束后再显示实际方块
+    m_board->setCellValue(row, col, 0);
 }
-bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+
+// 按动画进度更新槽对应的精灵
+void MainWindow::updateSprite(int index, qreal progress)
 {
-    // 如果动画正在运行，阻止所有键盘事件
-    if (m_animationRunning && event->type() == QEvent::KeyPress) {
-        return true; // 阻止事件传递
+    AnimationSlot &slot = m_animationSlots[index];
+    switch (slot.kind) {
+    case AnimationKind::None:
+        return;
+    case AnimationKind::Slide:
+        m_board->setSprite(index, slot.value, interpolateRect(slot.from, slot.to, outQuad().valueForProgress(progress)));
+        break;
+    case AnimationKind::Merge:
+        // 前一半放大，后一半恢复
+        if (progress < 0.5) {
+            m_board->setSprite(index, slot.value,
+                               interpolateRect(slot.to, slot.from, outQuad().valueForProgress(progress * 2)));
+        } else {
+            m_board->setSprite(index, slot.value,
+                               interpolateRect(slot.from, slot.to, inQuad().valueForProgress(progress * 2 - 1)));
+        }
+        break;
+    case AnimationKind::Spawn: {
+        const qreal eased = outQuad().valueForProgress(progress);
+        m_board->setSprite(index, slot.value, interpolateRect(slot.from, slot.to, eased), eased);
+        break;
+    }
     }
     
-    // 捕获键盘事件
+    if (progress >= 1.0) {
+        // 动画结束：精灵消失，新方块落到格子上
+        m_board->hideSprite(index);
+        if (slot.kind == AnimationKind::Spawn) {
+            m_board->setCellValue(slot.row, slot.col, slot.value);
+        }
+        slot.kind = AnimationKind::None;
+    }
+}
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    // 捕获键盘事件（动画期间的方向键也交给 keyPressEvent() 排队）
     if (event->type() == QEvent::KeyPress) {
         QKeyEvent *keyEvent = static_cast<QKeyEvent*>(event);
         
@@ -2,22 +2,54 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QGridLayout>
 #include <QLabel>
 #include <QPushButton>
 #include <QKeyEvent>
-#include <QPropertyAnimation>
+#include <QVariantAnimation>
 #include <QParallelAnimationGroup>
-#include <QSequentialAnimationGroup>
+#include <QThread>
+#include <QTimer>
 #include "game2048.h"
+#include "boardwidget.h"
+#include "searchworker.h"
+#include "framemonitor.h"
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
+    // 动画进行中收到方向键时的处理方式
+    enum class AnimationPolicy {
+        Queue,       // 按键排队，等当前动画播完再执行
+        FastForward, // 当前动画立即跳到结束状态，马上执行排队的移动（默认）
+        Disabled     // 不播放动画
+    };
+    
+    static constexpr int MaxInputQueueDepth = 16;
+    // 迭代加深的深度上限，实际深度由时间预算决定
+    static constexpr int MaxSearchDepth = 20;
+    
     explicit MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
+    
+    void setAnimationPolicy(AnimationPolicy policy);
+    AnimationPolicy animationPolicy() const { return m_animationPolicy; }
+    // 动画期间最多缓存的按键数（1 到 MaxInputQueueDepth），队列满时丢弃新的按键
+    void setInputQueueDepth(int depth);
+    int inputQueueDepth() const { return m_inputQueueDepth; }
+    // 改变棋盘边长并开始新游戏，大小不受支持时返回 false；超过 6x6 的棋盘不播放动画
+    bool setBoardSize(int size);
+    // 提示和自动对局每一步的搜索时间（毫秒）
+    void setSearchTime(int milliseconds);
+    int searchTime() const { return m_searchTimeMs; }
+    // 延迟和帧时间叠加层（F3 切换）
+    void setFrameOverlayVisible(bool visible);
+    const FrameMonitor &frameMonitor() const { return m_frameMonitor; }
+
+signals:
+    // 由后台线程中的 SearchWorker 排队执行
+    void searchRequested(quint64 board, int generation, int timeBudgetMs, int maxDepth);
 
 protected:
     void keyPressEvent(QKeyEvent *event) override;
@@ -25,41 +57,108 @@ protected:
 
 private slots:
     void updateBoard();
-    void updateScore(int score);
+    void updateScore(qint64 score);
     void handleGameOver();
+    void requestHint();
+    void setAutoplay(bool enabled);
+    void undoMove();
+    void redoMove();
+    void saveGame();
+    void loadGame();
+    void updateHistoryButtons();
+    void toggleFrameOverlay();
+    void updateFrameOverlay();
+    void exportFrameStats();
+    void handleSearchProgress(int generation, int direction, int depth, double seconds, quint64 nodes);
+    void handleSearchFinished(int generation, int direction, int depth, double seconds, quint64 nodes);
 
 private:
+    // 基准测试需要直接访问棋盘控件
+    friend class Benchmarks;
+    
+    // 动画种类；每个动画槽对应棋盘上的一个精灵
+    enum class AnimationKind {
+        None,
+        Slide,
+        Merge,
+        Spawn
+    };
+    
+    // 当前后台搜索的用途
+    enum class SearchPurpose {
+        None,
+        Hint,
+        Autoplay
+    };
+    
+    // 一个可复用的动画槽：进度动画（0 到 1）常驻在动画组中，每一步只修改参数
+    struct AnimationSlot {
+        QVariantAnimation *animation;
+        AnimationKind kind;
+        int value;
+        int row;
+        int col;
+        QRectF from;
+        QRectF to;
+    };
+    
     void setupUi();
-    void updateTileAppearance(QLabel *label, int value);
-    QString getTileStyleSheet(int value);
-    QString getTileColor(int value);
-    QString getTextColor(int value);
-    void animateTileMovement(int fromRow, int fromCol, int toRow, int toCol);
+    void setupAnimationPool();
+    static bool directionForKey(int key, Game2048::Direction *direction);
+    // inputTime 为按键时的 FrameMonitor::now()，电脑走的步为 -1
+    void submitMove(Game2048::Direction direction, qint64 inputTime = -1);
+    void applyMove(Game2048::Direction direction, qint64 inputTime);
+    void startSearch(SearchPurpose purpose);
+    void cancelSearch();
+    void continueAutoplay();
+    // 整体替换局面（撤销、重做、读档）之前：丢弃排队的按键和搜索，结束动画，停止自动对局
+    void prepareStateChange();
+    void showSearchStatus(const QString &prefix, int direction, int depth, double seconds, quint64 nodes);
+    void finishAnimations();
+    void processPendingMoves();
+    void animateTileMovement(int fromRow, int fromCol, int toRow, int toCol, int value);
     void animateTileMerge(int row, int col);
     void animateNewTile(int row, int col);
     void startAnimations();
-    void calculateAnimations();
+    void updateSprite(int index, qreal progress);
     
     Game2048 *m_game;
     QWidget *m_centralWidget;
-    QGridLayout *m_gridLayout;
     QLabel *m_scoreLabel;
     QPushButton *m_newGameButton;
-    QLabel *m_tiles[4][4];
+    QPushButton *m_hintButton;
+    QPushButton *m_autoplayButton;
+    QPushButton *m_undoButton;
+    QPushButton *m_redoButton;
+    QLabel *m_searchLabel;
+    BoardWidget *m_board;
     
     // 动画相关
     QParallelAnimationGroup *m_animationGroup;
     bool m_animationRunning;
-    QVector<QVector<int>> m_previousBoard;
-    struct TileMovement {
-        int fromRow;
-        int fromCol;
-        int toRow;
-        int toCol;
-    };
-    QList<TileMovement> m_tileMovements;
-    QList<QPair<int, int>> m_mergedTiles;
-    QList<QPair<int, int>> m_newTiles;
+    AnimationSlot m_animationSlots[BoardWidget::MaxSprites];
+    int m_usedSlots;
+    AnimationPolicy m_animationPolicy;
+    
+    // 动画期间收到的移动（环形队列）
+    Game2048::Direction m_pendingMoves[MaxInputQueueDepth];
+    qint64 m_pendingInputTimes[MaxInputQueueDepth];
+    int m_pendingHead;
+    int m_pendingCount;
+    int m_inputQueueDepth;
+    
+    // 后台搜索：界面线程只发请求和接收结果，从不等待搜索
+    QThread m_searchThread;
+    SearchWorker *m_searchWorker;
+    int m_searchGeneration;
+    SearchPurpose m_searchPurpose;
+    int m_searchTimeMs;
+    bool m_autoplay;
+    
+    // 延迟和帧时间统计，一直记录；叠加层只在显示时定时刷新
+    FrameMonitor m_frameMonitor;
+    QLabel *m_frameOverlay;
+    QTimer m_overlayTimer;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include "searchworker.h"
+
+SearchWorker::SearchWorker(QObject *parent)
+    : QObject(parent)
+    , m_latestGeneration(0)
+    , m_stop(false)
+{
+    m_search.setStopFlag(&m_stop);
+}
+
+void SearchWorker::abortOlderThan(int generation)
+{
+    // 先更新编号再置位：search() 清除标志后会重新检查编号，两边的先后顺序怎样交错都不会漏掉停止请求
+    m_latestGeneration.store(generation);
+    m_stop.store(true);
+}
+
+void SearchWorker::search(quint64 board, int generation, int timeBudgetMs, int maxDepth)
+{
+    if (generation < m_latestGeneration.load()) {
+        return;
+    }
+    m_stop.store(false);
+    if (generation < m_latestGeneration.load()) {
+        return;
+    }
+    
+    const SearchResult result = m_search.searchIterative(BoardState(board), timeBudgetMs / 1000.0, maxDepth,
+                                                         [this, generation](const SearchResult &partial) {
+        emit progress(generation, partial.hasMove ? static_cast<int>(partial.bestMove) : -1, partial.depth,
+                      partial.seconds, partial.nodes);
+    });
+    
+    // 被新请求打断的结果已经过时，不再发出
+    if (generation < m_latestGeneration.load()) {
+        return;
+    }
+    emit finished(generation, result.hasMove ? static_cast<int>(result.bestMove) : -1, result.depth,
+                  result.seconds, result.nodes);
+}
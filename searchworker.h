@@ -0,0 +1,38 @@
+#ifndef SEARCHWORKER_H
+#define SEARCHWORKER_H
+
+#include <QObject>
+#include <atomic>
+#include "expectimax.h"
+
+// 在后台线程中为提示和自动对局运行迭代加深的期望最大化搜索。
+// 对象移动到工作线程后通过排队的信号接收请求；每完成一层深度发出 progress，界面随时拿到目前最好的方向。
+//
+// 每个请求带有递增的编号。abortOlderThan() 可以从任意线程调用：编号更小的请求（包括正在运行的）
+// 会尽快停止，还在队列中的直接跳过，所以玩家移动后旧局面的搜索不会拖住新的请求。
+class SearchWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SearchWorker(QObject *parent = nullptr);
+    
+    // 线程安全
+    void abortOlderThan(int generation);
+
+public slots:
+    // board 是 BoardState::bits()；timeBudgetMs 毫秒内尽量搜深，最多 maxDepth 层
+    void search(quint64 board, int generation, int timeBudgetMs, int maxDepth);
+
+signals:
+    // direction 为 BoardState::Direction 的数值，没有能移动的方向时为 -1
+    void progress(int generation, int direction, int depth, double seconds, quint64 nodes);
+    void finished(int generation, int direction, int depth, double seconds, quint64 nodes);
+
+private:
+    ExpectimaxSearch m_search;
+    std::atomic<int> m_latestGeneration;
+    std::atomic<bool> m_stop;
+};
+
+#endif // SEARCHWORKER_H
@@ -0,0 +1,57 @@
+#include "tilestyle.h"
+#include <QPainter>
+
+namespace TileStyle {
+
+QColor tileColor(int value)
+{
+    switch (value) {
+    case 0: return QColor(0xCD, 0xC1, 0xB4);
+    case 2: return QColor(0xEE, 0xE4, 0xDA);
+    case 4: return QColor(0xED, 0xE0, 0xC8);
+    case 8: return QColor(0xF2, 0xB1, 0x79);
+    case 16: return QColor(0xF5, 0x95, 0x63);
+    case 32: return QColor(0xF6, 0x7C, 0x5F);
+    case 64: return QColor(0xF6, 0x5E, 0x3B);
+    case 128: return QColor(0xED, 0xCF, 0x72);
+    case 256: return QColor(0xED, 0xCC, 0x61);
+    case 512: return QColor(0xED, 0xC8, 0x50);
+    case 1024: return QColor(0xED, 0xC5, 0x3F);
+    case 2048: return QColor(0xED, 0xC2, 0x2E);
+    default: return QColor(0x3C, 0x3A, 0x32);
+    }
+}
+
+QColor textColor(int value)
+{
+    return (value <= 4) ? QColor(0x77, 0x6E, 0x65) : QColor(0xF9, 0xF6, 0xF2);
+}
+
+QColor boardColor()
+{
+    return QColor(0xBB, 0xAD, 0xA0);
+}
+
+QFont font(qreal tileSize)
+{
+    QFont font("Arial");
+    font.setBold(true);
+    font.setPointSizeF(BaseFontPointSize * tileSize / BaseTileSize);
+    return font;
+}
+
+void paintTile(QPainter *painter, const QRectF &rect, int value)
+{
+    const qreal radius = BaseCornerRadius * rect.width() / BaseTileSize;
+    painter->setPen(Qt::NoPen);
+    painter->setBrush(tileColor(value));
+    painter->drawRoundedRect(rect, radius, radius);
+
+    if (value != 0 && rect.width() >= MinTextTileSize) {
+        painter->setFont(font(rect.width()));
+        painter->setPen(textColor(value));
+        painter->drawText(rect, Qt::AlignCenter, QString::number(value));
+    }
+}
+
+}
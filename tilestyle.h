@@ -0,0 +1,45 @@
+#ifndef TILESTYLE_H
+#define TILESTYLE_H
+
+#include <QColor>
+#include <QFont>
+#include <QRectF>
+
+class QPainter;
+
+// 方块的配色、字体、尺寸比例和动画参数。自绘棋盘（BoardWidget）、主窗口的动画和
+// 离屏渲染（BoardRenderer）共用，保证界面和导出的图像看起来完全一样。
+// 所有函数都不修改共享状态，可以在任何线程中调用。
+namespace TileStyle {
+
+// 原来 QLabel 布局的尺寸：80x80 的方块，间距 10，圆角 10，20 磅粗体数字；缩放时保持比例
+constexpr int BaseTileSize = 80;
+constexpr int BaseSpacing = 10;
+constexpr qreal BaseCornerRadius = 10.0;
+constexpr qreal BaseFontPointSize = 20.0;
+// 合并动画中方块向四周放大的距离
+constexpr qreal BaseMergeGrow = 5.0;
+// 方块小于这个边长时只画颜色不画数字
+constexpr int MinTextTileSize = 16;
+
+// 动画时长（毫秒）。滑动和新方块用 OutQuad 缓动；合并前一半用 OutQuad 放大，后一半用 InQuad 恢复
+constexpr int SlideDurationMs = 200;
+constexpr int MergeDurationMs = 300;
+constexpr int SpawnDurationMs = 200;
+// 一步移动的全部动画在这个时间内结束
+constexpr int MoveAnimationMs = MergeDurationMs;
+
+QColor tileColor(int value);
+QColor textColor(int value);
+// 离屏渲染时方块之间露出的底色
+QColor boardColor();
+
+// 按方块边长缩放后的数字字体
+QFont font(qreal tileSize);
+
+// 在 rect 处画出数值为 value 的方块（0 为空格），圆角和字号按 rect 的宽度缩放
+void paintTile(QPainter *painter, const QRectF &rect, int value);
+
+}
+
+#endif // TILESTYLE_H
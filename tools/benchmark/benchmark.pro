@@ -0,0 +1,17 @@
+# 引擎和界面热点路径的微基准测试。需要 QtWidgets 来构造 MainWindow，
+# 没有显示器时自动使用 offscreen 平台插件。
+QT += core gui widgets
+
+TARGET = 2048bench
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+include(../../gui.pri)
+
+SOURCES += \
+    benchmarkrunner.cpp \
+    main.cpp
+
+HEADERS += \
+    benchmarkrunner.h
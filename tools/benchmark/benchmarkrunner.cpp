@@ -0,0 +1,106 @@
+#include "benchmarkrunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <sstream>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double timeSeconds(const BenchmarkRunner::Body &body, std::uint64_t iterations)
+{
+    const auto start = Clock::now();
+    body(iterations);
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::string escapeJson(const std::string &text)
+{
+    std::string escaped;
+    for (char ch : text) {
+        if (ch == '"' || ch == '\\') {
+            escaped += '\\';
+        }
+        escaped += ch;
+    }
+    return escaped;
+}
+
+}
+
+BenchmarkRunner::BenchmarkRunner(const Settings &settings)
+    : m_settings(settings)
+{
+}
+
+void BenchmarkRunner::run(const std::string &name, const Body &body)
+{
+    if (!m_settings.filter.empty() && name.find(m_settings.filter) == std::string::npos) {
+        return;
+    }
+
+    // 预热并确定迭代次数：翻倍直到单轮耗时超过 minTime
+    std::uint64_t iterations = 1;
+    double elapsed = 0;
+    const auto warmupStart = Clock::now();
+    for (;;) {
+        elapsed = timeSeconds(body, iterations);
+        const double warmup = std::chrono::duration<double>(Clock::now() - warmupStart).count();
+        if (elapsed >= m_settings.minTimeSeconds && warmup >= m_settings.warmupSeconds) {
+            break;
+        }
+        if (elapsed < m_settings.minTimeSeconds) {
+            iterations *= 2;
+        }
+    }
+
+    std::vector<double> samples;
+    samples.reserve(m_settings.repetitions);
+    for (int i = 0; i < m_settings.repetitions; ++i) {
+        samples.push_back(1e9 * timeSeconds(body, iterations) / iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.repetitions = static_cast<int>(samples.size());
+    result.medianNs = samples[samples.size() / 2];
+    result.p99Ns = samples[std::min(samples.size() - 1, static_cast<std::size_t>(samples.size() * 0.99))];
+    result.minNs = samples.front();
+    result.meanNs = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+    m_results.push_back(result);
+
+    std::printf("%-40s %12.2f %12.2f %12.2f %12llu\n", name.c_str(), result.medianNs, result.p99Ns, result.minNs,
+                static_cast<unsigned long long>(iterations));
+    std::fflush(stdout);
+}
+
+void BenchmarkRunner::printHeader() const
+{
+    std::printf("%-40s %12s %12s %12s %12s\n", "benchmark", "median ns", "p99 ns", "min ns", "iterations");
+}
+
+std::string BenchmarkRunner::toJson(const std::string &context) const
+{
+    std::ostringstream json;
+    json.precision(6);
+    json << std::fixed;
+    json << "{\n  \"context\": " << context << ",\n  \"benchmarks\": [\n";
+    for (std::size_t i = 0; i < m_results.size(); ++i) {
+        const Result &result = m_results[i];
+        json << "    {\"name\": \"" << escapeJson(result.name) << "\""
+             << ", \"iterations\": " << result.iterations
+             << ", \"repetitions\": " << result.repetitions
+             << ", \"median_ns\": " << result.medianNs
+             << ", \"p99_ns\": " << result.p99Ns
+             << ", \"min_ns\": " << result.minNs
+             << ", \"mean_ns\": " << result.meanNs << "}"
+             << (i + 1 < m_results.size() ? ",\n" : "\n");
+    }
+    json << "  ]\n}\n";
+    return json.str();
+}
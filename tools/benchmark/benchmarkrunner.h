@@ -0,0 +1,62 @@
+#ifndef BENCHMARKRUNNER_H
+#define BENCHMARKRUNNER_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// 防止编译器把被测代码当作无用计算删掉
+template <typename T>
+inline void doNotOptimize(const T &value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &value;
+#endif
+}
+
+// 简单的微基准测试框架：先预热，再自动确定每轮迭代次数使单轮耗时不少于 minTime，
+// 重复多轮后报告每次操作耗时的中位数、p99、最小值和平均值。
+class BenchmarkRunner
+{
+public:
+    // 被测函数执行 iterations 次操作
+    using Body = std::function<void(std::uint64_t iterations)>;
+
+    struct Settings
+    {
+        int repetitions = 30;
+        double minTimeSeconds = 0.01;
+        double warmupSeconds = 0.05;
+        // 只运行名称包含该子串的测试
+        std::string filter;
+    };
+
+    struct Result
+    {
+        std::string name;
+        std::uint64_t iterations = 0;
+        int repetitions = 0;
+        double medianNs = 0;
+        double p99Ns = 0;
+        double minNs = 0;
+        double meanNs = 0;
+    };
+
+    explicit BenchmarkRunner(const Settings &settings);
+
+    void run(const std::string &name, const Body &body);
+
+    const std::vector<Result> &results() const { return m_results; }
+    void printHeader() const;
+    std::string toJson(const std::string &context) const;
+
+private:
+    Settings m_settings;
+    std::vector<Result> m_results;
+};
+
+#endif // BENCHMARKRUNNER_H
@@ -0,0 +1,356 @@
+#include "batchmove.h"
+#include "benchmarkrunner.h"
+#include "counterrng.h"
+#include "expectimax.h"
+#include "game2048.h"
+#include "gamecore.h"
+#include "mainwindow.h"
+#include "policy.h"
+#include "transpositiontable.h"
+#include "workstealingpool.h"
+
+#include <QApplication>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kCorpusSeed = 20480;
+constexpr std::size_t kCorpusSize = 1024;
+// 置换表基准：64 MB 的表（400 万个槽）和同样多的不同局面，工作集远大于缓存
+constexpr std::size_t kTableBytes = std::size_t(64) << 20;
+constexpr std::size_t kTableKeys = std::size_t(1) << 22;
+
+struct Options
+{
+    BenchmarkRunner::Settings settings;
+    std::string jsonFile;
+};
+
+// 语料对局中实际走过的一步
+struct Transition
+{
+    BoardState before;
+    BoardState::Direction direction;
+};
+
+// 基准测试用的局面集合：中局（最大方块 128~256）和残局（最大方块 512 以上）
+struct Corpus
+{
+    std::vector<BoardState> mid;
+    std::vector<BoardState> late;
+    std::vector<Transition> midTransitions;
+    std::vector<Transition> lateTransitions;
+};
+
+void printUsage(const char *program)
+{
+    std::printf("Usage: %s [options]\n"
+                "  --filter TEXT       only run benchmarks whose name contains TEXT\n"
+                "  --repetitions N     measured repetitions per benchmark (default 30)\n"
+                "  --min-time MS       minimum duration of one repetition (default 10)\n"
+                "  --json FILE         also write the results as JSON\n"
+                "  --help              show this help\n",
+                program);
+}
+
+bool parseOptions(int argc, char *argv[], Options *options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage(argv[0]);
+            std::exit(0);
+        } else if (std::strcmp(arg, "--filter") == 0 && hasValue) {
+            options->settings.filter = argv[++i];
+        } else if (std::strcmp(arg, "--repetitions") == 0 && hasValue) {
+            options->settings.repetitions = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--min-time") == 0 && hasValue) {
+            options->settings.minTimeSeconds = std::atof(argv[++i]) / 1000.0;
+        } else if (std::strcmp(arg, "--json") == 0 && hasValue) {
+            options->jsonFile = argv[++i];
+        } else {
+            std::fprintf(stderr, "unknown or incomplete option: %s\n", arg);
+            return false;
+        }
+    }
+    return true;
+}
+
+// 用固定种子的浅层搜索对局生成局面，保证每次运行、每个提交使用同样的数据
+Corpus buildCorpus()
+{
+    Corpus corpus;
+    ExpectimaxSearch::Settings settings;
+    settings.depth = 2;
+    ExpectimaxPolicy policy(settings);
+    GameCore game(kCorpusSeed);
+
+    for (std::uint64_t round = 0; corpus.mid.size() < kCorpusSize || corpus.late.size() < kCorpusSize; ++round) {
+        game.seed(kCorpusSeed, round);
+        game.newGame();
+        while (!game.isGameOver()) {
+            const BoardState before = game.state();
+            const BoardState::Direction direction = policy.chooseMove(game);
+            game.move(direction);
+            if (game.moveCount() % 3 != 0) {
+                continue;
+            }
+
+            const int maxExponent = before.maxExponent();
+            if (maxExponent >= 7 && maxExponent <= 8 && corpus.mid.size() < kCorpusSize) {
+                corpus.mid.push_back(before);
+                corpus.midTransitions.push_back({before, direction});
+            } else if (maxExponent >= 9 && corpus.late.size() < kCorpusSize) {
+                corpus.late.push_back(before);
+                corpus.lateTransitions.push_back({before, direction});
+            }
+        }
+    }
+    return corpus;
+}
+
+const char *directionName(BoardState::Direction direction)
+{
+    switch (direction) {
+    case BoardState::Direction::Up: return "up";
+    case BoardState::Direction::Down: return "down";
+    case BoardState::Direction::Left: return "left";
+    case BoardState::Direction::Right: return "right";
+    }
+    return "?";
+}
+
+}
+
+// MainWindow 和 Game2048 的友元，用于直接调用私有的热点函数
+class Benchmarks
+{
+public:
+    static void engine(BenchmarkRunner &runner, const Corpus &corpus);
+    static void ui(BenchmarkRunner &runner);
+};
+
+void Benchmarks::engine(BenchmarkRunner &runner, const Corpus &corpus)
+{
+    const BoardState::Direction directions[] = {
+        BoardState::Direction::Up, BoardState::Direction::Down,
+        BoardState::Direction::Left, BoardState::Direction::Right
+    };
+    const struct {
+        const char *name;
+        const std::vector<BoardState> *boards;
+        const std::vector<Transition> *transitions;
+    } phases[] = {{"mid", &corpus.mid, &corpus.midTransitions}, {"late", &corpus.late, &corpus.lateTransitions}};
+
+    for (const auto &phase : phases) {
+        const std::vector<BoardState> &boards = *phase.boards;
+        const std::size_t count = boards.size();
+
+        for (BoardState::Direction direction : directions) {
+            Game2048 game;
+            runner.run(std::string("Game2048::move/") + directionName(direction) + "/" + phase.name,
+                       [&](std::uint64_t iterations) {
+                for (std::uint64_t i = 0; i < iterations; ++i) {
+                    game.m_core.setState(boards[i % count], 0);
+                    doNotOptimize(game.move(direction));
+                }
+            });
+        }
+
+        for (BoardState::MoveKernel kernel : {BoardState::MoveKernel::LookupTable, BoardState::MoveKernel::Reference}) {
+            const char *kernelName = kernel == BoardState::MoveKernel::LookupTable ? "table" : "reference";
+            runner.run(std::string("BoardState::moved/") + kernelName + "/" + phase.name,
+                       [&](std::uint64_t iterations) {
+                for (std::uint64_t i = 0; i < iterations; ++i) {
+                    doNotOptimize(boards[i % count].moved(directions[i & 3], kernel));
+                }
+            });
+        }
+
+        // 批量移动：每次对整个局面集合应用同一方向，每次迭代计为一个棋盘，可与上面的 BoardState::moved 直接比较
+        std::vector<std::uint64_t> bits(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            bits[i] = boards[i].bits();
+        }
+        std::vector<std::uint64_t> moved(count);
+        std::vector<std::uint32_t> scoreDeltas(count);
+        std::vector<std::uint64_t> changed((count + 63) / 64);
+        const BatchMover::Kernel kernels[] = {
+            BatchMover::Kernel::Scalar, BatchMover::Kernel::Sse41, BatchMover::Kernel::Avx2
+        };
+        for (BatchMover::Kernel kernel : kernels) {
+            BatchMover mover;
+            if (!mover.setKernel(kernel)) {
+                continue;
+            }
+            // 计时之前先和标量实现逐项比对，向量实现算错时测出来的速度没有意义
+            if (kernel != BatchMover::Kernel::Scalar) {
+                BatchMover scalar;
+                scalar.setKernel(BatchMover::Kernel::Scalar);
+                std::vector<std::uint64_t> expectedMoved(count);
+                std::vector<std::uint32_t> expectedScores(count);
+                std::vector<std::uint64_t> expectedChanged(changed.size());
+                for (BoardState::Direction direction : directions) {
+                    scalar.move(direction, bits.data(), count, expectedMoved.data(), expectedScores.data(),
+                                expectedChanged.data());
+                    mover.move(direction, bits.data(), count, moved.data(), scoreDeltas.data(), changed.data());
+                    if (moved != expectedMoved || scoreDeltas != expectedScores || changed != expectedChanged) {
+                        std::fprintf(stderr, "BatchMover::move/%s/%s: %s result differs from the scalar kernel\n",
+                                     BatchMover::kernelName(kernel), phase.name, directionName(direction));
+                        std::exit(1);
+                    }
+                }
+            }
+            runner.run(std::string("BatchMover::move/") + BatchMover::kernelName(kernel) + "/" + phase.name,
+                       [&](std::uint64_t iterations) {
+                std::uint64_t round = 0;
+                for (std::uint64_t done = 0; done < iterations; done += count, ++round) {
+                    const std::size_t batch = static_cast<std::size_t>(
+                        std::min<std::uint64_t>(count, iterations - done));
+                    mover.move(directions[round & 3], bits.data(), batch, moved.data(), scoreDeltas.data(),
+                               changed.data());
+                    doNotOptimize(changed[0]);
+                }
+            });
+        }
+
+        // 界面动画所需的方块去向，取代原来 MainWindow 中移动后逐格比对的做法
+        const std::vector<Transition> &transitions = *phase.transitions;
+        const std::size_t transitionCount = transitions.size();
+        MoveDelta delta;
+        runner.run(std::string("MoveDelta::trace/") + phase.name, [&](std::uint64_t iterations) {
+            for (std::uint64_t i = 0; i < iterations; ++i) {
+                const Transition &transition = transitions[i % transitionCount];
+                doNotOptimize(MoveDelta::trace(transition.before, transition.direction, &delta));
+                doNotOptimize(delta.slideCount);
+            }
+        });
+
+        GameCore core(kCorpusSeed);
+        runner.run(std::string("GameCore::canMove/") + phase.name, [&](std::uint64_t iterations) {
+            for (std::uint64_t i = 0; i < iterations; ++i) {
+                core.setState(boards[i % count], 0);
+                doNotOptimize(core.canMove());
+            }
+        });
+
+        runner.run(std::string("GameCore::addRandomTile/") + phase.name, [&](std::uint64_t iterations) {
+            for (std::uint64_t i = 0; i < iterations; ++i) {
+                core.setState(boards[i % count], 0);
+                doNotOptimize(core.addRandomTile());
+            }
+        });
+    }
+
+    // 各种棋盘大小上连续对局的单步移动：4x4 走位棋盘，2..6 走编译期特化，更大的走通用实现
+    for (int size : {3, 4, 5, 6, 8, 16, 64, 256}) {
+        GameCore sized(kCorpusSeed);
+        sized.setBoardSize(size, 1);
+        runner.run("GameCore::move/size/" + std::to_string(size), [&](std::uint64_t iterations) {
+            for (std::uint64_t i = 0; i < iterations; ++i) {
+                if (sized.isGameOver()) {
+                    sized.newGame();
+                }
+                doNotOptimize(sized.move(directions[i & 3]));
+            }
+        });
+    }
+
+    // 共享置换表的吞吐随线程数的扩展：每次迭代查询一次，未命中时写入，和搜索中机会节点的用法一样。
+    // 迭代按工作窃取分给各线程，ns/iter 是墙钟时间，线程数翻倍时理想情况下减半
+    TranspositionTable table(kTableBytes);
+    std::vector<std::uint64_t> keys(kTableKeys);
+    for (std::size_t i = 0; i < kTableKeys; ++i) {
+        keys[i] = CounterRng::mix(kCorpusSeed, i);
+    }
+    const int hardwareThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    for (int threads = 1; ; threads = std::min(threads * 2, hardwareThreads)) {
+        WorkStealingPool pool(threads);
+        table.clear();
+        runner.run("TranspositionTable::probe+store/threads/" + std::to_string(threads),
+                   [&](std::uint64_t iterations) {
+            pool.run(static_cast<std::size_t>(iterations), 4096, [&](int, std::size_t begin, std::size_t end) {
+                TranspositionTable::Entry entry;
+                for (std::size_t i = begin; i < end; ++i) {
+                    const std::uint64_t key = keys[i & (kTableKeys - 1)];
+                    if (!table.probe(key, &entry)) {
+                        table.store(key, static_cast<int>(i & 7), static_cast<float>(i));
+                    }
+                    doNotOptimize(entry.value);
+                }
+            });
+        });
+        if (threads == hardwareThreads) {
+            break;
+        }
+    }
+
+    Game2048 game;
+    runner.run("Game2048::newGame", [&](std::uint64_t iterations) {
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            game.newGame();
+            doNotOptimize(game.m_core.state());
+        }
+    });
+}
+
+void Benchmarks::ui(BenchmarkRunner &runner)
+{
+    MainWindow window;
+    // 自绘棋盘每个格子、每个精灵每帧取一次缓存的方块图像
+    const int values[] = {0, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, 32768};
+    runner.run("BoardWidget::tilePixmap", [&](std::uint64_t iterations) {
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            const QPixmap pixmap = window.m_board->tilePixmap(values[i % 16]);
+            doNotOptimize(pixmap.cacheKey());
+        }
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    // 没有显示器的 CI 机器上也能构造窗口
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    const Corpus corpus = buildCorpus();
+    std::printf("corpus: %zu mid-game and %zu late-game positions (seed %llu)\n\n", corpus.mid.size(),
+                corpus.late.size(), static_cast<unsigned long long>(kCorpusSeed));
+
+    BenchmarkRunner runner(options.settings);
+    runner.printHeader();
+    Benchmarks::engine(runner, corpus);
+    Benchmarks::ui(runner);
+
+    if (!options.jsonFile.empty()) {
+        char context[256];
+        std::snprintf(context, sizeof(context),
+                      "{\"corpus_seed\": %llu, \"corpus_mid\": %zu, \"corpus_late\": %zu, \"qt\": \"%s\"}",
+                      static_cast<unsigned long long>(kCorpusSeed), corpus.mid.size(), corpus.late.size(),
+                      qVersion());
+        std::ofstream file(options.jsonFile);
+        file << runner.toJson(context);
+        if (!file) {
+            std::fprintf(stderr, "cannot write %s\n", options.jsonFile.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+# 残局表生成程序：逆向分析一类局面并写出可内存映射的表文件，不链接任何 Qt 模块
+TEMPLATE = app
+TARGET = 2048endgame
+
+CONFIG += console c++17
+CONFIG -= qt app_bundle
+CONFIG += thread
+
+unix: LIBS += -pthread
+
+include(../../engine/engine.pri)
+
+SOURCES += \
+    main.cpp
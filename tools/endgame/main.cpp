@@ -0,0 +1,120 @@
+#include "endgametable.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+struct Options
+{
+    EndgameTable::Settings settings;
+    std::string output = "endgame.table";
+    // 非空时只读取已有的表并输出摘要
+    std::string info;
+};
+
+void printUsage(const char *program)
+{
+    std::printf("Usage: %s [options]\n"
+                "  --size N         board size N x N, 2-4 (default 3)\n"
+                "  --target E       target tile 2^E, 3-15; positions with every tile below the\n"
+                "                   target are solved (default 6)\n"
+                "  --metric NAME    win (probability of reaching the target) | score (expected\n"
+                "                   score until the target or game over) (default win)\n"
+                "  --threads N      generator threads (default: all cores)\n"
+                "  --out FILE       table file to write (default endgame.table)\n"
+                "  --info FILE      map an existing table and print its summary\n"
+                "  --help           show this help\n",
+                program);
+}
+
+bool parseOptions(int argc, char *argv[], Options *options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage(argv[0]);
+            std::exit(0);
+        } else if (std::strcmp(arg, "--size") == 0 && hasValue) {
+            options->settings.boardSize = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--target") == 0 && hasValue) {
+            options->settings.targetExponent = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--metric") == 0 && hasValue) {
+            const std::string metric = argv[++i];
+            if (metric == "win") {
+                options->settings.metric = EndgameTable::Metric::WinProbability;
+            } else if (metric == "score") {
+                options->settings.metric = EndgameTable::Metric::ExpectedScore;
+            } else {
+                std::fprintf(stderr, "unknown metric: %s\n", metric.c_str());
+                return false;
+            }
+        } else if (std::strcmp(arg, "--threads") == 0 && hasValue) {
+            options->settings.threadCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--out") == 0 && hasValue) {
+            options->output = argv[++i];
+        } else if (std::strcmp(arg, "--info") == 0 && hasValue) {
+            options->info = argv[++i];
+        } else {
+            std::fprintf(stderr, "unknown or incomplete option: %s\n", arg);
+            return false;
+        }
+    }
+
+    if (options->settings.threadCount < 0) {
+        std::fprintf(stderr, "--threads must not be negative\n");
+        return false;
+    }
+    return true;
+}
+
+void printSummary(const EndgameTable &table)
+{
+    std::printf("board %dx%d, target %d, metric %s, %llu positions (%.1f MB)\n", table.boardSize(),
+                table.boardSize(), 1 << table.targetExponent(), EndgameTable::metricName(table.metric()),
+                static_cast<unsigned long long>(table.stateCount()),
+                table.stateCount() * sizeof(float) / (1024.0 * 1024.0));
+    std::printf("value of a new game: %.6f\n", table.initialValue());
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    EndgameTable table;
+    std::string error;
+    if (!options.info.empty()) {
+        if (!table.mapFile(options.info, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        printSummary(table);
+        return 0;
+    }
+
+    EndgameTable::Statistics statistics;
+    if (!table.generate(options.settings, &error, &statistics)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::printf("solved %llu positions in %d levels, %.2f s (%.0f positions/s)\n",
+                static_cast<unsigned long long>(statistics.states), statistics.levels, statistics.seconds,
+                statistics.states / statistics.seconds);
+    printSummary(table);
+
+    if (!table.saveFile(options.output, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    std::printf("-> %s\n", options.output.c_str());
+    return 0;
+}
@@ -0,0 +1,13 @@
+# 对局服务器的本机压力测试客户端，不链接任何 Qt 模块。只支持 Linux
+TEMPLATE = app
+TARGET = 2048loadgen
+
+CONFIG += console c++17
+CONFIG -= qt app_bundle
+
+!linux: error("2048loadgen needs Linux (epoll)")
+
+include(../../engine/engine.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,453 @@
+#include "counterrng.h"
+#include "gameprotocol.h"
+#include "gamestatistics.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using GameProtocol::Header;
+
+constexpr int kMaxEvents = 256;
+constexpr std::size_t kReadChunk = 64 * 1024;
+
+struct Options
+{
+    std::string unixPath;
+    int port = 2048;
+    int connections = 16;
+    // 所有连接合计的会话数
+    int sessions = 1000;
+    // 每个连接上同时在途的请求数
+    int pipeline = 8;
+    // 每个请求的移动数：1 用 Move，更多用 Moves
+    int batch = 1;
+    double duration = 10;
+    std::uint64_t seed = 0;
+    bool seeded = false;
+};
+
+// 已发出、等待响应的请求。服务器按顺序响应，所以每个连接一个先进先出队列
+struct Pending
+{
+    Clock::time_point sent;
+    std::uint8_t op;
+    // 会话在 Connection::sessions 中的下标，创建会话的请求为 -1
+    int session;
+};
+
+// 客户端看到的会话状态
+enum class SessionState : std::uint8_t {
+    Playing,
+    Over,
+    // 已经发出重新开始的请求，还没有收到响应
+    Restarting
+};
+
+struct Connection
+{
+    int fd = -1;
+    std::vector<std::uint8_t> input;
+    std::vector<std::uint8_t> output;
+    std::size_t outputOffset = 0;
+    std::deque<Pending> pending;
+    std::vector<std::uint32_t> sessions;
+    std::vector<SessionState> states;
+    // 还要创建的会话数
+    int toCreate = 0;
+    std::size_t nextSession = 0;
+    bool writing = false;
+    CounterRng random;
+};
+
+struct Results
+{
+    std::uint64_t requests = 0;
+    std::uint64_t moves = 0;
+    std::uint64_t games = 0;
+    std::uint64_t errors = 0;
+    // 往返延迟（纳秒）
+    QuantileSketch latency;
+    RunningMoments latencyMoments;
+};
+
+void printUsage(const char *program)
+{
+    std::printf("Usage: %s [options]\n"
+                "  --unix PATH         connect to a Unix domain socket at PATH\n"
+                "  --port N            connect to 127.0.0.1:N when --unix is not given\n"
+                "                      (default 2048)\n"
+                "  --connections N     client connections (default 16)\n"
+                "  --sessions N        game sessions spread over the connections (default 1000)\n"
+                "  --pipeline N        requests in flight per connection (default 8)\n"
+                "  --batch N           moves per request; 1 sends Move, more send Moves\n"
+                "                      (default 1)\n"
+                "  --duration S        seconds to run (default 10)\n"
+                "  --seed N            random seed of the move choices (default: random)\n"
+                "  --help              show this help\n",
+                program);
+}
+
+bool parseOptions(int argc, char *argv[], Options *options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage(argv[0]);
+            std::exit(0);
+        } else if (std::strcmp(arg, "--unix") == 0 && hasValue) {
+            options->unixPath = argv[++i];
+        } else if (std::strcmp(arg, "--port") == 0 && hasValue) {
+            options->port = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--connections") == 0 && hasValue) {
+            options->connections = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--sessions") == 0 && hasValue) {
+            options->sessions = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--pipeline") == 0 && hasValue) {
+            options->pipeline = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--batch") == 0 && hasValue) {
+            options->batch = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--duration") == 0 && hasValue) {
+            options->duration = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+            options->seed = std::strtoull(argv[++i], nullptr, 10);
+            options->seeded = true;
+        } else {
+            std::fprintf(stderr, "unknown or incomplete option: %s\n", arg);
+            return false;
+        }
+    }
+
+    if (options->port <= 0 || options->port > 65535) {
+        std::fprintf(stderr, "--port must be between 1 and 65535\n");
+        return false;
+    }
+    if (options->connections <= 0 || options->sessions < options->connections || options->pipeline <= 0) {
+        std::fprintf(stderr, "--connections and --pipeline must be positive, --sessions at least --connections\n");
+        return false;
+    }
+    if (options->batch <= 0 || options->batch > int(GameProtocol::MaxPayload)) {
+        std::fprintf(stderr, "--batch must be between 1 and %zu\n", GameProtocol::MaxPayload);
+        return false;
+    }
+    if (options->duration <= 0) {
+        std::fprintf(stderr, "--duration must be positive\n");
+        return false;
+    }
+    return true;
+}
+
+// 阻塞地连接，成功后切换为非阻塞
+int connectTo(const Options &options, std::string *error)
+{
+    int fd = -1;
+    if (options.unixPath.empty()) {
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(static_cast<std::uint16_t>(options.port));
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+            *error = "cannot connect to 127.0.0.1:" + std::to_string(options.port) + ": " + std::strerror(errno);
+            ::close(fd);
+            return -1;
+        }
+        const int noDelay = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    } else {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (options.unixPath.size() >= sizeof(address.sun_path)) {
+            *error = "socket path is too long: " + options.unixPath;
+            return -1;
+        }
+        std::strcpy(address.sun_path, options.unixPath.c_str());
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+            *error = "cannot connect to " + options.unixPath + ": " + std::strerror(errno);
+            ::close(fd);
+            return -1;
+        }
+    }
+    if (fd < 0) {
+        *error = std::string("socket: ") + std::strerror(errno);
+        return -1;
+    }
+    ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+// 把在途请求补满 pipeline 个：先创建会话，之后轮流为每个会话发一步（或一批）随机移动，
+// 已经结束的对局重新开始
+void fillPipeline(const Options &options, Connection *connection)
+{
+    std::uint8_t directions[GameProtocol::MaxPayload];
+    const Clock::time_point now = Clock::now();
+    while (int(connection->pending.size()) < options.pipeline) {
+        Header request;
+        int session = -1;
+        if (connection->toCreate > 0) {
+            request.op = GameProtocol::NewGame;
+            --connection->toCreate;
+        } else if (!connection->sessions.empty()) {
+            session = static_cast<int>(connection->nextSession++ % connection->sessions.size());
+            request.session = connection->sessions[session];
+            if (connection->states[session] == SessionState::Restarting) {
+                request.op = GameProtocol::GetState;
+            } else if (connection->states[session] == SessionState::Over) {
+                request.op = GameProtocol::NewGame;
+                connection->states[session] = SessionState::Restarting;
+            } else if (options.batch == 1) {
+                request.op = GameProtocol::Move;
+                request.arg = static_cast<std::uint8_t>(connection->random.bounded(4));
+            } else {
+                request.op = GameProtocol::Moves;
+                request.length = static_cast<std::uint16_t>(options.batch);
+                for (int i = 0; i < options.batch; ++i) {
+                    directions[i] = static_cast<std::uint8_t>(connection->random.bounded(4));
+                }
+            }
+        } else {
+            // 会话还没有创建完成
+            break;
+        }
+        GameProtocol::appendFrame(&connection->output, request, directions);
+        connection->pending.push_back({now, request.op, session});
+    }
+}
+
+// 处理所有完整的响应，返回 false 表示响应与请求对不上
+bool processInput(Connection *connection, Results *results)
+{
+    const std::vector<std::uint8_t> &input = connection->input;
+    const Clock::time_point now = Clock::now();
+    std::size_t offset = 0;
+    while (input.size() - offset >= GameProtocol::HeaderSize) {
+        const Header reply = GameProtocol::readHeader(input.data() + offset);
+        if (input.size() - offset < GameProtocol::HeaderSize + reply.length) {
+            break;
+        }
+        if (connection->pending.empty()) {
+            return false;
+        }
+        const Pending pending = connection->pending.front();
+        connection->pending.pop_front();
+
+        const double latency = std::chrono::duration<double, std::nano>(now - pending.sent).count();
+        results->latency.add(latency);
+        results->latencyMoments.add(latency);
+        ++results->requests;
+        if (reply.arg != GameProtocol::Ok) {
+            if (results->errors == 0) {
+                std::fprintf(stderr, "server: %s\n", GameProtocol::statusName(reply.arg));
+            }
+            ++results->errors;
+        } else if (reply.length == GameProtocol::StateSize) {
+            const GameProtocol::State state =
+                GameProtocol::readState(input.data() + offset + GameProtocol::HeaderSize);
+            int session = pending.session;
+            if (session < 0) {
+                session = static_cast<int>(connection->sessions.size());
+                connection->sessions.push_back(reply.session);
+                connection->states.push_back(SessionState::Playing);
+            }
+            // 响应按顺序到达：重新开始之前发出的移动的响应都在它前面
+            SessionState &sessionState = connection->states[session];
+            results->moves += state.applied;
+            if (pending.op == GameProtocol::NewGame) {
+                sessionState = SessionState::Playing;
+            } else if (state.gameOver && sessionState == SessionState::Playing) {
+                sessionState = SessionState::Over;
+                ++results->games;
+            }
+        }
+        offset += GameProtocol::HeaderSize + reply.length;
+    }
+    connection->input.erase(connection->input.begin(), connection->input.begin() + offset);
+    return true;
+}
+
+// 先收到所有连接共用的 receiveBuffer（kReadChunk 字节），只把收到的字节追加到连接的输入缓冲。
+// 返回 false 表示连接出错
+bool readResponses(Connection *connection, std::uint8_t *receiveBuffer, Results *results)
+{
+    std::vector<std::uint8_t> &input = connection->input;
+    for (;;) {
+        const ssize_t received = ::recv(connection->fd, receiveBuffer, kReadChunk, 0);
+        if (received > 0) {
+            input.insert(input.end(), receiveBuffer, receiveBuffer + received);
+            if (std::size_t(received) < kReadChunk) {
+                break;
+            }
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        return false;
+    }
+    return processInput(connection, results);
+}
+
+bool flush(int epollFd, Connection *connection)
+{
+    std::vector<std::uint8_t> &output = connection->output;
+    while (connection->outputOffset < output.size()) {
+        const ssize_t sent = ::send(connection->fd, output.data() + connection->outputOffset,
+                                    output.size() - connection->outputOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection->outputOffset += sent;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (connection->outputOffset == output.size()) {
+        output.clear();
+        connection->outputOffset = 0;
+    }
+    const bool writing = !output.empty();
+    if (writing != connection->writing) {
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | (writing ? std::uint32_t(EPOLLOUT) : 0u);
+        event.data.ptr = connection;
+        ::epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->writing = writing;
+    }
+    return true;
+}
+
+int runLoad(const Options &options)
+{
+    const int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd < 0) {
+        std::fprintf(stderr, "epoll_create1: %s\n", std::strerror(errno));
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Connection>> connections;
+    for (int i = 0; i < options.connections; ++i) {
+        std::string error;
+        const int fd = connectTo(options, &error);
+        if (fd < 0) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        connections.emplace_back(new Connection);
+        Connection *connection = connections.back().get();
+        connection->fd = fd;
+        // 会话尽量平均分给各个连接
+        connection->toCreate = options.sessions / options.connections + (i < options.sessions % options.connections);
+        connection->random.reset(options.seed, static_cast<std::uint64_t>(i));
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = connection;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+
+    Results results;
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point deadline =
+        start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+    for (std::unique_ptr<Connection> &connection : connections) {
+        fillPipeline(options, connection.get());
+        if (!flush(epollFd, connection.get())) {
+            std::fprintf(stderr, "send: %s\n", std::strerror(errno));
+            return 1;
+        }
+    }
+
+    epoll_event events[kMaxEvents];
+    std::unique_ptr<std::uint8_t[]> receiveBuffer(new std::uint8_t[kReadChunk]);
+    bool failed = false;
+    while (!failed && Clock::now() < deadline) {
+        const int count = ::epoll_wait(epollFd, events, kMaxEvents, 100);
+        if (count < 0 && errno != EINTR) {
+            std::fprintf(stderr, "epoll_wait: %s\n", std::strerror(errno));
+            return 1;
+        }
+        for (int i = 0; i < count && !failed; ++i) {
+            Connection *connection = static_cast<Connection *>(events[i].data.ptr);
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                std::fprintf(stderr, "connection closed by the server\n");
+                failed = true;
+            } else if ((events[i].events & EPOLLIN) && !readResponses(connection, receiveBuffer.get(), &results)) {
+                std::fprintf(stderr, "connection lost or protocol error\n");
+                failed = true;
+            } else {
+                fillPipeline(options, connection);
+                failed = !flush(epollFd, connection);
+            }
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    int sessions = 0;
+    for (std::unique_ptr<Connection> &connection : connections) {
+        sessions += static_cast<int>(connection->sessions.size());
+        ::close(connection->fd);
+    }
+    ::close(epollFd);
+
+    // 延迟是客户端看到的往返时间，包括在流水线里排队的时间
+    std::printf("connections  %d (pipeline %d, batch %d)\n", options.connections, options.pipeline, options.batch);
+    std::printf("sessions     %d\n", sessions);
+    std::printf("time         %.3f s\n", seconds);
+    std::printf("requests     %llu (%.0f/s)\n", static_cast<unsigned long long>(results.requests),
+                results.requests / seconds);
+    std::printf("moves        %llu (%.0f/s)\n", static_cast<unsigned long long>(results.moves),
+                results.moves / seconds);
+    std::printf("games        %llu finished\n", static_cast<unsigned long long>(results.games));
+    std::printf("errors       %llu\n", static_cast<unsigned long long>(results.errors));
+    std::printf("round trip   mean %.1f us  p50 %.1f us  p99 %.1f us  max %.1f us\n",
+                results.latencyMoments.mean() / 1000,
+                results.latency.quantile(0.50) / 1000, results.latency.quantile(0.99) / 1000,
+                results.latencyMoments.max() / 1000);
+    return failed ? 1 : 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!options.seeded) {
+        options.seed = std::random_device()();
+    }
+    return runLoad(options);
+}
@@ -0,0 +1,359 @@
+#include "boardrenderer.h"
+#include "gamejournal.h"
+#include "movedelta.h"
+#include "tilestyle.h"
+#include "workstealingpool.h"
+
+#include <QDir>
+#include <QGuiApplication>
+#include <QImage>
+#include <QString>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// 一次读入这么多帧再交给线程池；编码线程在线程池渲染下一批时继续处理上一批
+constexpr std::size_t kChunkFrames = 4096;
+// 每次从队列取的帧数；单帧渲染在 0.1 ms 量级，太小的批次会让取任务的开销显得明显
+constexpr std::size_t kRenderBatch = 8;
+
+struct Options
+{
+    std::string file;
+    QString outDir;
+    long long game = -1;
+    long long games = -1;
+    int size = 370;
+    int fps = 60;
+    bool tweens = true;
+    int threads = 0;
+    int encoders = 0;
+    int quality = -1;
+};
+
+void printUsage(const char *program)
+{
+    std::printf("Usage: %s JOURNAL --out DIR [options]\n"
+                "  --out DIR       write DIR/gameGGGGGG_FFFFFF.png (created if missing)\n"
+                "  --game N        render only game N (0-based)\n"
+                "  --games N       render at most N games (default: all)\n"
+                "  --size PX       image width and height (default 370, the window's board)\n"
+                "  --fps N         tween frames per second of animation (default 60)\n"
+                "  --no-tweens     one frame per move, without the slide/merge/spawn animation\n"
+                "  --threads N     render threads (default: all hardware threads)\n"
+                "  --encoders N    PNG encoder threads (default: all hardware threads)\n"
+                "  --quality Q     passed to QImage::save, -1 for the default compression\n"
+                "  --help          show this help\n",
+                program);
+}
+
+bool parseOptions(int argc, char *argv[], Options *options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage(argv[0]);
+            std::exit(0);
+        } else if (std::strcmp(arg, "--out") == 0 && hasValue) {
+            options->outDir = QString::fromLocal8Bit(argv[++i]);
+        } else if (std::strcmp(arg, "--game") == 0 && hasValue) {
+            options->game = std::atoll(argv[++i]);
+        } else if (std::strcmp(arg, "--games") == 0 && hasValue) {
+            options->games = std::atoll(argv[++i]);
+        } else if (std::strcmp(arg, "--size") == 0 && hasValue) {
+            options->size = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--fps") == 0 && hasValue) {
+            options->fps = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--no-tweens") == 0) {
+            options->tweens = false;
+        } else if (std::strcmp(arg, "--threads") == 0 && hasValue) {
+            options->threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--encoders") == 0 && hasValue) {
+            options->encoders = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--quality") == 0 && hasValue) {
+            options->quality = std::atoi(argv[++i]);
+        } else if (arg[0] != '-' && options->file.empty()) {
+            options->file = arg;
+        } else {
+            std::fprintf(stderr, "unknown or incomplete option: %s\n", arg);
+            return false;
+        }
+    }
+    if (options->size < 16 || options->fps <= 0) {
+        std::fprintf(stderr, "--size must be at least 16 and --fps positive\n");
+        return false;
+    }
+    return !options->file.empty() && !options->outDir.isEmpty();
+}
+
+// 一帧的全部输入，渲染线程只读这个结构，不接触日志
+struct FrameJob
+{
+    BoardState before;
+    BoardState after;
+    BoardState::Direction direction;
+    int spawnCell;
+    int spawnExponent;
+    // 负数表示静止的开局画面
+    float elapsedMs;
+    long long game;
+    int frame;
+};
+
+struct EncodedFrame
+{
+    QImage image;
+    long long game;
+    int frame;
+};
+
+// 渲染线程和编码线程之间的有界队列；队列满时渲染线程等待，内存占用不随日志长度增长
+class FrameQueue
+{
+public:
+    explicit FrameQueue(std::size_t capacity) : m_capacity(capacity) {}
+
+    void push(EncodedFrame frame)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notFull.wait(lock, [this] { return m_frames.size() < m_capacity; });
+        m_frames.push_back(std::move(frame));
+        m_notEmpty.notify_one();
+    }
+
+    // 队列已关闭且取空时返回 false
+    bool pop(EncodedFrame *frame)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return !m_frames.empty() || m_closed; });
+        if (m_frames.empty()) {
+            return false;
+        }
+        *frame = std::move(m_frames.front());
+        m_frames.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_notEmpty.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::deque<EncodedFrame> m_frames;
+    std::size_t m_capacity;
+    bool m_closed = false;
+};
+
+class FrameRenderer
+{
+public:
+    FrameRenderer(const Options &options, FrameQueue *queue)
+        : m_queue(queue)
+        , m_pool(options.threads)
+    {
+        m_renderers.reserve(m_pool.threadCount());
+        for (int i = 0; i < m_pool.threadCount(); ++i) {
+            m_renderers.push_back(std::make_unique<BoardRenderer>(options.size));
+        }
+        m_seconds.assign(m_pool.threadCount(), 0.0);
+    }
+
+    int threadCount() const { return m_pool.threadCount(); }
+
+    void render(const std::vector<FrameJob> &jobs)
+    {
+        m_pool.run(jobs.size(), kRenderBatch, [&](int worker, std::size_t begin, std::size_t end) {
+            BoardRenderer &renderer = *m_renderers[worker];
+            for (std::size_t i = begin; i < end; ++i) {
+                const auto start = std::chrono::steady_clock::now();
+                const FrameJob &job = jobs[i];
+                // 每帧一张新图像：上一张还在编码队列里，复用会触发隐式共享的拷贝
+                QImage image = renderer.createImage();
+                if (job.elapsedMs < 0) {
+                    renderer.render(job.after, &image);
+                } else {
+                    MoveDelta delta;
+                    MoveDelta::trace(job.before, job.direction, &delta);
+                    delta.spawnCell = job.spawnCell;
+                    delta.spawnExponent = job.spawnExponent;
+                    renderer.renderMove(job.before, delta, job.after, job.elapsedMs, &image);
+                }
+                m_seconds[worker] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                m_queue->push({std::move(image), job.game, job.frame});
+            }
+        });
+    }
+
+    // 所有线程的渲染时间之和（不含等待编码队列的时间）
+    double renderSeconds() const
+    {
+        double total = 0;
+        for (double seconds : m_seconds) {
+            total += seconds;
+        }
+        return total;
+    }
+
+private:
+    FrameQueue *m_queue;
+    WorkStealingPool m_pool;
+    std::vector<std::unique_ptr<BoardRenderer>> m_renderers;
+    std::vector<double> m_seconds;
+};
+
+QString framePath(const QString &dir, long long game, int frame)
+{
+    return QStringLiteral("%1/game%2_%3.png")
+        .arg(dir)
+        .arg(game, 6, 10, QLatin1Char('0'))
+        .arg(frame, 6, 10, QLatin1Char('0'));
+}
+
+// 把一局展开成帧：开局一帧，每步若干过渡帧，最后一帧总是这一步动画结束后的局面
+void appendFrames(const JournalGame &game, long long gameIndex, const Options &options, std::vector<FrameJob> *jobs)
+{
+    const int tweens = options.tweens ? (TileStyle::MoveAnimationMs * options.fps + 999) / 1000 : 1;
+    int frame = 0;
+    jobs->push_back({game.initialState(), game.initialState(), BoardState::Direction::Left, -1, 0, -1.0f,
+                     gameIndex, frame++});
+    game.replay([&](const JournalGame::Step &step) {
+        for (int k = 1; k <= tweens; ++k) {
+            const float elapsed = k == tweens ? float(TileStyle::MoveAnimationMs) : k * 1000.0f / options.fps;
+            jobs->push_back({step.before, step.after, step.direction, step.spawnCell, step.spawnExponent,
+                             elapsed, gameIndex, frame++});
+        }
+        return true;
+    });
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    // 字体数据库需要 QGuiApplication；之后的绘制都在工作线程里进行
+    QGuiApplication app(argc, argv);
+
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!QDir().mkpath(options.outDir)) {
+        std::fprintf(stderr, "cannot create %s\n", qPrintable(options.outDir));
+        return 1;
+    }
+
+    JournalReader reader;
+    std::string error;
+    if (!reader.open(options.file, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    long long gameIndex = 0;
+    long long gameLimit = options.games;
+    if (options.game >= 0) {
+        if (!reader.skipGames(options.game, &error)) {
+            std::fprintf(stderr, "game %lld: %s\n", options.game, error.empty() ? "not found" : error.c_str());
+            return 1;
+        }
+        gameIndex = options.game;
+        gameLimit = 1;
+    }
+
+    const int encoderCount = options.encoders > 0
+                           ? options.encoders
+                           : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    FrameQueue queue(static_cast<std::size_t>(encoderCount) * 4);
+    FrameRenderer renderer(options, &queue);
+
+    // 编码线程：PNG 压缩比渲染慢得多，单独成组，与渲染重叠进行
+    std::atomic<long long> encodeNanoseconds{0};
+    std::atomic<long long> failures{0};
+    std::vector<std::thread> encoders;
+    for (int i = 0; i < encoderCount; ++i) {
+        encoders.emplace_back([&] {
+            EncodedFrame frame;
+            while (queue.pop(&frame)) {
+                const auto start = std::chrono::steady_clock::now();
+                const QString path = framePath(options.outDir, frame.game, frame.frame);
+                if (!frame.image.save(path, "PNG", options.quality)) {
+                    if (failures.fetch_add(1) == 0) {
+                        std::fprintf(stderr, "cannot write %s\n", qPrintable(path));
+                    }
+                }
+                frame.image = QImage();
+                encodeNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now() - start).count();
+            }
+        });
+    }
+
+    long long games = 0;
+    long long frames = 0;
+    std::vector<FrameJob> jobs;
+    jobs.reserve(kChunkFrames);
+    JournalGame game;
+    const auto start = std::chrono::steady_clock::now();
+    while ((gameLimit < 0 || games < gameLimit) && reader.nextGame(&game, &error)) {
+        appendFrames(game, gameIndex++, options, &jobs);
+        ++games;
+        if (jobs.size() >= kChunkFrames) {
+            renderer.render(jobs);
+            frames += static_cast<long long>(jobs.size());
+            jobs.clear();
+        }
+    }
+    if (!jobs.empty()) {
+        renderer.render(jobs);
+        frames += static_cast<long long>(jobs.size());
+    }
+    queue.close();
+    for (std::thread &encoder : encoders) {
+        encoder.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!error.empty()) {
+        std::fprintf(stderr, "after game %lld: %s\n", gameIndex, error.c_str());
+        return 1;
+    }
+
+    std::printf("games       %lld\n", games);
+    std::printf("frames      %lld (%dx%d, %s)\n", frames, options.size, options.size,
+                options.tweens ? qPrintable(QStringLiteral("%1 fps tweens").arg(options.fps)) : "no tweens");
+    std::printf("threads     %d render, %d encode\n", renderer.threadCount(), encoderCount);
+    std::printf("time        %.3f s\n", seconds);
+    if (frames > 0) {
+        std::printf("frames/sec  %.1f\n", frames / seconds);
+        std::printf("render      %.3f ms/frame\n", renderer.renderSeconds() * 1000.0 / frames);
+        std::printf("encode      %.3f ms/frame\n", encodeNanoseconds.load() / 1e6 / frames);
+    }
+    if (failures > 0) {
+        std::fprintf(stderr, "%lld frames could not be written\n", failures.load());
+        return 1;
+    }
+    return 0;
+}
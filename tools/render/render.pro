@@ -0,0 +1,25 @@
+# 把对局日志离屏渲染成 PNG 图像序列。只需要 QtGui（QImage、QPainter），
+# 没有显示器时自动使用 offscreen 平台插件。
+QT += core gui
+QT -= widgets
+
+TARGET = 2048render
+
+CONFIG += console c++17 thread
+CONFIG -= app_bundle
+
+unix: LIBS += -pthread
+
+include(../../engine/engine.pri)
+
+INCLUDEPATH += ../..
+DEPENDPATH += ../..
+
+SOURCES += \
+    ../../tilestyle.cpp \
+    ../../boardrenderer.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../tilestyle.h \
+    ../../boardrenderer.h
@@ -0,0 +1,143 @@
+#include "gamejournal.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace {
+
+struct Options
+{
+    std::string file;
+    long long game = -1;
+    int move = -1;
+    bool verify = false;
+};
+
+void printUsage(const char *program)
+{
+    std::printf("Usage: %s JOURNAL [options]\n"
+                "  --game N     show game N (0-based) instead of replaying the whole journal\n"
+                "  --move M     with --game, show the position after M moves (default: final)\n"
+                "  --verify     check that every recorded move and spawn is legal\n"
+                "  --help       show this help\n",
+                program);
+}
+
+bool parseOptions(int argc, char *argv[], Options *options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage(argv[0]);
+            std::exit(0);
+        } else if (std::strcmp(arg, "--game") == 0 && hasValue) {
+            options->game = std::atoll(argv[++i]);
+        } else if (std::strcmp(arg, "--move") == 0 && hasValue) {
+            options->move = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--verify") == 0) {
+            options->verify = true;
+        } else if (arg[0] != '-' && options->file.empty()) {
+            options->file = arg;
+        } else {
+            std::fprintf(stderr, "unknown or incomplete option: %s\n", arg);
+            return false;
+        }
+    }
+    return !options->file.empty();
+}
+
+void printBoard(BoardState board)
+{
+    for (int row = 0; row < BoardState::Size; ++row) {
+        for (int col = 0; col < BoardState::Size; ++col) {
+            std::printf("%6d", board.tileAt(row, col));
+        }
+        std::printf("\n");
+    }
+}
+
+int showGame(JournalReader &reader, const Options &options)
+{
+    std::string error;
+    JournalGame game;
+    if (!reader.skipGames(options.game, &error) || !reader.nextGame(&game, &error)) {
+        std::fprintf(stderr, "game %lld: %s\n", options.game, error.empty() ? "not found" : error.c_str());
+        return 1;
+    }
+
+    if (options.verify && !game.verify(&error)) {
+        std::fprintf(stderr, "game %lld: %s\n", options.game, error.c_str());
+        return 1;
+    }
+
+    const JournalGame::Position position = game.positionAt(options.move < 0 ? game.moveCount() : options.move);
+    std::printf("game %lld: %d moves%s\n", options.game, game.moveCount(), game.isFinished() ? "" : " (unfinished)");
+    std::printf("after move %d, score %d\n", position.moves, position.score);
+    printBoard(position.board);
+    return 0;
+}
+
+int replayAll(JournalReader &reader, const Options &options)
+{
+    long long games = 0;
+    long long finished = 0;
+    long long moves = 0;
+    double totalScore = 0;
+    int maxScore = 0;
+
+    std::string error;
+    JournalGame game;
+    const auto start = std::chrono::steady_clock::now();
+    while (reader.nextGame(&game, &error)) {
+        if (options.verify && !game.verify(&error)) {
+            std::fprintf(stderr, "game %lld: %s\n", games, error.c_str());
+            return 1;
+        }
+        const JournalGame::Position position = game.finalPosition();
+        ++games;
+        finished += game.isFinished() ? 1 : 0;
+        moves += position.moves;
+        totalScore += position.score;
+        maxScore = std::max(maxScore, position.score);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (!error.empty()) {
+        std::fprintf(stderr, "after game %lld: %s\n", games, error.c_str());
+        return 1;
+    }
+
+    std::printf("games      %lld (%lld finished)\n", games, finished);
+    std::printf("moves      %lld\n", moves);
+    std::printf("time       %.3f s\n", seconds);
+    std::printf("games/sec  %.1f\n", games / seconds);
+    std::printf("moves/sec  %.1f\n", moves / seconds);
+    if (games > 0) {
+        std::printf("mean score %.1f (max %d)\n", totalScore / games, maxScore);
+    }
+    return 0;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    JournalReader reader;
+    std::string error;
+    if (!reader.open(options.file, &error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    return options.game >= 0 ? showGame(reader, options) : replayAll(reader, options);
+}
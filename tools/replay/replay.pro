@@ -0,0 +1,11 @@
+# 对局日志重放与分析程序，不链接任何 Qt 模块
+TEMPLATE = app
+TARGET = 2048replay
+
+CONFIG += console c++17
+CONFIG -= qt app_bundle
+
+include(../../engine/engine.pri)
+
+SOURCES += \
+    main.cpp
@@ -0,0 +1,747 @@
+#include "gamecore.h"
+#include "gameprotocol.h"
+#include "gamestatistics.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using GameProtocol::Header;
+
+constexpr int kMaxEvents = 256;
+constexpr std::size_t kReadChunk = 64 * 1024;
+// 待发送的响应超过这个大小时暂停读取该连接，直到客户端读走响应
+constexpr std::size_t kOutputLimit = 1 << 20;
+// 会话号的低 20 位是会话槽，高 12 位是槽的代号，槽被重用后旧的会话号不再有效
+constexpr int kSlotBits = 20;
+constexpr std::uint32_t kSlotMask = (1u << kSlotBits) - 1;
+constexpr std::uint32_t kMaxGeneration = (1u << (32 - kSlotBits)) - 1;
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void handleSignal(int)
+{
+    g_stop = 1;
+}
+
+struct Options
+{
+    // 非空时监听 Unix 域套接字，否则监听 127.0.0.1:port
+    std::string unixPath;
+    int port = 2048;
+    int maxSessions = 100000;
+    double reportInterval = 5;
+    // 运行这么多秒后退出，0 表示一直运行到 SIGINT/SIGTERM
+    double duration = 0;
+    std::uint64_t seed = 0;
+    bool seeded = false;
+};
+
+struct Session
+{
+    Session()
+        : game(0)
+    {
+    }
+
+    GameCore game;
+    // 创建会话的连接，空闲的槽为 -1
+    int owner = -1;
+    std::uint32_t generation = 0;
+};
+
+struct Connection
+{
+    int fd = -1;
+    std::vector<std::uint8_t> input;
+    std::vector<std::uint8_t> output;
+    std::size_t outputOffset = 0;
+    // 这个连接创建的会话，断开时全部结束
+    std::vector<std::uint32_t> sessions;
+    // 当前向 epoll 注册的事件
+    std::uint32_t events = 0;
+
+    std::size_t pendingOutput() const { return output.size() - outputOffset; }
+};
+
+// 一段时间内的请求数、移动数和延迟（纳秒）
+struct Counters
+{
+    std::uint64_t requests = 0;
+    std::uint64_t moves = 0;
+    QuantileSketch latency;
+
+    void clear() { *this = Counters(); }
+};
+
+// 缓冲区开头是否有一个完整的请求（或一个长度非法、处理时会被拒绝的请求头）
+bool hasCompleteRequest(const std::vector<std::uint8_t> &input)
+{
+    if (input.size() < GameProtocol::HeaderSize) {
+        return false;
+    }
+    const Header request = GameProtocol::readHeader(input.data());
+    return request.length > GameProtocol::MaxPayload || input.size() >= GameProtocol::HeaderSize + request.length;
+}
+
+void printUsage(const char *program)
+{
+    std::printf("Usage: %s [options]\n"
+                "  --unix PATH         listen on a Unix domain socket at PATH\n"
+                "  --port N            listen on 127.0.0.1:N when --unix is not given\n"
+                "                      (default 2048)\n"
+                "  --max-sessions N    concurrent session limit, at most 1048576\n"
+                "                      (default 100000)\n"
+                "  --report S          seconds between statistics lines (default 5)\n"
+                "  --duration S        exit after S seconds, 0 = run until interrupted\n"
+                "                      (default 0)\n"
+                "  --seed N            base random seed of new sessions (default: random)\n"
+                "  --help              show this help\n",
+                program);
+}
+
+bool parseOptions(int argc, char *argv[], Options *options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage(argv[0]);
+            std::exit(0);
+        } else if (std::strcmp(arg, "--unix") == 0 && hasValue) {
+            options->unixPath = argv[++i];
+        } else if (std::strcmp(arg, "--port") == 0 && hasValue) {
+            options->port = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--max-sessions") == 0 && hasValue) {
+            options->maxSessions = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--report") == 0 && hasValue) {
+            options->reportInterval = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--duration") == 0 && hasValue) {
+            options->duration = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+            options->seed = std::strtoull(argv[++i], nullptr, 10);
+            options->seeded = true;
+        } else {
+            std::fprintf(stderr, "unknown or incomplete option: %s\n", arg);
+            return false;
+        }
+    }
+
+    if (options->port <= 0 || options->port > 65535) {
+        std::fprintf(stderr, "--port must be between 1 and 65535\n");
+        return false;
+    }
+    if (options->maxSessions <= 0 || options->maxSessions > int(kSlotMask) + 1) {
+        std::fprintf(stderr, "--max-sessions must be between 1 and %u\n", kSlotMask + 1);
+        return false;
+    }
+    if (options->reportInterval <= 0 || options->duration < 0) {
+        std::fprintf(stderr, "--report must be positive and --duration must not be negative\n");
+        return false;
+    }
+    return true;
+}
+
+// 单线程的事件循环：所有连接都是非阻塞的，由一个 epoll 实例（水平触发）分发，每个会话只是一个 GameCore。
+// 一次可读事件读出所有已到达的请求，依次处理后把全部响应合并成一次 send()，
+// 流水线的客户端因此每批请求只花一次系统调用往返。
+class GameServer
+{
+public:
+    explicit GameServer(const Options &options);
+    ~GameServer();
+
+    GameServer(const GameServer &) = delete;
+    GameServer &operator=(const GameServer &) = delete;
+
+    bool listen(std::string *error);
+    bool run(std::string *error);
+
+private:
+    void acceptConnections();
+    void closeConnection(Connection *connection);
+    void handleReadable(Connection *connection);
+    // 处理缓冲区中所有完整的请求，返回处理的个数；协议错误时返回 -1
+    long processInput(Connection *connection);
+    void handleRequest(Connection *connection, const Header &request, const std::uint8_t *payload);
+    void respond(Connection *connection, const Header &request, std::uint8_t status, const Session *session,
+                 int applied);
+    bool flush(Connection *connection);
+    void updateEvents(Connection *connection);
+
+    Session *findSession(const Connection *connection, std::uint32_t id);
+    // 返回新会话号，达到会话上限时返回 0
+    std::uint32_t createSession(Connection *connection);
+    void closeSession(std::uint32_t id);
+
+    void report(double elapsed);
+    void printSummary(double elapsed);
+
+    Options m_options;
+    int m_listenFd;
+    int m_epollFd;
+    // 按文件描述符索引
+    std::vector<std::unique_ptr<Connection>> m_connections;
+    std::vector<Session> m_sessions;
+    std::vector<std::uint32_t> m_freeSlots;
+    int m_activeSessions;
+    int m_peakSessions;
+    int m_activeConnections;
+    std::uint64_t m_acceptedConnections;
+    std::uint64_t m_createdSessions;
+    std::uint64_t m_nextStream;
+
+    Counters m_interval;
+    Counters m_total;
+    // 所有连接共用的接收缓冲，只把实际收到的字节追加到连接的输入缓冲
+    std::unique_ptr<std::uint8_t[]> m_receiveBuffer;
+};
+
+GameServer::GameServer(const Options &options)
+    : m_options(options)
+    , m_listenFd(-1)
+    , m_epollFd(-1)
+    , m_activeSessions(0)
+    , m_peakSessions(0)
+    , m_activeConnections(0)
+    , m_acceptedConnections(0)
+    , m_createdSessions(0)
+    , m_nextStream(0)
+    , m_receiveBuffer(new std::uint8_t[kReadChunk])
+{
+}
+
+GameServer::~GameServer()
+{
+    for (std::unique_ptr<Connection> &connection : m_connections) {
+        if (connection) {
+            ::close(connection->fd);
+        }
+    }
+    if (m_listenFd >= 0) {
+        ::close(m_listenFd);
+        if (!m_options.unixPath.empty()) {
+            ::unlink(m_options.unixPath.c_str());
+        }
+    }
+    if (m_epollFd >= 0) {
+        ::close(m_epollFd);
+    }
+}
+
+bool GameServer::listen(std::string *error)
+{
+    if (m_options.unixPath.empty()) {
+        m_listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_listenFd >= 0) {
+            const int reuse = 1;
+            ::setsockopt(m_listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+            sockaddr_in address;
+            std::memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_port = htons(static_cast<std::uint16_t>(m_options.port));
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if (::bind(m_listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+                *error = "cannot bind 127.0.0.1:" + std::to_string(m_options.port) + ": " + std::strerror(errno);
+                return false;
+            }
+        }
+    } else {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (m_options.unixPath.size() >= sizeof(address.sun_path)) {
+            *error = "socket path is too long: " + m_options.unixPath;
+            return false;
+        }
+        std::strcpy(address.sun_path, m_options.unixPath.c_str());
+        m_listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (m_listenFd >= 0) {
+            // 上次运行留下的套接字文件
+            ::unlink(m_options.unixPath.c_str());
+            if (::bind(m_listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+                *error = "cannot bind " + m_options.unixPath + ": " + std::strerror(errno);
+                return false;
+            }
+        }
+    }
+    if (m_listenFd < 0 || ::listen(m_listenFd, SOMAXCONN) != 0) {
+        *error = std::string("cannot listen: ") + std::strerror(errno);
+        return false;
+    }
+
+    m_epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd < 0) {
+        *error = std::string("epoll_create1: ") + std::strerror(errno);
+        return false;
+    }
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = m_listenFd;
+    if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_listenFd, &event) != 0) {
+        *error = std::string("epoll_ctl: ") + std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool GameServer::run(std::string *error)
+{
+    const Clock::time_point start = Clock::now();
+    const auto elapsedSince = [&start](Clock::time_point now) {
+        return std::chrono::duration<double>(now - start).count();
+    };
+    double nextReport = m_options.reportInterval;
+
+    epoll_event events[kMaxEvents];
+    while (!g_stop) {
+        // 超时只用于按时输出统计和检查退出条件
+        const int count = ::epoll_wait(m_epollFd, events, kMaxEvents, 100);
+        if (count < 0 && errno != EINTR) {
+            *error = std::string("epoll_wait: ") + std::strerror(errno);
+            return false;
+        }
+        for (int i = 0; i < count; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == m_listenFd) {
+                acceptConnections();
+                continue;
+            }
+            Connection *connection = fd < int(m_connections.size()) ? m_connections[fd].get() : nullptr;
+            if (!connection) {
+                continue;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeConnection(connection);
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && !flush(connection)) {
+                closeConnection(connection);
+                continue;
+            }
+            // 发送缓冲腾出空间后继续处理之前因背压暂停的请求
+            if ((events[i].events & EPOLLIN)
+                    || (!connection->input.empty() && connection->pendingOutput() < kOutputLimit)) {
+                handleReadable(connection);
+            }
+        }
+
+        const double elapsed = elapsedSince(Clock::now());
+        if (elapsed >= nextReport) {
+            report(elapsed);
+            nextReport += m_options.reportInterval;
+        }
+        if (m_options.duration > 0 && elapsed >= m_options.duration) {
+            break;
+        }
+    }
+    printSummary(elapsedSince(Clock::now()));
+    return true;
+}
+
+void GameServer::acceptConnections()
+{
+    for (;;) {
+        const int fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::fprintf(stderr, "accept: %s\n", std::strerror(errno));
+            }
+            return;
+        }
+        if (m_options.unixPath.empty()) {
+            // 小响应立即发出，不等待 Nagle 合并
+            const int noDelay = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        }
+
+        if (fd >= int(m_connections.size())) {
+            m_connections.resize(fd + 1);
+        }
+        m_connections[fd].reset(new Connection);
+        Connection *connection = m_connections[fd].get();
+        connection->fd = fd;
+        connection->events = EPOLLIN;
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = connection->events;
+        event.data.fd = fd;
+        if (::epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+            std::fprintf(stderr, "epoll_ctl: %s\n", std::strerror(errno));
+            ::close(fd);
+            m_connections[fd].reset();
+            continue;
+        }
+        ++m_activeConnections;
+        ++m_acceptedConnections;
+    }
+}
+
+void GameServer::closeConnection(Connection *connection)
+{
+    for (std::uint32_t id : connection->sessions) {
+        closeSession(id);
+    }
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_DEL, connection->fd, nullptr);
+    ::close(connection->fd);
+    --m_activeConnections;
+    m_connections[connection->fd].reset();
+}
+
+void GameServer::handleReadable(Connection *connection)
+{
+    std::vector<std::uint8_t> &input = connection->input;
+    bool closed = false;
+    while (connection->pendingOutput() < kOutputLimit) {
+        const ssize_t received = ::recv(connection->fd, m_receiveBuffer.get(), kReadChunk, 0);
+        if (received > 0) {
+            input.insert(input.end(), m_receiveBuffer.get(), m_receiveBuffer.get() + received);
+            if (std::size_t(received) < kReadChunk) {
+                break;
+            }
+            continue;
+        }
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        // 对方关闭时仍然处理已经收到的请求，但不再发送响应
+        closed = received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        break;
+    }
+
+    // 同一次读到的请求共用一个到达时间，延迟是从读到请求到响应交给内核
+    const Clock::time_point received = Clock::now();
+    long processed = 0;
+    for (;;) {
+        const long count = processInput(connection);
+        if (count < 0 || closed || !flush(connection)) {
+            closeConnection(connection);
+            return;
+        }
+        processed += count;
+        // 因背压留在缓冲区中的请求不会再触发可读事件；响应全部交给内核后要接着处理，
+        // 否则只注册了 EPOLLIN 的连接再也收不到事件，等待响应的客户端会一直挂起
+        if (count == 0 || connection->pendingOutput() >= kOutputLimit || !hasCompleteRequest(connection->input)) {
+            break;
+        }
+    }
+    if (processed > 0) {
+        const double latency = std::chrono::duration<double, std::nano>(Clock::now() - received).count();
+        m_interval.requests += processed;
+        m_interval.latency.add(latency, processed);
+    }
+}
+
+long GameServer::processInput(Connection *connection)
+{
+    const std::vector<std::uint8_t> &input = connection->input;
+    std::size_t offset = 0;
+    long processed = 0;
+    while (input.size() - offset >= GameProtocol::HeaderSize && connection->pendingOutput() < kOutputLimit) {
+        const Header request = GameProtocol::readHeader(input.data() + offset);
+        if (request.length > GameProtocol::MaxPayload) {
+            return -1;
+        }
+        if (input.size() - offset < GameProtocol::HeaderSize + request.length) {
+            break;
+        }
+        handleRequest(connection, request, input.data() + offset + GameProtocol::HeaderSize);
+        offset += GameProtocol::HeaderSize + request.length;
+        ++processed;
+    }
+    connection->input.erase(connection->input.begin(), connection->input.begin() + offset);
+    return processed;
+}
+
+void GameServer::handleRequest(Connection *connection, const Header &request, const std::uint8_t *payload)
+{
+    if (request.op == GameProtocol::NewGame) {
+        if (request.length != 0 && request.length != 8) {
+            respond(connection, request, GameProtocol::BadRequest, nullptr, 0);
+            return;
+        }
+        Header reply = request;
+        if (request.session == 0) {
+            reply.session = createSession(connection);
+            if (reply.session == 0) {
+                respond(connection, request, GameProtocol::SessionLimit, nullptr, 0);
+                return;
+            }
+        }
+        Session *session = findSession(connection, reply.session);
+        if (!session) {
+            respond(connection, request, GameProtocol::UnknownSession, nullptr, 0);
+            return;
+        }
+        if (request.length == 8) {
+            std::uint64_t seed = 0;
+            for (int i = 0; i < 8; ++i) {
+                seed |= std::uint64_t(payload[i]) << (8 * i);
+            }
+            session->game.seed(seed);
+        } else {
+            session->game.seed(m_options.seed, m_nextStream++);
+        }
+        session->game.newGame();
+        respond(connection, reply, GameProtocol::Ok, session, 0);
+        return;
+    }
+
+    Session *session = findSession(connection, request.session);
+    if (!session) {
+        respond(connection, request, GameProtocol::UnknownSession, nullptr, 0);
+        return;
+    }
+    switch (request.op) {
+    case GameProtocol::Move: {
+        if (request.arg > 3 || request.length != 0) {
+            respond(connection, request, GameProtocol::BadRequest, nullptr, 0);
+            return;
+        }
+        const int applied = session->game.move(static_cast<GameCore::Direction>(request.arg)) ? 1 : 0;
+        respond(connection, request, GameProtocol::Ok, session, applied);
+        return;
+    }
+    case GameProtocol::Moves: {
+        for (std::size_t i = 0; i < request.length; ++i) {
+            if (payload[i] > 3) {
+                respond(connection, request, GameProtocol::BadRequest, nullptr, 0);
+                return;
+            }
+        }
+        int applied = 0;
+        for (std::size_t i = 0; i < request.length && !session->game.isGameOver(); ++i) {
+            applied += session->game.move(static_cast<GameCore::Direction>(payload[i])) ? 1 : 0;
+        }
+        respond(connection, request, GameProtocol::Ok, session, applied);
+        return;
+    }
+    case GameProtocol::GetState:
+        respond(connection, request, GameProtocol::Ok, session, 0);
+        return;
+    case GameProtocol::Close:
+        closeSession(request.session);
+        connection->sessions.erase(std::find(connection->sessions.begin(), connection->sessions.end(),
+                                             request.session));
+        respond(connection, request, GameProtocol::Ok, nullptr, 0);
+        return;
+    default:
+        respond(connection, request, GameProtocol::BadRequest, nullptr, 0);
+        return;
+    }
+}
+
+void GameServer::respond(Connection *connection, const Header &request, std::uint8_t status, const Session *session,
+                         int applied)
+{
+    Header reply = request;
+    reply.arg = status;
+    reply.length = session ? GameProtocol::StateSize : 0;
+    std::uint8_t payload[GameProtocol::StateSize];
+    if (session) {
+        GameProtocol::State state;
+        state.board = session->game.state().bits();
+        state.score = static_cast<std::uint32_t>(session->game.score());
+        state.moves = static_cast<std::uint32_t>(session->game.moveCount());
+        state.applied = static_cast<std::uint16_t>(applied);
+        state.gameOver = session->game.isGameOver();
+        GameProtocol::writeState(payload, state);
+    }
+    GameProtocol::appendFrame(&connection->output, reply, payload);
+    m_interval.moves += static_cast<std::uint64_t>(applied);
+}
+
+bool GameServer::flush(Connection *connection)
+{
+    std::vector<std::uint8_t> &output = connection->output;
+    while (connection->outputOffset < output.size()) {
+        const ssize_t sent = ::send(connection->fd, output.data() + connection->outputOffset,
+                                    output.size() - connection->outputOffset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            connection->outputOffset += sent;
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        return false;
+    }
+    if (connection->outputOffset == output.size()) {
+        output.clear();
+        connection->outputOffset = 0;
+    } else if (connection->outputOffset >= kOutputLimit / 2) {
+        output.erase(output.begin(), output.begin() + connection->outputOffset);
+        connection->outputOffset = 0;
+    }
+    updateEvents(connection);
+    return true;
+}
+
+void GameServer::updateEvents(Connection *connection)
+{
+    // 有待发送的响应时等待可写；积压过多时不再读取，让客户端感受到背压
+    std::uint32_t events = 0;
+    if (connection->pendingOutput() < kOutputLimit) {
+        events |= EPOLLIN;
+    }
+    if (connection->pendingOutput() > 0) {
+        events |= EPOLLOUT;
+    }
+    if (events == connection->events) {
+        return;
+    }
+    epoll_event event;
+    std::memset(&event, 0, sizeof(event));
+    event.events = events;
+    event.data.fd = connection->fd;
+    ::epoll_ctl(m_epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+    connection->events = events;
+}
+
+Session *GameServer::findSession(const Connection *connection, std::uint32_t id)
+{
+    const std::uint32_t slot = id & kSlotMask;
+    if (slot >= m_sessions.size()) {
+        return nullptr;
+    }
+    Session &session = m_sessions[slot];
+    if (session.owner != connection->fd || session.generation != (id >> kSlotBits)) {
+        return nullptr;
+    }
+    return &session;
+}
+
+std::uint32_t GameServer::createSession(Connection *connection)
+{
+    if (m_activeSessions >= m_options.maxSessions) {
+        return 0;
+    }
+    std::uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        slot = static_cast<std::uint32_t>(m_sessions.size());
+        m_sessions.emplace_back();
+    }
+    Session &session = m_sessions[slot];
+    // 代号从 1 开始，所以会话号不会是 0
+    session.generation = session.generation % kMaxGeneration + 1;
+    session.owner = connection->fd;
+    const std::uint32_t id = (session.generation << kSlotBits) | slot;
+    connection->sessions.push_back(id);
+
+    ++m_activeSessions;
+    ++m_createdSessions;
+    m_peakSessions = std::max(m_peakSessions, m_activeSessions);
+    return id;
+}
+
+void GameServer::closeSession(std::uint32_t id)
+{
+    Session &session = m_sessions[id & kSlotMask];
+    session.owner = -1;
+    m_freeSlots.push_back(id & kSlotMask);
+    --m_activeSessions;
+}
+
+void GameServer::report(double elapsed)
+{
+    const double seconds = m_options.reportInterval;
+    std::printf("[%8.1f s] sessions %d  connections %d  requests/s %.0f  moves/s %.0f  "
+                "latency p50 %.1f us  p99 %.1f us\n",
+                elapsed, m_activeSessions, m_activeConnections, m_interval.requests / seconds,
+                m_interval.moves / seconds, m_interval.latency.quantile(0.50) / 1000,
+                m_interval.latency.quantile(0.99) / 1000);
+    std::fflush(stdout);
+
+    m_total.requests += m_interval.requests;
+    m_total.moves += m_interval.moves;
+    m_total.latency.merge(m_interval.latency);
+    m_interval.clear();
+}
+
+void GameServer::printSummary(double elapsed)
+{
+    m_total.requests += m_interval.requests;
+    m_total.moves += m_interval.moves;
+    m_total.latency.merge(m_interval.latency);
+    m_interval.clear();
+
+    std::printf("\ntime         %.3f s\n", elapsed);
+    std::printf("connections  %llu accepted\n", static_cast<unsigned long long>(m_acceptedConnections));
+    std::printf("sessions     %llu created (peak %d)\n", static_cast<unsigned long long>(m_createdSessions),
+                m_peakSessions);
+    std::printf("requests     %llu (%.0f/s)\n", static_cast<unsigned long long>(m_total.requests),
+                m_total.requests / elapsed);
+    std::printf("moves        %llu (%.0f/s)\n", static_cast<unsigned long long>(m_total.moves),
+                m_total.moves / elapsed);
+    // 服务器端延迟：从读到请求到响应交给内核，不包括网络和客户端排队
+    std::printf("latency      p50 %.1f us  p99 %.1f us  max %.1f us\n", m_total.latency.quantile(0.50) / 1000,
+                m_total.latency.quantile(0.99) / 1000, m_total.latency.max() / 1000);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!options.seeded) {
+        options.seed = std::random_device()();
+    }
+
+    std::signal(SIGINT, handleSignal);
+    std::signal(SIGTERM, handleSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    GameServer server(options);
+    std::string error;
+    if (!server.listen(&error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    if (options.unixPath.empty()) {
+        std::printf("listening on 127.0.0.1:%d", options.port);
+    } else {
+        std::printf("listening on %s", options.unixPath.c_str());
+    }
+    std::printf(" (up to %d sessions, seed %llu)\n", options.maxSessions,
+                static_cast<unsigned long long>(options.seed));
+    std::fflush(stdout);
+
+    if (!server.run(&error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+# 本机套接字上的对局服务器：单线程 epoll 事件循环承载大量会话，不链接任何 Qt 模块。
+# 只支持 Linux
+TEMPLATE = app
+TARGET = 2048server
+
+CONFIG += console c++17
+CONFIG -= qt app_bundle
+
+!linux: error("2048server needs Linux (epoll)")
+
+include(../../engine/engine.pri)
+
+SOURCES += \
+    main.cpp
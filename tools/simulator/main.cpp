@@ -0,0 +1,686 @@
+#include "endgametable.h"
+#include "expectimax.h"
+#include "gamecore.h"
+#include "gamejournal.h"
+#include "gamestatistics.h"
+#include "montecarlo.h"
+#include "ntuplenetwork.h"
+#include "perfcounters.h"
+#include "policy.h"
+#include "transpositiontable.h"
+#include "workstealingpool.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options
+{
+    long long games = 1000;
+    std::string policy = "random";
+    std::string scriptFile;
+    std::uint64_t seed = 0;
+    bool seeded = false;
+    GameCore::MoveKernel kernel = GameCore::MoveKernel::LookupTable;
+    ExpectimaxSearch::Settings search;
+    MonteCarloPolicy::Settings monteCarlo;
+    int threads = 0;
+    long long batch = 16;
+    int boardSize = BoardState::Size;
+    int boardThreads = 1;
+    // 每局最多移动的步数，0 表示下到游戏结束（大棋盘的对局可能非常长）
+    int maxMoves = 0;
+    bool scaling = false;
+    std::vector<Policy::Direction> script;
+    std::string weightsFile;
+    std::string endgameFile;
+    std::string journalFile;
+    std::string traceFile;
+    // 大于 0 时所有 expectimax 工作线程共享一张这么多 MB 的置换表
+    long long sharedTableMegabytes = 0;
+    TranspositionTable::Replacement replacement = TranspositionTable::Replacement::DepthPreferred;
+    // 非空时每隔 statsInterval 秒追加一行汇总快照（JSON Lines）
+    std::string statsFile;
+    double statsInterval = 10;
+    // 非空时所有对局写入该日志文件
+    JournalFile *journal = nullptr;
+    // 只读映射的网络，所有工作线程共享
+    const NTupleNetwork *network = nullptr;
+    // 只读映射的残局表，所有工作线程共享
+    const EndgameTable *endgame = nullptr;
+    // --shared-table 的置换表，无锁，所有工作线程共享
+    TranspositionTable *sharedTable = nullptr;
+};
+
+// 每个工作线程独占的引擎、策略和流式统计，对齐到缓存行避免伪共享。
+// 统计的锁只在写快照时与工作线程竞争
+struct alignas(64) Worker
+{
+    GameCore game;
+    std::unique_ptr<Policy> policy;
+    std::unique_ptr<GameJournalWriter> journal;
+    std::mutex statisticsMutex;
+    GameStatistics statistics;
+};
+
+struct RunResult
+{
+    GameStatistics statistics;
+    double seconds = 0;
+    std::uint64_t steals = 0;
+    std::uint64_t searchNodes = 0;
+    double searchSeconds = 0;
+    std::uint64_t searchDecisions = 0;
+    MonteCarloPolicy::Statistics monteCarlo;
+    std::uint64_t endgameMoves = 0;
+};
+
+void printUsage(const char *program)
+{
+    std::printf("Usage: %s [options]\n"
+                "  --games N           number of games to play (default 1000)\n"
+                "  --policy NAME       random | greedy | script | expectimax | mc | ntuple |\n"
+                "                      endgame (default random)\n"
+                "  --script FILE       move script for --policy script (U/D/L/R)\n"
+                "  --depth N           expectimax search depth in moves (default 3)\n"
+                "  --cutoff P          expectimax probability cutoff (default 0.0001)\n"
+                "  --shared-table MB   share one lock-free transposition table of MB megabytes\n"
+                "                      between the expectimax workers; results then depend\n"
+                "                      on thread timing (default: one table per worker)\n"
+                "  --replacement NAME  always | depth, replacement policy of --shared-table\n"
+                "                      (default depth)\n"
+                "  --weights FILE      n-tuple weights for --policy ntuple; also used as the\n"
+                "                      expectimax evaluator when given\n"
+                "  --endgame FILE      endgame table for --policy endgame; positions outside\n"
+                "                      the table are played greedily\n"
+                "  --rollouts K        mc rollouts per direction (default 100)\n"
+                "  --rollout-moves N   mc rollout length limit, 0 = play to the end (default 0)\n"
+                "  --rollout-threads N mc rollout threads per game, 0 = all cores (default 1)\n"
+                "  --seed N            base random seed (default: random)\n"
+                "  --journal FILE      record every game to a binary journal\n"
+                "  --stats FILE        append a JSON summary line to FILE every --stats-interval\n"
+                "                      seconds and at the end of the run\n"
+                "  --stats-interval S  seconds between --stats snapshots (default 10)\n"
+                "  --trace FILE        write a Chrome trace of the run (needs a build with\n"
+                "                      CONFIG+=perf_counters)\n"
+                "  --kernel NAME       table | reference (default table)\n"
+                "  --size N            board size N x N, 2-4096 (default 4); sizes other\n"
+                "                      than 4 support the random, greedy, script and\n"
+                "                      endgame policies\n"
+                "  --board-threads N   threads moving the rows of one large board,\n"
+                "                      0 = all cores (default 1)\n"
+                "  --max-moves N       stop each game after N moves, 0 = play to the end\n"
+                "                      (default 0)\n"
+                "  --threads N         worker threads (default: all cores)\n"
+                "  --batch N           games per work-stealing batch (default 16)\n"
+                "  --scaling           also run with 1, 2, 4, ... threads and report speedup\n"
+                "  --help              show this help\n",
+                program);
+}
+
+bool parseOptions(int argc, char *argv[], Options *options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage(argv[0]);
+            std::exit(0);
+        } else if (std::strcmp(arg, "--games") == 0 && hasValue) {
+            options->games = std::atoll(argv[++i]);
+        } else if (std::strcmp(arg, "--policy") == 0 && hasValue) {
+            options->policy = argv[++i];
+        } else if (std::strcmp(arg, "--script") == 0 && hasValue) {
+            options->scriptFile = argv[++i];
+        } else if (std::strcmp(arg, "--depth") == 0 && hasValue) {
+            options->search.depth = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--cutoff") == 0 && hasValue) {
+            options->search.probabilityCutoff = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--shared-table") == 0 && hasValue) {
+            options->sharedTableMegabytes = std::atoll(argv[++i]);
+        } else if (std::strcmp(arg, "--replacement") == 0 && hasValue) {
+            const std::string replacement = argv[++i];
+            if (replacement == "always") {
+                options->replacement = TranspositionTable::Replacement::Always;
+            } else if (replacement == "depth") {
+                options->replacement = TranspositionTable::Replacement::DepthPreferred;
+            } else {
+                std::fprintf(stderr, "unknown replacement policy: %s\n", replacement.c_str());
+                return false;
+            }
+        } else if (std::strcmp(arg, "--weights") == 0 && hasValue) {
+            options->weightsFile = argv[++i];
+        } else if (std::strcmp(arg, "--endgame") == 0 && hasValue) {
+            options->endgameFile = argv[++i];
+        } else if (std::strcmp(arg, "--rollouts") == 0 && hasValue) {
+            options->monteCarlo.rolloutsPerMove = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--rollout-moves") == 0 && hasValue) {
+            options->monteCarlo.maxRolloutMoves = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--rollout-threads") == 0 && hasValue) {
+            options->monteCarlo.threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+            options->seed = std::strtoull(argv[++i], nullptr, 10);
+            options->seeded = true;
+        } else if (std::strcmp(arg, "--threads") == 0 && hasValue) {
+            options->threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--batch") == 0 && hasValue) {
+            options->batch = std::atoll(argv[++i]);
+        } else if (std::strcmp(arg, "--size") == 0 && hasValue) {
+            options->boardSize = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--board-threads") == 0 && hasValue) {
+            options->boardThreads = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--max-moves") == 0 && hasValue) {
+            options->maxMoves = std::max(0, std::atoi(argv[++i]));
+        } else if (std::strcmp(arg, "--scaling") == 0) {
+            options->scaling = true;
+        } else if (std::strcmp(arg, "--journal") == 0 && hasValue) {
+            options->journalFile = argv[++i];
+        } else if (std::strcmp(arg, "--stats") == 0 && hasValue) {
+            options->statsFile = argv[++i];
+        } else if (std::strcmp(arg, "--stats-interval") == 0 && hasValue) {
+            options->statsInterval = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--trace") == 0 && hasValue) {
+            options->traceFile = argv[++i];
+        } else if (std::strcmp(arg, "--kernel") == 0 && hasValue) {
+            const std::string kernel = argv[++i];
+            if (kernel == "table") {
+                options->kernel = GameCore::MoveKernel::LookupTable;
+            } else if (kernel == "reference") {
+                options->kernel = GameCore::MoveKernel::Reference;
+            } else {
+                std::fprintf(stderr, "unknown kernel: %s\n", kernel.c_str());
+                return false;
+            }
+        } else {
+            std::fprintf(stderr, "unknown or incomplete option: %s\n", arg);
+            return false;
+        }
+    }
+
+    if (options->games <= 0) {
+        std::fprintf(stderr, "--games must be positive\n");
+        return false;
+    }
+    if (options->threads < 0 || options->batch <= 0) {
+        std::fprintf(stderr, "--threads must not be negative and --batch must be positive\n");
+        return false;
+    }
+    if (options->search.depth < 1) {
+        std::fprintf(stderr, "--depth must be at least 1\n");
+        return false;
+    }
+    if (options->sharedTableMegabytes < 0
+            || (options->sharedTableMegabytes > 0 && options->policy != "expectimax")) {
+        std::fprintf(stderr, "--shared-table must not be negative and needs --policy expectimax\n");
+        return false;
+    }
+    if (options->boardSize < BoardEngine::MinSize || options->boardSize > BoardEngine::MaxSize
+            || options->boardThreads < 0) {
+        std::fprintf(stderr, "--size must be between %d and %d, --board-threads must not be negative\n",
+                     BoardEngine::MinSize, BoardEngine::MaxSize);
+        return false;
+    }
+    if (options->statsInterval <= 0) {
+        std::fprintf(stderr, "--stats-interval must be positive\n");
+        return false;
+    }
+    if (!options->traceFile.empty() && !PerfCounters::CompiledIn) {
+        std::fprintf(stderr, "--trace needs a build with CONFIG+=perf_counters\n");
+        return false;
+    }
+    if (options->boardSize != BoardState::Size) {
+        if (options->policy != "random" && options->policy != "greedy" && options->policy != "script"
+                && options->policy != "endgame") {
+            std::fprintf(stderr, "--policy %s only supports 4x4 boards\n", options->policy.c_str());
+            return false;
+        }
+        if (!options->journalFile.empty()) {
+            std::fprintf(stderr, "--journal only supports 4x4 boards\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool loadScript(Options *options)
+{
+    std::ifstream file(options->scriptFile);
+    if (!file) {
+        std::fprintf(stderr, "cannot open script file: %s\n", options->scriptFile.c_str());
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    std::string error;
+    if (!ScriptedPolicy::parse(text.str(), &options->script, &error)) {
+        std::fprintf(stderr, "%s: %s\n", options->scriptFile.c_str(), error.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<Policy> createPolicy(const Options &options, std::uint64_t seed)
+{
+    if (options.policy == "random") {
+        return std::unique_ptr<Policy>(new RandomPolicy(seed));
+    }
+    if (options.policy == "greedy") {
+        return std::unique_ptr<Policy>(new GreedyPolicy);
+    }
+    if (options.policy == "expectimax") {
+        ExpectimaxPolicy *policy = new ExpectimaxPolicy(options.search, options.network);
+        policy->setTranspositionTable(options.sharedTable);
+        return std::unique_ptr<Policy>(policy);
+    }
+    if (options.policy == "ntuple") {
+        if (!options.network) {
+            std::fprintf(stderr, "--policy ntuple needs --weights\n");
+            return nullptr;
+        }
+        return std::unique_ptr<Policy>(new NTuplePolicy(options.network));
+    }
+    if (options.policy == "mc") {
+        return std::unique_ptr<Policy>(new MonteCarloPolicy(options.monteCarlo, seed));
+    }
+    if (options.policy == "script") {
+        return std::unique_ptr<Policy>(new ScriptedPolicy(options.script));
+    }
+    if (options.policy == "endgame") {
+        if (!options.endgame) {
+            std::fprintf(stderr, "--policy endgame needs --endgame\n");
+            return nullptr;
+        }
+        return std::unique_ptr<Policy>(new EndgamePolicy(options.endgame));
+    }
+
+    std::fprintf(stderr, "unknown policy: %s\n", options.policy.c_str());
+    return nullptr;
+}
+
+void printPerfCounters()
+{
+    const PerfCounters::Totals totals = PerfCounters::totals();
+    const std::uint64_t attempted = totals[PerfCounters::MovesAttempted];
+    const std::uint64_t applied = totals[PerfCounters::MovesApplied];
+    const std::uint64_t spawns = totals[PerfCounters::Spawns];
+
+    std::printf("\nperf counters\n");
+    std::printf("  moves attempted  %llu\n", static_cast<unsigned long long>(attempted));
+    std::printf("  moves applied    %llu (%.2f%%)\n", static_cast<unsigned long long>(applied),
+                attempted > 0 ? 100.0 * applied / attempted : 0.0);
+    std::printf("  merges/move      %.3f\n", applied > 0 ? double(totals[PerfCounters::Merges]) / applied : 0.0);
+    std::printf("  merge histogram ");
+    for (int i = 0; i < PerfCounters::MergeBuckets; ++i) {
+        std::printf(" %d:%.1f%%", i, applied > 0 ? 100.0 * totals.mergeHistogram[i] / applied : 0.0);
+    }
+    std::printf("\n");
+    std::printf("  spawns           %llu\n", static_cast<unsigned long long>(spawns));
+    std::printf("  canMove calls    %llu\n", static_cast<unsigned long long>(totals[PerfCounters::CanMoveCalls]));
+    // 计时是抽样的，包含读时间戳本身的开销
+    std::printf("  ns/move kernel   %.2f (1/%u sampled)\n",
+                PerfCounters::meanNanoseconds(totals, PerfCounters::MoveTicks), PerfCounters::TimerSampleInterval);
+    std::printf("  ns/spawn         %.2f (1/%u sampled)\n",
+                PerfCounters::meanNanoseconds(totals, PerfCounters::SpawnTicks), PerfCounters::TimerSampleInterval);
+}
+
+void printReport(const GameStatistics &statistics, double seconds)
+{
+    const double games = static_cast<double>(statistics.games());
+    std::printf("games      %llu\n", static_cast<unsigned long long>(statistics.games()));
+    std::printf("moves      %llu\n", static_cast<unsigned long long>(statistics.totalMoves()));
+    std::printf("time       %.3f s\n", seconds);
+    std::printf("games/sec  %.1f\n", games / seconds);
+    std::printf("moves/sec  %.1f\n", statistics.totalMoves() / seconds);
+
+    // 分位数来自草图，相对误差不超过 QuantileSketch::RelativeAccuracy
+    const RunningMoments &score = statistics.score();
+    std::printf("\nscore\n");
+    std::printf("  mean     %.1f\n", score.mean());
+    std::printf("  stddev   %.1f\n", score.standardDeviation());
+    std::printf("  min      %.0f\n", score.min());
+    std::printf("  p25      %.0f\n", statistics.scoreQuantile(0.25));
+    std::printf("  median   %.0f\n", statistics.scoreQuantile(0.50));
+    std::printf("  p75      %.0f\n", statistics.scoreQuantile(0.75));
+    std::printf("  p90      %.0f\n", statistics.scoreQuantile(0.90));
+    std::printf("  p99      %.0f\n", statistics.scoreQuantile(0.99));
+    std::printf("  max      %.0f\n", score.max());
+
+    const RunningMoments &moves = statistics.moves();
+    std::printf("\nmoves/game\n");
+    std::printf("  mean     %.1f\n", moves.mean());
+    std::printf("  stddev   %.1f\n", moves.standardDeviation());
+    std::printf("  min      %.0f\n", moves.min());
+    std::printf("  max      %.0f\n", moves.max());
+    std::printf("  ms/game  %.3f (max %.3f)\n", 1000 * statistics.seconds().mean(), 1000 * statistics.seconds().max());
+
+    std::printf("\nmax tile\n");
+    for (int exponent = 0; exponent < GameStatistics::MaxExponent; ++exponent) {
+        const std::uint64_t count = statistics.maxTileCount(exponent);
+        if (count > 0) {
+            std::printf("  %6llu   %10llu  %6.2f%%\n", 1ULL << exponent, static_cast<unsigned long long>(count),
+                        100.0 * count / games);
+        }
+    }
+    std::printf("\nreached\n");
+    for (int tile : {2048, 4096, 8192}) {
+        std::printf("  %6d   %6.2f%%\n", tile, 100.0 * statistics.reachRate(tile));
+    }
+}
+
+// 合并所有工作线程的统计
+GameStatistics mergeStatistics(std::vector<Worker> &workers)
+{
+    GameStatistics total;
+    for (Worker &worker : workers) {
+        std::lock_guard<std::mutex> lock(worker.statisticsMutex);
+        total.merge(worker.statistics);
+    }
+    return total;
+}
+
+// statsFile 为空时不写快照
+// stats 非空时追加 JSON 快照行，文件由调用者打开并检查写入结果
+RunResult runSimulation(const Options &options, int threadCount, std::FILE *stats)
+{
+    WorkStealingPool pool(threadCount);
+    std::vector<Worker> workers(pool.threadCount());
+    for (int i = 0; i < pool.threadCount(); ++i) {
+        workers[i].policy = createPolicy(options, options.seed);
+        workers[i].game.setMoveKernel(options.kernel);
+        workers[i].game.setBoardSize(options.boardSize, options.boardThreads);
+        if (options.journal) {
+            workers[i].journal.reset(new GameJournalWriter(options.journal));
+            workers[i].game.setJournal(workers[i].journal.get());
+        }
+    }
+
+    // 每一轮（包括 --scaling 的各轮）都从空表开始
+    if (options.sharedTable) {
+        options.sharedTable->clear();
+        options.sharedTable->resetStatistics();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto elapsed = [&start]() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // 快照线程定期合并各线程的统计并追加一行，内存占用与对局数无关
+    std::mutex reporterMutex;
+    std::condition_variable reporterWake;
+    bool finished = false;
+    std::thread reporter;
+    if (stats) {
+        reporter = std::thread([&]() {
+            const auto interval = std::chrono::duration<double>(options.statsInterval);
+            std::unique_lock<std::mutex> lock(reporterMutex);
+            while (!reporterWake.wait_for(lock, interval, [&finished]() { return finished; })) {
+                const std::string line = mergeStatistics(workers).toJson(elapsed());
+                std::fprintf(stats, "%s\n", line.c_str());
+                std::fflush(stats);
+            }
+        });
+    }
+
+    pool.run(static_cast<std::size_t>(options.games), static_cast<std::size_t>(options.batch),
+             [&options, &workers](int index, std::size_t begin, std::size_t end) {
+        Worker &worker = workers[index];
+        for (std::size_t i = begin; i < end; ++i) {
+            PERF_TRACE_SCOPE("game");
+            // 每局的随机数序列只取决于基础种子和对局编号，与线程数和调度无关
+            worker.game.seed(options.seed, i);
+            worker.game.newGame();
+            worker.policy->reset(CounterRng::mix(~options.seed, i));
+            const auto gameStart = std::chrono::steady_clock::now();
+            while (!worker.game.isGameOver()
+                   && (options.maxMoves == 0 || worker.game.moveCount() < options.maxMoves)) {
+                worker.game.move(worker.policy->chooseMove(worker.game));
+            }
+            const double gameSeconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - gameStart).count();
+            // 共享表没有统一的搜索起点，每结束一局让表项老化一次，否则表会被早已结束的对局占满
+            if (options.sharedTable) {
+                options.sharedTable->newSearch();
+            }
+            std::lock_guard<std::mutex> lock(worker.statisticsMutex);
+            worker.statistics.add(worker.game.score(), worker.game.maxTile(), worker.game.moveCount(), gameSeconds);
+        }
+    });
+
+    for (Worker &worker : workers) {
+        if (worker.journal) {
+            worker.journal->flush();
+        }
+    }
+
+    RunResult run;
+    run.seconds = elapsed();
+    run.steals = pool.steals();
+    run.statistics = mergeStatistics(workers);
+    if (stats) {
+        {
+            std::lock_guard<std::mutex> lock(reporterMutex);
+            finished = true;
+        }
+        reporterWake.notify_all();
+        reporter.join();
+        std::fprintf(stats, "%s\n", run.statistics.toJson(run.seconds).c_str());
+    }
+    for (const Worker &worker : workers) {
+        if (const ExpectimaxPolicy *search = dynamic_cast<const ExpectimaxPolicy *>(worker.policy.get())) {
+            run.searchNodes += search->totalNodes();
+            run.searchSeconds += search->totalSeconds();
+            run.searchDecisions += search->decisions();
+        }
+        if (const MonteCarloPolicy *monteCarlo = dynamic_cast<const MonteCarloPolicy *>(worker.policy.get())) {
+            const MonteCarloPolicy::Statistics &statistics = monteCarlo->statistics();
+            run.monteCarlo.decisions += statistics.decisions;
+            run.monteCarlo.rollouts += statistics.rollouts;
+            run.monteCarlo.rolloutMoves += statistics.rolloutMoves;
+            run.monteCarlo.totalSeconds += statistics.totalSeconds;
+            run.monteCarlo.maxDecisionSeconds = std::max(run.monteCarlo.maxDecisionSeconds,
+                                                         statistics.maxDecisionSeconds);
+        }
+        if (const EndgamePolicy *endgame = dynamic_cast<const EndgamePolicy *>(worker.policy.get())) {
+            run.endgameMoves += endgame->tableMoves();
+        }
+    }
+    return run;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!options.seeded) {
+        options.seed = std::random_device()();
+    }
+    if (options.policy == "script" && !loadScript(&options)) {
+        return 1;
+    }
+
+    NTupleNetwork network;
+    if (!options.weightsFile.empty()) {
+        std::string error;
+        if (!network.mapFile(options.weightsFile, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        options.network = &network;
+    }
+    EndgameTable endgame;
+    if (!options.endgameFile.empty()) {
+        std::string error;
+        if (!endgame.mapFile(options.endgameFile, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        if (endgame.boardSize() != options.boardSize) {
+            std::fprintf(stderr, "endgame table is for %dx%d boards, use --size %d\n", endgame.boardSize(),
+                         endgame.boardSize(), endgame.boardSize());
+            return 1;
+        }
+        options.endgame = &endgame;
+    }
+    JournalFile journal;
+    if (!options.journalFile.empty()) {
+        std::string error;
+        if (!journal.open(options.journalFile, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        if (options.scaling) {
+            std::fprintf(stderr, "--journal is ignored for the --scaling runs\n");
+        }
+    }
+    std::FILE *stats = nullptr;
+    if (!options.statsFile.empty()) {
+        stats = std::fopen(options.statsFile.c_str(), "a");
+        if (!stats) {
+            std::fprintf(stderr, "cannot open statistics file: %s: %s\n", options.statsFile.c_str(),
+                         std::strerror(errno));
+            return 1;
+        }
+    }
+    TranspositionTable sharedTable;
+    if (options.sharedTableMegabytes > 0) {
+        std::string error;
+        if (!sharedTable.resize(static_cast<std::size_t>(options.sharedTableMegabytes) << 20, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        sharedTable.setReplacement(options.replacement);
+        options.sharedTable = &sharedTable;
+    }
+    if (!createPolicy(options, 0)) {
+        return 1;
+    }
+
+    const int threadCount = WorkStealingPool(options.threads).threadCount();
+    double baseline = 0;
+    if (options.scaling) {
+        std::printf("threads  games/sec     speedup\n");
+        for (int threads = 1; threads < threadCount; threads *= 2) {
+            const RunResult run = runSimulation(options, threads, nullptr);
+            const double rate = run.statistics.games() / run.seconds;
+            if (threads == 1) {
+                baseline = rate;
+            }
+            std::printf("%7d  %12.1f  %6.2fx\n", threads, rate, rate / baseline);
+        }
+    }
+
+    options.journal = journal.isOpen() ? &journal : nullptr;
+    // 计数器和 trace 只覆盖正式的一轮
+    PerfCounters::reset();
+    if (!options.traceFile.empty()) {
+        PerfTrace::start();
+    }
+    const RunResult run = runSimulation(options, threadCount, stats);
+    PerfTrace::stop();
+    if (stats) {
+        // 快照行写满磁盘时 fprintf 只会置错误标志，最后的 fclose 也可能因刷新失败而出错
+        const bool failed = std::ferror(stats) != 0;
+        if (std::fclose(stats) != 0 || failed) {
+            std::fprintf(stderr, "cannot write statistics file: %s: %s\n", options.statsFile.c_str(),
+                         std::strerror(errno));
+            return 1;
+        }
+    }
+    if (journal.isOpen()) {
+        // 日志是为了重放，写不完整时不能当作成功
+        std::string error;
+        if (!journal.close(&error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+    if (options.scaling) {
+        const double rate = run.statistics.games() / run.seconds;
+        if (threadCount == 1) {
+            baseline = rate;
+        }
+        std::printf("%7d  %12.1f  %6.2fx\n\n", threadCount, rate, rate / baseline);
+    }
+
+    std::printf("policy     %s\n", options.policy.c_str());
+    std::printf("board      %dx%d\n", options.boardSize, options.boardSize);
+    std::printf("seed       %llu\n", static_cast<unsigned long long>(options.seed));
+    std::printf("threads    %d (batch %lld, %llu steals)\n", threadCount, options.batch,
+                static_cast<unsigned long long>(run.steals));
+    printReport(run.statistics, run.seconds);
+
+    if (run.searchDecisions > 0) {
+        std::printf("\nsearch (depth %d, cutoff %g)\n", options.search.depth, options.search.probabilityCutoff);
+        std::printf("  nodes        %llu\n", static_cast<unsigned long long>(run.searchNodes));
+        std::printf("  nodes/sec    %.0f\n", run.searchNodes / run.searchSeconds);
+        std::printf("  ms/decision  %.3f\n", 1000.0 * run.searchSeconds / run.searchDecisions);
+    }
+    if (options.sharedTable) {
+        const TranspositionTable::Statistics statistics = options.sharedTable->statistics();
+        std::printf("\nshared table (%llu MB, %s replacement, huge pages %s)\n",
+                    static_cast<unsigned long long>(options.sharedTable->memoryBytes() >> 20),
+                    TranspositionTable::replacementName(options.sharedTable->replacement()),
+                    options.sharedTable->usesHugePages() ? "advised" : "no");
+        std::printf("  probes       %llu\n", static_cast<unsigned long long>(statistics.probes));
+        std::printf("  hits         %llu (%.2f%%)\n", static_cast<unsigned long long>(statistics.hits),
+                    100.0 * statistics.hitRate());
+        std::printf("  misses       %llu (%llu in full buckets)\n",
+                    static_cast<unsigned long long>(statistics.misses()),
+                    static_cast<unsigned long long>(statistics.collisions));
+        std::printf("  stores       %llu (%llu overwrites, %llu rejected)\n",
+                    static_cast<unsigned long long>(statistics.stores),
+                    static_cast<unsigned long long>(statistics.overwrites),
+                    static_cast<unsigned long long>(statistics.rejected));
+    }
+    if (run.monteCarlo.decisions > 0) {
+        const MonteCarloPolicy::Statistics &statistics = run.monteCarlo;
+        std::printf("\nrollouts (K %d per direction)\n", options.monteCarlo.rolloutsPerMove);
+        std::printf("  rollouts         %llu\n", static_cast<unsigned long long>(statistics.rollouts));
+        std::printf("  rollouts/sec     %.0f\n", statistics.rolloutsPerSecond());
+        std::printf("  rollout moves/s  %.0f\n", statistics.rolloutMoves / statistics.totalSeconds);
+        std::printf("  ms/decision      %.3f (max %.3f)\n", 1000.0 * statistics.meanDecisionSeconds(),
+                    1000.0 * statistics.maxDecisionSeconds);
+    }
+    if (options.endgame) {
+        const std::uint64_t moves = run.statistics.totalMoves();
+        std::printf("\nendgame table (%dx%d, target %d)\n", options.endgame->boardSize(),
+                    options.endgame->boardSize(), 1 << options.endgame->targetExponent());
+        std::printf("  table moves  %llu (%.2f%%)\n", static_cast<unsigned long long>(run.endgameMoves),
+                    moves > 0 ? 100.0 * run.endgameMoves / moves : 0.0);
+    }
+    if (PerfCounters::CompiledIn) {
+        printPerfCounters();
+    }
+    if (!options.traceFile.empty()) {
+        std::string error;
+        if (!PerfTrace::writeChromeTrace(options.traceFile, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        std::printf("\ntrace      %s (%llu events, %llu dropped)\n", options.traceFile.c_str(),
+                    static_cast<unsigned long long>(PerfTrace::eventCount()),
+                    static_cast<unsigned long long>(PerfTrace::droppedEvents()));
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+# 无界面的批量对局模拟器，不链接任何 Qt 模块，可在没有显示器的 CI 机器上运行
+TEMPLATE = app
+TARGET = 2048sim
+
+CONFIG += console c++17
+CONFIG -= qt app_bundle
+CONFIG += thread
+
+unix: LIBS += -pthread
+
+include(../../engine/engine.pri)
+
+SOURCES += \
+    main.cpp
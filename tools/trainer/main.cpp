@@ -0,0 +1,137 @@
+#include "ntuplenetwork.h"
+#include "tdtrainer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace {
+
+struct Options
+{
+    long long games = 100000;
+    long long reportEvery = 10000;
+    TDTrainer::Settings settings;
+    std::uint64_t seed = 0;
+    bool seeded = false;
+    std::string input;
+    std::string output = "ntuple.weights";
+};
+
+void printUsage(const char *program)
+{
+    std::printf("Usage: %s [options]\n"
+                "  --games N        self-play games to train (default 100000)\n"
+                "  --report N       print statistics and save every N games (default 10000)\n"
+                "  --alpha A        learning rate (default 0.1)\n"
+                "  --lambda L       TD(lambda) trace parameter, 0 = online TD(0) (default 0)\n"
+                "  --threads N      training threads (default: all cores)\n"
+                "  --batch N        games per work-stealing batch (default 1)\n"
+                "  --seed N         base random seed (default: random)\n"
+                "  --in FILE        continue training from an existing weight file\n"
+                "  --out FILE       weight file to write (default ntuple.weights)\n"
+                "  --help           show this help\n",
+                program);
+}
+
+bool parseOptions(int argc, char *argv[], Options *options)
+{
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (std::strcmp(arg, "--help") == 0) {
+            printUsage(argv[0]);
+            std::exit(0);
+        } else if (std::strcmp(arg, "--games") == 0 && hasValue) {
+            options->games = std::atoll(argv[++i]);
+        } else if (std::strcmp(arg, "--report") == 0 && hasValue) {
+            options->reportEvery = std::atoll(argv[++i]);
+        } else if (std::strcmp(arg, "--alpha") == 0 && hasValue) {
+            options->settings.learningRate = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--lambda") == 0 && hasValue) {
+            options->settings.lambda = std::atof(argv[++i]);
+        } else if (std::strcmp(arg, "--threads") == 0 && hasValue) {
+            options->settings.threads = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--batch") == 0 && hasValue) {
+            options->settings.batchSize = std::atoi(argv[++i]);
+        } else if (std::strcmp(arg, "--seed") == 0 && hasValue) {
+            options->seed = std::strtoull(argv[++i], nullptr, 10);
+            options->seeded = true;
+        } else if (std::strcmp(arg, "--in") == 0 && hasValue) {
+            options->input = argv[++i];
+        } else if (std::strcmp(arg, "--out") == 0 && hasValue) {
+            options->output = argv[++i];
+        } else {
+            std::fprintf(stderr, "unknown or incomplete option: %s\n", arg);
+            return false;
+        }
+    }
+
+    if (options->games <= 0 || options->reportEvery <= 0) {
+        std::fprintf(stderr, "--games and --report must be positive\n");
+        return false;
+    }
+    if (options->settings.lambda < 0 || options->settings.lambda > 1) {
+        std::fprintf(stderr, "--lambda must be between 0 and 1\n");
+        return false;
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, &options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (!options.seeded) {
+        options.seed = std::random_device()();
+    }
+
+    NTupleNetwork network;
+    std::string error;
+    const bool ready = options.input.empty()
+            ? network.initialize(NTupleNetwork::defaultTuples(), &error)
+            : network.loadFile(options.input, &error);
+    if (!ready) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    TDTrainer trainer(&network, options.settings);
+    std::printf("weights %.1f MB, %d threads, alpha %g, lambda %g, seed %llu\n",
+                network.weightCount() * sizeof(float) / (1024.0 * 1024.0), trainer.threadCount(),
+                options.settings.learningRate, options.settings.lambda,
+                static_cast<unsigned long long>(options.seed));
+    std::printf("%12s %10s %12s %12s %10s %8s\n", "games", "games/s", "updates/s", "mean score", "max", "2048%");
+
+    TDTrainer::Statistics total;
+    for (long long done = 0; done < options.games;) {
+        const long long chunk = std::min(options.reportEvery, options.games - done);
+        const TDTrainer::Statistics statistics = trainer.train(static_cast<std::uint64_t>(chunk), options.seed);
+        done += chunk;
+        total.merge(statistics);
+        total.seconds += statistics.seconds;
+
+        std::printf("%12lld %10.1f %12.0f %12.1f %10d %7.2f%%\n", done, statistics.gamesPerSecond(),
+                    statistics.updatesPerSecond(), statistics.totalScore / statistics.games, statistics.maxScore,
+                    100.0 * statistics.reached2048 / statistics.games);
+        std::fflush(stdout);
+
+        if (!network.saveFile(options.output, &error)) {
+            std::fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    std::printf("\ntotal: %llu games in %.1f s, %.1f games/s, %.0f updates/s -> %s\n",
+                static_cast<unsigned long long>(total.games), total.seconds, total.gamesPerSecond(),
+                total.updatesPerSecond(), options.output.c_str());
+    return 0;
+}
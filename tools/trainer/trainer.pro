@@ -0,0 +1,14 @@
+# N 元组网络的多线程 TD 学习训练程序，不链接任何 Qt 模块
+TEMPLATE = app
+TARGET = 2048train
+
+CONFIG += console c++17
+CONFIG -= qt app_bundle
+CONFIG += thread
+
+unix: LIBS += -pthread
+
+include(../../engine/engine.pri)
+
+SOURCES += \
+    main.cpp